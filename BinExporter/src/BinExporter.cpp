@@ -1,13 +1,38 @@
 #include "BinExporter.h"
 
+#include "Checksum.h"
+#include "ConversionKernels.h"
+#include "IndexCodec.h"
+#include "Quantization.h"
+#include "Statistics.h"
+
 #include <actions/PluginTriggerAction.h>
 
+#include <Task.h>
+
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
 #include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <numeric>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 Q_PLUGIN_METADATA(IID "nl.tudelft.BinExporter")
@@ -15,9 +40,307 @@ Q_PLUGIN_METADATA(IID "nl.tudelft.BinExporter")
 using namespace mv;
 using namespace mv::gui;
 
+namespace {
+
+// The conversion kernels read and write bfloat16 values through their raw bits
+template <typename T>
+using KernelElementType = std::conditional_t<std::is_same_v<T, biovault::bfloat16_t>, BFloat16, T>;
+
+static_assert(sizeof(biovault::bfloat16_t) == sizeof(BFloat16), "bfloat16 layouts differ");
+
+template <typename T>
+constexpr ElementType getPointDataElementType()
+{
+    if constexpr (std::is_same_v<T, biovault::bfloat16_t>)
+        return ElementType::BFloat16;
+    else
+        return getElementType<T>();
+}
+
+// Bytes per write when streaming a data set to disk
+constexpr std::size_t writeBlockSize = std::size_t(64) << 20;
+
+// Recursively searches for the element type that is named typeName and calls visitor with a null pointer of that type
+template <unsigned N = 0, typename Visitor>
+bool visitElementTypeByName(const QString& typeName, Visitor&& visitor)
+{
+    if constexpr (N < PointData::getNumberOfSupportedElementTypes())
+    {
+        if (typeName == QLatin1String(std::get<N>(PointData::getElementTypeNames())))
+        {
+            visitor(static_cast<PointData::ElementTypeAt<N>*>(nullptr));
+            return true;
+        }
+
+        return visitElementTypeByName<N + 1>(typeName, visitor);
+    }
+    else
+    {
+        return false;
+    }
+}
+
+FileHeader createFileHeader(ElementType elementType, std::uint64_t numRows, std::uint64_t numColumns)
+{
+    FileHeader header;
+    header.elementType  = elementType;
+    header.byteOrder    = getNativeByteOrder();
+    header.numColumns   = std::max<std::uint64_t>(numColumns, 1);
+    header.numRows      = numRows;
+    header.dataSize     = header.numRows * header.numColumns * getElementSize(elementType);
+
+    return header;
+}
+
+void writeFileHeader(std::ostream& fout, ElementType elementType, std::uint64_t numRows, std::uint64_t numColumns)
+{
+    const auto headerBytes = serializeFileHeader(createFileHeader(elementType, numRows, numColumns));
+    fout.write(headerBytes.data(), headerBytes.size());
+}
+
+// Appends the sections that follow the data and rewrites the header at the start of the file to point to them:
+// the block index of block-compressed data, the scales and offsets of quantized data, the statistics of the values
+// and the checksums of the blocks
+void writeSections(std::ostream& fout, FileHeader header, const BlockIndex* blockIndex, const QuantizationTable* quantizationTable, const std::vector<ColumnStatistics>* statistics, const BlockChecksums* checksums)
+{
+    const auto appendSection = [&fout, &header](SectionType type, const std::vector<char>& sectionBytes) {
+        header.sections.push_back({ static_cast<std::uint32_t>(type), static_cast<std::uint64_t>(fout.tellp()), sectionBytes.size() });
+
+        fout.write(sectionBytes.data(), sectionBytes.size());
+    };
+
+    if (blockIndex)
+    {
+        header.flags    |= FileFlags::BlockCompressed;
+        header.dataSize  = blockIndex->blockOffsets.back();
+
+        appendSection(SectionType::BlockIndex, serializeBlockIndex(*blockIndex));
+    }
+
+    if (quantizationTable)
+    {
+        header.flags |= FileFlags::Quantized;
+
+        appendSection(SectionType::Quantization, serializeQuantizationTable(*quantizationTable));
+    }
+
+    if (statistics)
+        appendSection(SectionType::Statistics, serializeColumnStatistics(*statistics));
+
+    if (checksums)
+        appendSection(SectionType::Checksums, serializeBlockChecksums(*checksums));
+
+    const auto headerBytes = serializeFileHeader(header);
+
+    fout.seekp(0);
+    fout.write(headerBytes.data(), headerBytes.size());
+    fout.seekp(0, std::ios::end);
+}
+
+// Records gathering and writing of a file. Workers gather (and compress) blocks while the calling
+// thread writes them, so the time the writes waited for gathered blocks counts as gathering.
+void addWritePhases(OperationRecord& record, const PipelineStats& stats, double gatherSeconds, double writeSeconds, std::uint64_t rawBytes, std::uint64_t writtenBytes)
+{
+    PhaseMeasurement gather;
+    gather.name                 = "gather";
+    gather.seconds              = gatherSeconds;
+    gather.bytes                = rawBytes;
+    gather.numberOfThreads      = std::max<std::size_t>(1, stats.numberOfThreads);
+    gather.peakTransientBytes   = stats.bufferBytes;
+
+    PhaseMeasurement write;
+    write.name                  = "write";
+    write.seconds               = writeSeconds;
+    write.bytes                 = writtenBytes;
+
+    record.addPhase(gather);
+    record.addPhase(write);
+}
+
+// Appends the record of an export to the metrics file and the log
+void writeMetrics(const OperationRecord& record)
+{
+    const std::string line = record.toJsonLine();
+
+    qDebug().noquote() << "BinExporter:" << QString::fromStdString(line);
+
+    const auto metricsFilePath = getMetricsFilePath(std::filesystem::path((QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/BinIO/metrics.jsonl").toStdU16String()));
+
+    if (metricsFilePath.empty())
+        return;
+
+    try
+    {
+        appendLine(metricsFilePath, line);
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "BinExporter: Could not write the metrics:" << e.what();
+    }
+}
+
+// Writes count values in place, in blocks of writeBlockSize bytes of whole rows. With settings.statistics and
+// settings.checksums, worker threads read every block for its statistics and the checksums of its blocks of
+// settings.blockSize bytes, the same blocks as those of the block pipeline, before it is written.
+template <typename T>
+void writeElements(std::ostream& fout, const T* values, std::size_t count, std::size_t numColumns, const ChunkedWriteSettings& settings)
+{
+    const std::size_t rowSize               = sizeof(T) * std::max<std::size_t>(numColumns, 1);
+    const std::size_t rowsPerChecksumBlock  = std::max<std::size_t>(1, settings.blockSize / rowSize);
+    const std::size_t numRows               = count / std::max<std::size_t>(numColumns, 1);
+
+    // Write blocks hold whole checksum blocks
+    std::size_t rowsPerBlock = std::max<std::size_t>(1, writeBlockSize / rowSize);
+
+    if (settings.checksums)
+    {
+        rowsPerBlock = std::max<std::size_t>(1, rowsPerBlock / rowsPerChecksumBlock) * rowsPerChecksumBlock;
+
+        settings.checksums->blockSize   = rowsPerChecksumBlock * rowSize;
+        settings.checksums->dataSize    = numRows * rowSize;
+        settings.checksums->checksums.assign((numRows + rowsPerChecksumBlock - 1) / rowsPerChecksumBlock, 0);
+    }
+
+    const std::size_t numberOfThreads = resolveNumberOfThreads(settings.numberOfThreads);
+
+    for (std::size_t firstRow = 0; firstRow < numRows && fout; firstRow += rowsPerBlock)
+    {
+        const std::size_t numBlockRows  = std::min(rowsPerBlock, numRows - firstRow);
+        const T* const blockValues      = values + firstRow * numColumns;
+
+        if (settings.progress)
+            settings.progress->throwIfCancelled();
+
+        if (settings.statistics || settings.checksums)
+        {
+            const std::size_t numberOfChecksumBlocks = (numBlockRows + rowsPerChecksumBlock - 1) / rowsPerChecksumBlock;
+
+            forEachChunkInParallel(numberOfChecksumBlocks, numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>&) {
+                const std::size_t firstChunkRow = chunkIndex * rowsPerChecksumBlock;
+                const std::size_t numChunkRows  = std::min(rowsPerChecksumBlock, numBlockRows - firstChunkRow);
+                const T* const chunkValues      = blockValues + firstChunkRow * numColumns;
+
+                if (settings.statistics)
+                {
+                    StatisticsAccumulator accumulator(numColumns);
+                    accumulator.addRows(chunkValues, numChunkRows);
+
+                    settings.statistics->merge(accumulator);
+                }
+
+                if (settings.checksums)
+                    settings.checksums->checksums[(firstRow + firstChunkRow) / rowsPerChecksumBlock] = computeChecksum(reinterpret_cast<const char*>(chunkValues), numChunkRows * rowSize);
+            });
+        }
+
+        fout.write(reinterpret_cast<const char*>(blockValues), numBlockRows * rowSize);
+
+        if (settings.progress)
+            settings.progress->addBlock(numBlockRows * rowSize, numBlockRows);
+    }
+}
+
+// Gets the path of a file that describes the file at writePath, with the same name and another suffix, e.g. ".txt"
+QString getSidecarPath(const QString& writePath, const QString& suffix)
+{
+    const QFileInfo fileInfo(writePath);
+
+    return fileInfo.dir().filePath(fileInfo.completeBaseName() + suffix);
+}
+
+// Expands the {name} and {index} placeholders of the file name template for every data set. Characters that
+// are not allowed in file names are replaced, and names that are already taken get the index appended.
+QStringList expandFileNameTemplate(const QString& fileNameTemplate, const QStringList& dataSetNames)
+{
+    const QString pattern       = fileNameTemplate.isEmpty() ? QString("{name}.bin") : fileNameTemplate;
+    const int indexWidth        = static_cast<int>(QString::number(std::max<qsizetype>(dataSetNames.size() - 1, 0)).size());
+
+    QStringList fileNames;
+
+    for (qsizetype index = 0; index < dataSetNames.size(); index++)
+    {
+        const QString name      = QString(dataSetNames[index]).replace(QRegularExpression(R"([\\/:*?"<>|])"), "_");
+        const QString number    = QString("%1").arg(index, indexWidth, 10, QChar('0'));
+
+        QString fileName = QString(pattern).replace("{name}", name).replace("{index}", number);
+
+        if (fileNames.contains(fileName, Qt::CaseInsensitive))
+        {
+            const QFileInfo fileInfo(fileName);
+
+            fileName = fileInfo.completeBaseName() + "-" + number + (fileInfo.suffix().isEmpty() ? QString() : "." + fileInfo.suffix());
+        }
+
+        fileNames.append(fileName);
+    }
+
+    return fileNames;
+}
+
+// Set while a batch export runs the event loop, in which no other export may start
+bool isBatchExportRunning = false;
+
+// Data set of a batch export, written by one of the workers
+struct ExportItem
+{
+    // The progress is posted to receiver, whose pending calls must not outlive the item
+    ExportItem(QObject& receiver, std::uint64_t numRows) :
+        record("export"),
+        progress([this, &receiver, numRows](std::uint64_t bytesWritten, std::uint64_t rowsWritten) { reportProgress(receiver, numRows, bytesWritten, rowsWritten); }),
+        reportedPercentage(-1)
+    {
+    }
+
+    Dataset<Points>     dataset;            // Only used on the GUI thread, invalid once the data set was removed
+    Dataset<Points>     fullDataset;        // Data set that holds the values of a subset, likewise
+    QString             filePath;
+    DataContent         dataContent;        // Retrieved on the GUI thread, the worker only reads its values and indices
+    PhaseMeasurement    retrieve;           // Retrieving the data set, plus gathering the indices on the worker
+    OperationRecord     record;
+    WriteProgress       progress;
+    std::mutex          writing;            // Held by the worker while it writes, so that removing the data set can wait for it
+    std::atomic<int>    reportedPercentage; // Last percentage that was posted to the task
+    bool                written = false;
+
+private:
+    // Posts the progress to the task whenever another percent of the points is written, called on the workers
+    void reportProgress(QObject& receiver, std::uint64_t numRows, std::uint64_t bytesWritten, std::uint64_t rowsWritten)
+    {
+        const std::uint64_t totalRows   = std::max<std::uint64_t>(1, numRows);
+        const int percentage            = static_cast<int>(std::min<std::uint64_t>(100, 100 * rowsWritten / totalRows));
+
+        int previousPercentage = reportedPercentage.load();
+
+        while (percentage > previousPercentage)
+        {
+            if (reportedPercentage.compare_exchange_weak(previousPercentage, percentage))
+            {
+                QMetaObject::invokeMethod(&receiver, [this, percentage, bytesWritten, rowsWritten, totalRows]() -> void {
+                    // The task went with the data set when it was removed
+                    if (!dataset.isValid())
+                        return;
+
+                    auto& task = dataset->getTask();
+
+                    task.setProgress(static_cast<float>(percentage) / 100.0f);
+                    task.setProgressDescription(QString("Wrote %1 of %2 points (%3 MB)").arg(rowsWritten).arg(totalRows).arg(static_cast<double>(bytesWritten) / 1.0e6, 0, 'f', 1));
+                }, Qt::QueuedConnection);
+
+                break;
+            }
+        }
+    }
+};
+
+}
+
 BinExporter::BinExporter(const PluginFactory* factory) :
     WriterPlugin(factory),
-    _onlyIdices(false)
+    _onlyIdices(false),
+    _writeHeader(true),
+    _compress(false),
+    _quantizationBits(0),
+    _writeMethod(WriteMethod::Stream)
 {
 }
 
@@ -31,19 +354,56 @@ void BinExporter::init()
 
 void BinExporter::writeData()
 {
+    // Another export would run nested in the event loop of the batch export, on the data sets it writes
+    if (isBatchExportRunning)
+    {
+        qWarning() << "BinExporter: No data written to disk - Another export is running";
+        return;
+    }
+
+    const auto inputDatasets = getInputDatasets();
+
     // Let the user select one of those data sets
-    BinExporterDialog inputDialog(nullptr);
+    BinExporterDialog inputDialog(nullptr, inputDatasets.size() > 1, getSetting("FileNameTemplate", "{name}.bin").toString());
     
     inputDialog.setModal(true);
 
-    connect(&inputDialog, &BinExporterDialog::closeDialog, this, [this](bool onlyIdices) {
+    connect(&inputDialog, &BinExporterDialog::closeDialog, this, [this](bool onlyIdices, bool writeHeader, QString dataType, bool compress, unsigned int quantizationBits, WriteMethod writeMethod, QString fileNameTemplate) {
         _onlyIdices = onlyIdices;
+        _writeHeader = writeHeader;
+        _dataType = dataType;
+        _compress = compress;
+        _quantizationBits = quantizationBits;
+        _writeMethod = writeMethod;
+        _fileNameTemplate = fileNameTemplate;
+
+        // The block index lives in the v2 header, raw files cannot be compressed
+        if (_compress && !_writeHeader)
+        {
+            qWarning() << "BinExporter: Compression requires the BinIO v2 format - Data is written uncompressed";
+            _compress = false;
+        }
+
+        // So does the quantization table
+        if (_quantizationBits != 0 && !_writeHeader)
+        {
+            qWarning() << "BinExporter: Quantization requires the BinIO v2 format - Data is written unquantized";
+            _quantizationBits = 0;
+        }
     });
 
     int ok = inputDialog.exec();
 
     if ((ok == QDialog::Accepted)) {
 
+        // Several data sets share the dialog and the folder
+        if (inputDatasets.size() > 1)
+        {
+            setSetting("FileNameTemplate", _fileNameTemplate);
+            writeDataSets(inputDatasets);
+            return;
+        }
+
         // Let the user choose the save path
         QString registryEntry = "directoryPath";
         const auto directoryPath = getSetting(registryEntry, "").toString();
@@ -66,10 +426,25 @@ void BinExporter::writeData()
             // store the directory name
             setSetting(registryEntry, QFileInfo(fileName).absolutePath());
 
+            OperationRecord record("export");
+            const Stopwatch stopwatch;
+
             // get data from core
             DataContent dataContent = retrieveDataSetContent(inputDataset);
-            writeVecToBinary(dataContent.dataVals, fileName);
-            writeInfoTextForBinary(fileName, dataContent);
+
+            PhaseMeasurement retrieve;
+            retrieve.name       = "retrieve";
+            retrieve.seconds    = stopwatch.getSeconds();
+            retrieve.bytes      = dataContent.dataBytes.size();
+
+            record.addPhase(retrieve);
+
+            exportDataSet(fileName, dataContent, getWriteSettings(), record);
+
+            record.setSeconds(stopwatch.getSeconds());
+
+            writeMetrics(record);
+
             qDebug() << "BinExporter: Data written to disk - File name: " << fileName;
             return;
         }
@@ -81,48 +456,208 @@ void BinExporter::writeData()
     }
 }
 
-DataContent BinExporter::retrieveDataSetContent(mv::Dataset<Points> dataSet) const {
-    DataContent dataContent;
-    std::vector<float> dataFromSet;
+void BinExporter::writeDataSets(const mv::Datasets& datasets)
+{
+    // Let the user choose one folder for all data sets
+    QString registryEntry = "directoryPath";
 
-    // Get number of enabled dimensions
-    unsigned int numDimensions = dataSet->getNumDimensions();
+    const QString directoryPath = QFileDialog::getExistingDirectory(nullptr, tr("Export %1 data sets to").arg(datasets.size()), getSetting(registryEntry, "").toString());
 
-    if (_onlyIdices) // Instead of saving the data values, you might want to save the IDs of a selection
+    if (directoryPath.isEmpty())
     {
-        std::transform(dataSet->indices.begin(), dataSet->indices.end(), std::back_inserter(dataFromSet), [](int x) { return (float)x; });
-        dataContent.onlyIndices = true;
+        qDebug() << "BinExporter: No data written to disk - No folder selected";
+        return;
     }
-    else
+
+    setSetting(registryEntry, directoryPath);
+
+    QStringList dataSetNames;
+    for (const auto& dataset : datasets)
+        dataSetNames.append(dataset->text());
+
+    const QStringList fileNames = expandFileNameTemplate(_fileNameTemplate, dataSetNames);
+
+    // Data sets are written concurrently, each with an equal share of the threads and of the block buffer,
+    // so that all files together hold no more gathered blocks than a single export
+    const std::size_t numberOfThreads   = resolveNumberOfThreads(0);
+    const std::size_t numberOfFiles     = std::clamp<std::size_t>(static_cast<std::size_t>(datasets.size()), 1, std::max<std::size_t>(1, numberOfThreads / 2));
+
+    ChunkedWriteSettings fileSettings = getWriteSettings();
+
+    fileSettings.numberOfThreads    = std::max<std::size_t>(1, numberOfThreads / numberOfFiles);
+    fileSettings.bufferSize         = std::max<std::size_t>(1, fileSettings.bufferSize / numberOfFiles);
+
+    // Connects the data sets and their tasks to the items until the export is done, and receives their progress
+    QObject taskContext;
+
+    // The contents are retrieved from the core on the GUI thread, the workers only read the values and indices
+    std::vector<std::unique_ptr<ExportItem>> items;
+
+    for (qsizetype index = 0; index < datasets.size(); index++)
     {
-        // Get indices of selected points
-        std::vector<unsigned int> pointIDsGlobal = dataSet->indices;
-        // If points represent all data set, select them all
-        if (dataSet->isFull()) {
-            std::vector<unsigned int> all(dataSet->getNumPoints());
-            std::iota(std::begin(all), std::end(all), 0);
+        Dataset<Points> dataset = datasets[index];
 
-            pointIDsGlobal = all;
-        }
+        const Stopwatch stopwatch;
+
+        DataContent dataContent = retrieveDataSetContent(dataset, false);
+
+        const std::uint64_t numRows = dataContent.isFull ? dataContent.numPoints : dataContent.indices.size();
+
+        auto& task = dataset->getTask();
+
+        auto item = std::make_unique<ExportItem>(taskContext, numRows);
+
+        item->dataset           = dataset;
+        item->filePath          = QDir(directoryPath).filePath(fileNames[index]);
+        item->dataContent       = std::move(dataContent);
+        item->retrieve.name     = "retrieve";
+        item->retrieve.seconds  = stopwatch.getSeconds();
+
+        item->record.setField("batch", static_cast<std::uint64_t>(datasets.size()));
+
+        task.setName(QString("Exporting %1").arg(QFileInfo(item->filePath).fileName()));
+        task.setMayKill(true);
+        task.setRunning();
+
+        // The export of the data set stops at its next block
+        connect(&task, &Task::requestAbort, &taskContext, [progress = &item->progress]() -> void {
+            progress->cancel();
+        });
+
+        // So does the export of a data set that is removed, or whose values are, which waits until the worker let go of them
+        const auto cancelAndWait = [item = item.get()]() -> void {
+            item->progress.cancel();
+
+            const std::lock_guard<std::mutex> lock(item->writing);
+        };
 
-        // For all selected points, retrieve values from each dimension
-        dataFromSet.reserve(pointIDsGlobal.size() * numDimensions);
+        connect(&item->dataset, &Dataset<Points>::aboutToBeRemoved, &taskContext, cancelAndWait);
 
-        dataSet->visitFromBeginToEnd([&dataFromSet, &pointIDsGlobal, &numDimensions](auto beginOfData, auto endOfData)
+        if (!dataContent.isFull && !dataContent.onlyIndices)
         {
-            for (const auto& pointId : pointIDsGlobal)
+            item->fullDataset = dataset->getFullDataset<Points>();
+
+            connect(&item->fullDataset, &Dataset<Points>::aboutToBeRemoved, &taskContext, cancelAndWait);
+        }
+
+        items.push_back(std::move(item));
+    }
+
+    const Stopwatch stopwatch;
+
+    QThread* const thread = QThread::create([this, &items, &fileSettings, numberOfFiles]() -> void {
+        forEachChunkInParallel(items.size(), numberOfFiles, [this, &items, &fileSettings](std::size_t index, std::vector<char>&) -> void {
+            ExportItem& item = *items[index];
+
+            // Removing the data set waits until its export stopped
+            const std::lock_guard<std::mutex> lock(item.writing);
+
+            const Stopwatch itemStopwatch;
+
+            ChunkedWriteSettings settings = fileSettings;
+            settings.progress = &item.progress;
+
+            try
             {
-                for (unsigned int dimensionId = 0; dimensionId < numDimensions; dimensionId++)
+                item.progress.throwIfCancelled();
+
+                if (item.dataContent.onlyIndices)
+                {
+                    gatherIndices(item.dataContent);
+
+                    item.retrieve.seconds   += itemStopwatch.getSeconds();
+                    item.retrieve.bytes     = item.dataContent.dataBytes.size();
+                }
+
+                item.record.addPhase(item.retrieve);
+
+                item.written = exportDataSet(item.filePath, item.dataContent, settings, item.record);
+            }
+            catch (const std::exception& e)
+            {
+                item.record.setField("file", item.filePath.toStdString());
+                item.record.setField("status", item.progress.isCancelled() ? "cancelled" : "failed");
+
+                if (!item.progress.isCancelled())
                 {
-                    const auto index = pointId * numDimensions + dimensionId;
-                    dataFromSet.push_back(beginOfData[index]);
+                    qWarning() << "BinExporter: Writing" << item.filePath << "failed:" << e.what();
+                    item.record.setField("error", e.what());
                 }
             }
+
+            item.record.setSeconds(item.retrieve.seconds + itemStopwatch.getSeconds());
+        });
+    });
+
+    // Keep the GUI responsive and show the progress while the workers write
+    QEventLoop eventLoop;
+
+    connect(thread, &QThread::finished, &eventLoop, &QEventLoop::quit);
+
+    isBatchExportRunning = true;
+
+    thread->start();
+    eventLoop.exec();
+    thread->wait();
+
+    isBatchExportRunning = false;
+
+    delete thread;
+
+    std::size_t numberOfWritten = 0;
+
+    for (const auto& item : items)
+    {
+        if (item->written)
+            numberOfWritten++;
+
+        // Removed data sets took their tasks with them
+        if (item->dataset.isValid())
+        {
+            if (item->written)
+                item->dataset->getTask().setFinished();
+            else
+                item->dataset->getTask().setAborted();
+        }
+
+        writeMetrics(item->record);
+    }
+
+    qDebug() << "BinExporter:" << numberOfWritten << "of" << items.size() << "data sets written to" << directoryPath << "in" << stopwatch.getSeconds() << "s";
+}
+
+DataContent BinExporter::retrieveDataSetContent(mv::Dataset<Points> dataSet, bool withIndices) const {
+    DataContent dataContent;
+
+    // Get number of enabled dimensions
+    unsigned int numDimensions = dataSet->getNumDimensions();
+
+    if (_onlyIdices) // Instead of saving the data values, you might want to save the IDs of a selection
+    {
+        dataContent.indices         = dataSet->indices;
+        dataContent.numRawPoints    = dataSet->getNumRawPoints();
+        dataContent.onlyIndices     = true;
+
+        if (withIndices)
+            gatherIndices(dataContent);
+    }
+    else
+    {
+        // Data values are not gathered here but streamed from the data set, see writeDataSetToBinary
+        dataContent.isFull = dataSet->isFull();
+
+        // Subsets keep the indices of their points, which a data set may change once the export runs without the GUI thread
+        if (!dataContent.isFull)
+            dataContent.indices = dataSet->indices;
+
+        dataSet->visitFromBeginToEnd([&dataContent](auto beginOfData, auto endOfData) -> void {
+            using ElementTypeOfData = std::remove_cvref_t<decltype(*beginOfData)>;
+
+            dataContent.values = beginOfData != endOfData ? static_cast<const ElementTypeOfData*>(&*beginOfData) : static_cast<const ElementTypeOfData*>(nullptr);
         });
     }
 
     // Data content for writing to disk
-    dataContent.dataVals = dataFromSet;
     dataContent.numDimensions = numDimensions;
     dataContent.numPoints = dataSet->getNumPoints();
 
@@ -140,13 +675,275 @@ DataContent BinExporter::retrieveDataSetContent(mv::Dataset<Points> dataSet) con
     return dataContent;
 }
 
-template<typename T>
-void BinExporter::writeVecToBinary(std::vector<T> vec, QString writePath) {
-    std::ofstream fout(writePath.toStdString(), std::ofstream::out | std::ofstream::binary);
-    fout.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
-    fout.close();
+void BinExporter::gatherIndices(DataContent& dataContent) const {
+    // Raw files cannot describe an encoding, so they hold plain words
+    const std::optional<IndexEncoding> encoding = _compress && _writeHeader ? std::nullopt : std::optional<IndexEncoding>(IndexEncoding::Plain);
+
+    EncodedIndices encoded = encodeIndices(dataContent.indices.data(), dataContent.indices.size(), dataContent.numRawPoints, encoding);
+
+    dataContent.dataBytes   = std::move(encoded.bytes);
+    dataContent.elementType = encoded.elementType;
+    dataContent.numIndices  = encoded.numIndices;
+    dataContent.indexInfo   = encoded.info;
+
+    // The encoded indices replace the retrieved ones
+    std::vector<unsigned int>().swap(dataContent.indices);
+}
+
+bool BinExporter::exportDataSet(const QString& writePath, DataContent& dataContent, const ChunkedWriteSettings& settings, OperationRecord& record) {
+    record.setField("file", writePath.toStdString());
+    record.setField("compressed", !_compress ? "none" : (dataContent.onlyIndices ? getIndexEncodingName(dataContent.indexInfo.encoding) : "lz"));
+    record.setField("header", _writeHeader ? "v2" : "raw");
+    record.setField("write_method", getWriteMethodName(_writeMethod));
+    record.setField("content", _onlyIdices ? "indices" : "values");
+    record.setField("quantized", _onlyIdices || _quantizationBits == 0 ? "none" : (_quantizationBits == 8 ? "uint8" : "uint16"));
+
+    bool written;
+
+    if (dataContent.onlyIndices)
+        written = writeIndicesToBinary(dataContent, writePath, settings, record);
+    else
+        written = writeDataSetToBinary(writePath, dataContent, settings, record);
+
+    // Partly written files are removed, only complete files are described
+    if (written)
+    {
+        writeInfoTextForBinary(writePath, dataContent);
+        writeInfoJsonForBinary(writePath, dataContent);
+    }
+    else
+    {
+        std::error_code errorCode;
+        std::filesystem::remove(std::filesystem::path(writePath.toStdU16String()), errorCode);
+    }
+
+    record.setField("element_type", getElementTypeName(dataContent.elementType));
+    record.setField("statistics", dataContent.hasStatistics ? "header" : "none");
+    record.setField("checksums", dataContent.hasChecksums ? "xxh64" : "none");
+    record.setField("points", static_cast<std::uint64_t>(dataContent.onlyIndices ? dataContent.numIndices : (dataContent.isFull ? dataContent.numPoints : dataContent.indices.size())));
+    record.setField("dimensions", static_cast<std::uint64_t>(dataContent.onlyIndices ? 1 : dataContent.numDimensions));
+    record.setField("file_bytes", static_cast<std::uint64_t>(written ? QFileInfo(writePath).size() : 0));
+    record.setField("status", written ? "ok" : (settings.progress && settings.progress->isCancelled() ? "cancelled" : "failed"));
+
+    return written;
+}
+
+ChunkedWriteSettings BinExporter::getWriteSettings() const {
+    ChunkedWriteSettings settings;
+
+    if (_compress)
+    {
+        settings.codec  = BlockCodec::LZ;
+        settings.filter = BlockFilter::ByteShuffle;
+    }
+
+    return settings;
+}
+
+bool BinExporter::writeIndicesToBinary(const DataContent& dataContent, QString writePath, const ChunkedWriteSettings& settings, OperationRecord& record) {
+    const std::vector<char>& bytes = dataContent.dataBytes;
+
+    PipelineStats stats;
+
+    try
+    {
+        const auto file = openFileWriter(std::filesystem::path(writePath.toStdU16String()), _writeMethod);
+
+        FileWriter& fout = *file;
+
+        // The index info follows the data, so the header is complete before the data is written
+        const auto sectionBytes = serializeIndexInfo(dataContent.indexInfo);
+
+        if (_writeHeader)
+        {
+            FileHeader header = createFileHeader(dataContent.elementType, dataContent.numIndices, 1);
+            header.flags    |= FileFlags::Indices;
+            header.dataSize  = bytes.size();
+            header.sections.push_back({ static_cast<std::uint32_t>(SectionType::IndexInfo), header.dataOffset + header.dataSize, sectionBytes.size() });
+
+            const auto headerBytes = serializeFileHeader(header);
+            fout.write(headerBytes.data(), headerBytes.size());
+        }
+
+        const Stopwatch stopwatch;
+
+        // Runs and bitmaps do not store the indices one by one, so the progress is reported for all of them at once
+        if (settings.progress)
+            settings.progress->throwIfCancelled();
+
+        writeElements(fout, bytes.data(), bytes.size(), getElementSize(dataContent.elementType), ChunkedWriteSettings());
+
+        if (settings.progress)
+            settings.progress->addBlock(bytes.size(), dataContent.numIndices);
+
+        if (_writeHeader)
+            fout.write(sectionBytes.data(), sectionBytes.size());
+
+        fout.close();
+
+        addWritePhases(record, stats, 0, stopwatch.getSeconds(), dataContent.numIndices * sizeof(unsigned int), bytes.size());
+    }
+    catch (const WriteCancelled&)
+    {
+        return false;
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "BinExporter: Writing" << writePath << "failed:" << e.what();
+        record.setField("error", e.what());
+        return false;
+    }
+
+    return true;
 }
 
+bool BinExporter::writeDataSetToBinary(QString writePath, DataContent& dataContent, const ChunkedWriteSettings& pipelineSettings, OperationRecord& record) {
+    // Subsets write the selected points in the order of their indices
+    const std::vector<unsigned int>& pointIDsGlobal = dataContent.indices;
+
+    const std::size_t numDimensions = dataContent.numDimensions;
+    const std::size_t numRows       = dataContent.isFull ? dataContent.numPoints : pointIDsGlobal.size();
+
+    PipelineStats stats;
+
+    auto settings   = pipelineSettings;
+    settings.stats  = &stats;
+
+    try
+    {
+        const auto file = openFileWriter(std::filesystem::path(writePath.toStdU16String()), _writeMethod);
+
+        FileWriter& fout = *file;
+
+        std::visit([this, &fout, &dataContent, &pointIDsGlobal, &settings, &record, numDimensions, numRows](auto values)
+        {
+            using ElementTypeOfData = std::remove_cv_t<std::remove_pointer_t<decltype(values)>>;
+
+            const auto writeAs = [this, &fout, &dataContent, &pointIDsGlobal, &settings, &record, values, numDimensions, numRows](auto* destinationTag) {
+                using Destination = std::remove_pointer_t<decltype(destinationTag)>;
+
+                dataContent.elementType = getPointDataElementType<Destination>();
+
+                if (_writeHeader)
+                    writeFileHeader(fout, dataContent.elementType, numRows, numDimensions);
+
+                const std::uint64_t rawBytes = numRows * numDimensions * sizeof(Destination);
+
+                const Stopwatch stopwatch;
+
+                // Full data sets that are neither converted nor compressed are written in place, after a read of every block
+                // for the statistics and checksums of the v2 header; all others go through the block pipeline, which gathers
+                // them while it copies the rows
+                if (dataContent.isFull && !_compress && std::is_same_v<ElementTypeOfData, Destination>)
+                {
+                    StatisticsCollector statistics(numDimensions);
+                    BlockChecksums checksums;
+
+                    auto blockSettings          = settings;
+                    blockSettings.statistics    = _writeHeader ? &statistics : nullptr;
+                    blockSettings.checksums     = _writeHeader ? &checksums : nullptr;
+
+                    writeElements(fout, reinterpret_cast<const KernelElementType<ElementTypeOfData>*>(values), numRows * numDimensions, numDimensions, blockSettings);
+
+                    if (_writeHeader)
+                    {
+                        const auto columnStatistics = statistics.getStatistics();
+
+                        writeSections(fout, createFileHeader(dataContent.elementType, numRows, numDimensions), nullptr, nullptr, &columnStatistics, &checksums);
+
+                        dataContent.hasStatistics   = true;
+                        dataContent.hasChecksums    = true;
+                    }
+
+                    addWritePhases(record, *settings.stats, 0, stopwatch.getSeconds(), rawBytes, rawBytes);
+                }
+                else
+                {
+                    StatisticsCollector statistics(numDimensions);
+                    BlockChecksums checksums;
+
+                    auto rowSettings        = settings;
+                    rowSettings.statistics  = _writeHeader ? &statistics : nullptr;
+                    rowSettings.checksums   = _writeHeader ? &checksums : nullptr;
+
+                    const auto blockIndex = writeRowsInParallel<KernelElementType<ElementTypeOfData>, KernelElementType<Destination>>(fout, reinterpret_cast<const KernelElementType<ElementTypeOfData>*>(values), numDimensions, dataContent.isFull ? nullptr : pointIDsGlobal.data(), numRows, rowSettings);
+
+                    if (_writeHeader)
+                    {
+                        const auto columnStatistics = statistics.getStatistics();
+
+                        writeSections(fout, createFileHeader(dataContent.elementType, numRows, numDimensions), _compress ? &blockIndex : nullptr, nullptr, &columnStatistics, &checksums);
+
+                        dataContent.hasStatistics   = true;
+                        dataContent.hasChecksums    = true;
+                    }
+
+                    const double gatherSeconds = std::max(0.0, stopwatch.getSeconds() - settings.stats->consumeSeconds);
+
+                    addWritePhases(record, *settings.stats, gatherSeconds, settings.stats->consumeSeconds, rawBytes, _compress ? blockIndex.blockOffsets.back() : rawBytes);
+                }
+            };
+
+            // Every dimension is scanned for its range before its values are quantized to codes of that range
+            const auto writeQuantized = [this, &fout, &dataContent, &pointIDsGlobal, &settings, &record, values, numDimensions, numRows](auto* codeTag) {
+                using Code = std::remove_pointer_t<decltype(codeTag)>;
+                using Source = KernelElementType<ElementTypeOfData>;
+
+                dataContent.elementType = getElementType<Code>();
+                dataContent.isQuantized = true;
+
+                writeFileHeader(fout, dataContent.elementType, numRows, numDimensions);
+
+                const Source* const data                = reinterpret_cast<const Source*>(values);
+                const std::uint32_t* const rowIndices   = dataContent.isFull ? nullptr : pointIDsGlobal.data();
+
+                const Stopwatch stopwatch;
+
+                StatisticsCollector statistics(numDimensions);
+                BlockChecksums checksums;
+
+                auto rowSettings        = settings;
+                rowSettings.statistics  = &statistics;
+                rowSettings.checksums   = &checksums;
+
+                const auto quantizationTable    = makeQuantizationTable(getColumnRanges(data, numDimensions, rowIndices, numRows, settings.numberOfThreads), 8 * sizeof(Code));
+                const auto blockIndex           = writeQuantizedRowsInParallel<Source, Code>(fout, data, numDimensions, rowIndices, numRows, quantizationTable, rowSettings);
+                const auto columnStatistics     = statistics.getStatistics();
+
+                writeSections(fout, createFileHeader(dataContent.elementType, numRows, numDimensions), _compress ? &blockIndex : nullptr, &quantizationTable, &columnStatistics, &checksums);
+
+                dataContent.hasStatistics   = true;
+                dataContent.hasChecksums    = true;
+
+                const std::uint64_t rawBytes    = numRows * numDimensions * sizeof(Code);
+                const double gatherSeconds      = std::max(0.0, stopwatch.getSeconds() - settings.stats->consumeSeconds);
+
+                addWritePhases(record, *settings.stats, gatherSeconds, settings.stats->consumeSeconds, rawBytes, _compress ? blockIndex.blockOffsets.back() : rawBytes);
+            };
+
+            if (_quantizationBits == 8)
+                writeQuantized(static_cast<std::uint8_t*>(nullptr));
+            else if (_quantizationBits == 16)
+                writeQuantized(static_cast<std::uint16_t*>(nullptr));
+            else if (_dataType.isEmpty() || !visitElementTypeByName(_dataType, writeAs))
+                writeAs(static_cast<ElementTypeOfData*>(nullptr));
+        }, dataContent.values);
+
+        fout.close();
+    }
+    catch (const WriteCancelled&)
+    {
+        return false;
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "BinExporter: Writing" << writePath << "failed:" << e.what();
+        record.setField("error", e.what());
+        return false;
+    }
+
+    return true;
+}
 
 void BinExporter::writeInfoTextForBinary(QString writePath, DataContent& dataContent) {
     std::string infoText;
@@ -155,7 +952,22 @@ void BinExporter::writeInfoTextForBinary(QString writePath, DataContent& dataCon
     infoText += fileName + "\n";
     infoText += "Num dimensions: " + std::to_string(dataContent.numDimensions) + "\n";
     infoText += "Num data points: " + std::to_string(dataContent.numPoints) + "\n";
-    infoText += "Data type: float \n";			// currently hard=coded	
+    infoText += std::string("Data type: ") + getElementTypeName(dataContent.elementType) + " \n";
+    infoText += _writeHeader ? "Format: BinIO v2 (" + std::to_string(FileHeader::headerSize) + " byte header) \n" : "Format: raw \n";
+
+    if (dataContent.onlyIndices)
+        infoText += std::string("Index encoding: ") + getIndexEncodingName(dataContent.indexInfo.encoding) + " \n";
+    else if (_compress)
+        infoText += "Compression: LZ blocks with byte shuffle \n";
+
+    if (dataContent.isQuantized)
+        infoText += "Quantization: " + std::to_string(8 * getElementSize(dataContent.elementType)) + " bit codes, scale and offset per dimension \n";
+
+    if (dataContent.hasStatistics)
+        infoText += "Statistics: min, max, mean and variance per dimension in the header \n";
+
+    if (dataContent.hasChecksums)
+        infoText += std::string("Checksums: XXH64 per ") + (_compress ? "compressed block" : "block of about 1 MB") + " in the header \n";
 
     if (dataContent.isDerived)
     {
@@ -168,13 +980,44 @@ void BinExporter::writeInfoTextForBinary(QString writePath, DataContent& dataCon
     if (dataContent.onlyIndices)
     {
         infoText += "Contains only indices (e.g. of a selection) \n";
+        infoText += "Num indices: " + std::to_string(dataContent.numIndices) + "\n";
     }
 
-    std::ofstream fout(writePath.section(".", 0, 0).toStdString() + ".txt");
+    std::ofstream fout(getSidecarPath(writePath, ".txt").toStdString());
     fout << infoText;
     fout.close();
 }
 
+void BinExporter::writeInfoJsonForBinary(QString writePath, const DataContent& dataContent) {
+    QJsonObject info;
+
+    info["file"]            = QFileInfo(writePath).fileName();
+    info["format"]          = _writeHeader ? "binio-v2" : "raw";
+    info["elementType"]     = getElementTypeName(dataContent.elementType);
+    info["byteOrder"]       = getNativeByteOrder() == ByteOrder::BigEndian ? "big-endian" : "little-endian";
+    info["numDimensions"]   = static_cast<qint64>(dataContent.onlyIndices ? 1 : dataContent.numDimensions);
+    info["numPoints"]       = static_cast<qint64>(dataContent.numPoints);
+    info["compression"]     = !_compress ? "none" : (dataContent.onlyIndices ? getIndexEncodingName(dataContent.indexInfo.encoding) : "lz");
+    info["quantization"]    = dataContent.isQuantized ? static_cast<int>(8 * getElementSize(dataContent.elementType)) : 0;
+    info["statistics"]      = dataContent.hasStatistics;
+    info["checksums"]       = dataContent.hasChecksums;
+
+    if (dataContent.onlyIndices)
+        info["numIndices"] = static_cast<qint64>(dataContent.numIndices);
+
+    if (dataContent.isDerived)
+    {
+        info["sourceData"]          = dataContent.derivedFrom;
+        info["sourceNumDimensions"] = static_cast<qint64>(dataContent.sourceNumDimensions);
+        info["sourceNumPoints"]     = static_cast<qint64>(dataContent.sourceNumPoints);
+    }
+
+    QFile file(getSidecarPath(writePath, ".json"));
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(QJsonDocument(info).toJson()) < 0)
+        qWarning() << "BinExporter: Could not write" << file.fileName();
+}
+
 // =============================================================================
 // Factory
 // =============================================================================
@@ -207,8 +1050,11 @@ PluginTriggerActions BinExporterFactory::getPluginTriggerActions(const mv::Datas
     if (PluginFactory::areAllDatasetsOfTheSameType(datasets, PointType)) {
         if (datasets.count() >= 1) {
             auto pluginTriggerAction = new PluginTriggerAction(const_cast<BinExporterFactory*>(this), this, "BIN Exporter", "Export dataset to binary file", icon(), [this, getPluginInstance, datasets](PluginTriggerAction& pluginTriggerAction) -> void {
-                for (const auto& dataset : datasets)
-                    getPluginInstance(dataset);
+                // Several data sets are exported together, with one dialog and one folder
+                if (datasets.count() == 1)
+                    getPluginInstance(datasets.first());
+                else
+                    plugins().requestPlugin(getKind(), datasets);
             });
 
             pluginTriggerActions << pluginTriggerAction;
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "ChunkedWriter.h"
+#include "FileFormat.h"
+#include "FileWriter.h"
+#include "Instrumentation.h"
+
 #include <WriterPlugin.h>
 
 #include <PointData/PointData.h>
@@ -9,19 +14,45 @@
 #include <QDialog>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QLineEdit>
 #include <QPushButton>
 
+#include <utility>
+#include <variant>
+
 using namespace mv::plugin;
 using namespace mv::gui;
 
+template <typename Sequence>
+struct PointValuePointers;
+
+template <unsigned... N>
+struct PointValuePointers<std::integer_sequence<unsigned, N...>>
+{
+    using Type = std::variant<const PointData::ElementTypeAt<N>*...>;
+};
+
+// Pointer to the values of a data set, of one of the element types of PointData
+using PointValues = PointValuePointers<std::make_integer_sequence<unsigned, PointData::getNumberOfSupportedElementTypes()>>::Type;
+
 struct DataContent {
-    DataContent() : dataVals{}, numDimensions(0), numPoints(0), isDerived(false), onlyIndices(false), derivedFrom(""), sourceNumDimensions(0), sourceNumPoints(0) {};
-    std::vector<float> dataVals;
+    DataContent() : dataBytes{}, values{}, indices{}, elementType(ElementType::Float32), numDimensions(0), numPoints(0), numRawPoints(0), isFull(false), isDerived(false), onlyIndices(false), isQuantized(false), hasStatistics(false), hasChecksums(false), numIndices(0), indexInfo{}, derivedFrom(""), sourceNumDimensions(0), sourceNumPoints(0) {};
+    std::vector<char> dataBytes;    // encoded indices, words in the native byte order
+    PointValues values;             // values of all points of the raw data, null for indices
+    std::vector<unsigned int> indices;  // points of a subset in the order they are written, or the indices to encode
+    ElementType elementType;
     unsigned int numDimensions;
     unsigned int numPoints;
+    unsigned int numRawPoints;
 
+    bool isFull;        // all points are written, otherwise only those at the indices of the data set
     bool isDerived;
     bool onlyIndices;
+    bool isQuantized;   // values are written as codes with a scale and offset per dimension, see Quantization.h
+    bool hasStatistics; // the header holds the statistics of every dimension, see Statistics.h
+    bool hasChecksums;  // the header holds the checksums of the blocks of the data, see Checksum.h
+    std::uint64_t numIndices;
+    IndexInfo indexInfo;    // encoding of the indices, see IndexCodec.h
     QString derivedFrom;
     unsigned int sourceNumDimensions;
     unsigned int sourceNumPoints;
@@ -40,12 +71,58 @@ class BinExporterDialog : public QDialog
 {
     Q_OBJECT
 public:
-    BinExporterDialog(QWidget* parent) :
-        QDialog(parent), writeButton(tr("Write file"))
+    /*! Construct the dialog
+     *
+     * \param parent Parent widget
+     * \param multipleDataSets Whether several data sets are exported at once, which shows the file name template
+     * \param fileNameTemplate Initial file name template of several data sets
+    */
+    BinExporterDialog(QWidget* parent, bool multipleDataSets = false, const QString& fileNameTemplate = "{name}.bin") :
+        QDialog(parent), writeButton(multipleDataSets ? tr("Write files") : tr("Write file"))
     {
         setWindowTitle(tr("Binary Exporter"));
 
         QLabel* indicesLabel = new QLabel("Save only indices");
+        QLabel* formatLabel = new QLabel("File format");
+        QLabel* dataTypeLabel = new QLabel("Data type");
+        QLabel* compressLabel = new QLabel("Compress");
+        QLabel* quantizeLabel = new QLabel("Quantize");
+        QLabel* writeMethodLabel = new QLabel("Write method");
+
+        fileFormat.addItem("BinIO v2 (with header)");
+        fileFormat.addItem("Raw (legacy)");
+
+        // Native keeps the element type of the data set, so that no precision is lost and nothing is converted
+        dataType.addItem("Native");
+        for (const char* const typeName : PointData::getElementTypeNames())
+            dataType.addItem(QString::fromLatin1(typeName));
+
+        // Several data sets are written to one folder, named after the template
+        fileNames.setText(fileNameTemplate);
+        fileNames.setPlaceholderText("{name}.bin");
+        fileNames.setToolTip("{name} is the name of the data set, {index} its position in the selection");
+
+        // Indices are always written as exact integers, compressed ones as runs or a bitmap when that is smaller
+        compress.setToolTip("Values are compressed in LZ blocks, indices are encoded as runs or a bitmap");
+
+        // Quantized values are stored as codes of 8 or 16 bits with a scale and offset per dimension, instead of the data type
+        quantize.addItem("Off", 0u);
+        quantize.addItem("8 bit", 8u);
+        quantize.addItem("16 bit", 16u);
+        quantize.setToolTip("Stores every value as an 8 or 16 bit code of the range of its dimension (BinIO v2 only)");
+
+        // Direct writes keep a large export from evicting the page cache of everything else on the machine
+        writeMethod.addItem("Stream", static_cast<int>(WriteMethod::Stream));
+        writeMethod.addItem("Direct (around the page cache)", static_cast<int>(WriteMethod::DirectWrite));
+        writeMethod.setToolTip("Direct writes stream aligned blocks with several writes in flight and leave the page cache alone");
+
+        const auto updateTypes = [this]() -> void {
+            dataType.setDisabled(saveIndices.isChecked() || quantize.currentIndex() != 0);
+            quantize.setDisabled(saveIndices.isChecked());
+        };
+
+        connect(&saveIndices, &QCheckBox::toggled, this, updateTypes);
+        connect(&quantize, &QComboBox::currentIndexChanged, this, updateTypes);
 
         writeButton.setDefault(true);
 
@@ -55,21 +132,44 @@ public:
         QHBoxLayout *layout = new QHBoxLayout();
         layout->addWidget(indicesLabel);
         layout->addWidget(&saveIndices);
+        layout->addWidget(formatLabel);
+        layout->addWidget(&fileFormat);
+        layout->addWidget(dataTypeLabel);
+        layout->addWidget(&dataType);
+        layout->addWidget(compressLabel);
+        layout->addWidget(&compress);
+        layout->addWidget(quantizeLabel);
+        layout->addWidget(&quantize);
+        layout->addWidget(writeMethodLabel);
+        layout->addWidget(&writeMethod);
+
+        if (multipleDataSets)
+        {
+            layout->addWidget(new QLabel("File names"));
+            layout->addWidget(&fileNames);
+        }
+
         layout->addWidget(&writeButton);
         setLayout(layout);
     }
 
 signals:
-    void closeDialog(bool onlyIndices);
+    void closeDialog(bool onlyIndices, bool writeHeader, QString dataType, bool compress, unsigned int quantizationBits, WriteMethod writeMethod, QString fileNameTemplate);
 
 public slots:
     // Pass selected data set name from BinExporterDialog to BinExporter (dialogClosed)
     void closeDialogAction() {
-        emit closeDialog(saveIndices.isChecked());
+        emit closeDialog(saveIndices.isChecked(), fileFormat.currentIndex() == 0, dataType.currentIndex() == 0 ? QString() : dataType.currentText(), compress.isChecked(), quantize.currentData().toUInt(), static_cast<WriteMethod>(writeMethod.currentData().toInt()), fileNames.text());
     }
 
 private:
     QCheckBox       saveIndices;
+    QComboBox       fileFormat;
+    QComboBox       dataType;
+    QCheckBox       compress;
+    QComboBox       quantize;
+    QComboBox       writeMethod;
+    QLineEdit       fileNames;
     QPushButton     writeButton;
 };
 
@@ -89,26 +189,93 @@ public:
     void writeData() Q_DECL_OVERRIDE;
 
 private:
+    /*! Write several data sets to one folder
+     * Asks for the folder once and names the files after the file name
+     * template. The data sets are written concurrently by worker threads,
+     * which share the threads and the block buffer, while their tasks show
+     * the progress. Aborting a task cancels the export of its data set, so
+     * does removing the data set, which waits until its worker stopped.
+     * The workers only use what was retrieved on the GUI thread.
+     *
+     * \param datasets Data sets to write
+    */
+    void writeDataSets(const mv::Datasets& datasets);
+
     /*! Get data set contents from core
+     * Takes the values and the indices of the points as well, so that
+     * writing the data set needs nothing else of the core.
      *
      * \param dataSetName Data set name to request from core
+     * \param withIndices Gather the indices of an indices-only export now, otherwise gatherIndices does so later
     */
-    DataContent retrieveDataSetContent(mv::Dataset<Points> dataSet) const;
+    DataContent retrieveDataSetContent(mv::Dataset<Points> dataSet, bool withIndices = true) const;
 
-    /*! Write vector contents to disk
-     * Stores content in little endian binary form.
+    /** Gather the retrieved indices as exact uint32 or uint64 words, encoded as runs or a bitmap when that is smaller and compression was chosen */
+    void gatherIndices(DataContent& dataContent) const;
+
+    /*! Write a data set and its description to disk and record the export
+     * Partly written files of failed or cancelled exports are removed.
+     *
+     * \param writePath Target path
+     * \param dataContent Meta data of the data set, receives the written element type
+     * \param settings Threads, buffer, compression and progress of the block pipeline
+     * \param record Receives the fields of the export and the gather and write phases
+     * \return Whether the file was written
+    */
+    bool exportDataSet(const QString& writePath, DataContent& dataContent, const ChunkedWriteSettings& settings, OperationRecord& record);
+
+    /*! Write gathered indices to disk
+     * Stores the encoded indices in the native byte order, preceded by a v2
+     * file header of an index file with its index info section, or as plain
+     * words when the legacy raw format was chosen.
      * Overrides existing files with at the given path.
      *
-     * \param vec Data to write to disk
+     * \param dataContent Gathered indices, see gatherIndices
      * \param writePath Target path
+     * \param settings Progress of the write
+     * \param record Receives the gather and write phases
+     * \return Whether the file was written
     */
-    template<typename T>
-    void writeVecToBinary(std::vector<T> vec, QString writePath);
+    bool writeIndicesToBinary(const DataContent& dataContent, QString writePath, const ChunkedWriteSettings& settings, OperationRecord& record);
+
+    /*! Write the points of a data set to disk
+     * Full data sets are written straight from their storage in large
+     * sequential blocks, which worker threads read for the statistics and
+     * checksums of the v2 header before they are written. Subsets, conversions to another element type and
+     * compressed files are gathered, converted and compressed in blocks by
+     * worker threads while the finished blocks are written in order.
+     * Quantized values are gathered the same way, after the range of every
+     * dimension was scanned in parallel.
+     * Overrides existing files with at the given path.
+     *
+     * \param writePath Target path
+     * \param dataContent Retrieved values and meta data of the data set, receives the written element type
+     * \param settings Threads, buffer, compression and progress of the block pipeline
+     * \param record Receives the gather and write phases
+     * \return Whether the file was written
+    */
+    bool writeDataSetToBinary(QString writePath, DataContent& dataContent, const ChunkedWriteSettings& settings, OperationRecord& record);
+
+    /** Get the settings of the block pipeline, with compression when it was chosen */
+    ChunkedWriteSettings getWriteSettings() const;
 
     void writeInfoTextForBinary(QString writePath, DataContent& dataContent);
 
+    /*! Write the description of a file as JSON next to it, which BinLoader reads to load raw files without the dialog
+     *
+     * \param writePath Path of the written file, the description replaces its suffix by .json
+     * \param dataContent Meta data of the written data set
+    */
+    void writeInfoJsonForBinary(QString writePath, const DataContent& dataContent);
+
 private:
     bool _onlyIdices;   // save indices, e.g. of a selection instead of data values
+    bool _writeHeader;  // precede the data with a v2 file header
+    QString _dataType;  // element type to write, empty for the native type of the data set
+    bool _compress;     // write block-compressed data (v2 only)
+    unsigned int _quantizationBits; // write values as codes of 8 or 16 bits with a scale and offset per dimension, 0 writes them as they are (v2 only)
+    WriteMethod _writeMethod;   // how the files are written, through the page cache or around it
+    QString _fileNameTemplate;  // file names of several data sets, see BinExporterDialog
 
 };
 
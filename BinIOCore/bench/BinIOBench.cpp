@@ -0,0 +1,414 @@
+// binio_bench: headless throughput benchmark of the BinIO core
+//
+// Measures MB/s of converting, exporting and loading .bin data for a range of
+// data sizes, element types, thread counts, read and write methods and access
+// patterns.
+// Run "binio_bench --help" for the options.
+
+#include "ChunkedLoader.h"
+#include "ChunkedWriter.h"
+#include "ConversionKernels.h"
+#include "FileFormat.h"
+#include "FileReader.h"
+#include "FileWriter.h"
+#include "Parallel.h"
+#include "Selection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+struct BenchSettings
+{
+    std::vector<std::size_t>    sizes       = { 64, 512 };          // Data sizes in MB (of float32 values)
+    std::size_t                 numColumns  = 100;
+    std::vector<std::string>    types       = { "float32", "uint8" };
+    std::vector<std::size_t>    threads     = { 1, resolveNumberOfThreads(0) };
+    std::filesystem::path       directory   = std::filesystem::temp_directory_path();
+    std::size_t                 repeat      = 3;                    // Repetitions per measurement, the fastest is reported
+    bool                        cold        = false;                // Evict the file from the page cache before every load
+    bool                        csv         = false;
+};
+
+void printUsage()
+{
+    std::cout <<
+        "Usage: binio_bench [options]\n"
+        "  --sizes MB,...     Data sizes in MB of float32 values (default 64,512)\n"
+        "  --dims N           Dimensions per point (default 100)\n"
+        "  --types T,...      Element types: float32, bfloat16, int16, uint16, int8, uint8 (default float32,uint8)\n"
+        "  --threads N,...    Thread counts (default 1 and all hardware threads)\n"
+        "  --dir PATH         Directory for the benchmark files (default the temporary directory)\n"
+        "  --repeat N         Repetitions per measurement, the fastest is reported (default 3)\n"
+        "  --cold             Evict the files from the page cache before loading (Linux and macOS)\n"
+        "  --csv              Print comma-separated values instead of a table\n";
+}
+
+std::vector<std::string> splitList(const std::string& text)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+
+    for (std::string item; std::getline(stream, item, ',');)
+        if (!item.empty())
+            items.push_back(item);
+
+    return items;
+}
+
+std::vector<std::size_t> parseNumbers(const std::string& text)
+{
+    std::vector<std::size_t> numbers;
+
+    for (const auto& item : splitList(text))
+        numbers.push_back(static_cast<std::size_t>(std::stoull(item)));
+
+    return numbers;
+}
+
+BenchSettings parseArguments(int argc, char** argv)
+{
+    BenchSettings settings;
+
+    for (int argumentIndex = 1; argumentIndex < argc; argumentIndex++)
+    {
+        const std::string argument = argv[argumentIndex];
+
+        const auto value = [&]() -> std::string {
+            if (argumentIndex + 1 >= argc)
+                throw std::runtime_error("Missing value of " + argument);
+
+            return argv[++argumentIndex];
+        };
+
+        if (argument == "--sizes")
+            settings.sizes = parseNumbers(value());
+        else if (argument == "--dims")
+            settings.numColumns = std::max<std::size_t>(1, std::stoull(value()));
+        else if (argument == "--types")
+            settings.types = splitList(value());
+        else if (argument == "--threads")
+            settings.threads = parseNumbers(value());
+        else if (argument == "--dir")
+            settings.directory = value();
+        else if (argument == "--repeat")
+            settings.repeat = std::max<std::size_t>(1, std::stoull(value()));
+        else if (argument == "--cold")
+            settings.cold = true;
+        else if (argument == "--csv")
+            settings.csv = true;
+        else if (argument == "--help" || argument == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        else
+            throw std::runtime_error("Unknown option " + argument);
+    }
+
+    return settings;
+}
+
+// Evicts a file from the page cache, so that the next load reads from the storage device
+void evictFromPageCache([[maybe_unused]] const std::filesystem::path& filePath)
+{
+#if defined(__linux__)
+    const int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+
+    if (fileDescriptor >= 0)
+    {
+        ::fdatasync(fileDescriptor);
+        ::posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fileDescriptor);
+    }
+#elif defined(__APPLE__)
+    const int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+
+    if (fileDescriptor >= 0)
+    {
+        ::fcntl(fileDescriptor, F_NOCACHE, 1);
+        ::close(fileDescriptor);
+    }
+#endif
+}
+
+class Report
+{
+public:
+    explicit Report(bool csv) : _csv(csv)
+    {
+        if (_csv)
+            std::printf("benchmark,type,size_mb,threads,method,pattern,seconds,mb_per_s\n");
+        else
+            std::printf("%-8s %-9s %8s %7s %-10s %-10s %9s %10s\n", "bench", "type", "size MB", "threads", "method", "pattern", "seconds", "MB/s");
+    }
+
+    // Prints a measurement, megabytes is the amount of data in the element type of the file
+    void add(const char* benchmark, const std::string& type, double megabytes, std::size_t numberOfThreads, const char* method, const char* pattern, double seconds) const
+    {
+        const double throughput = megabytes / std::max(seconds, 1e-9);
+
+        if (_csv)
+            std::printf("%s,%s,%.1f,%zu,%s,%s,%.6f,%.1f\n", benchmark, type.c_str(), megabytes, numberOfThreads, method, pattern, seconds, throughput);
+        else
+            std::printf("%-8s %-9s %8.1f %7zu %-10s %-10s %9.4f %10.1f\n", benchmark, type.c_str(), megabytes, numberOfThreads, method, pattern, seconds, throughput);
+
+        std::fflush(stdout);
+    }
+
+private:
+    bool _csv;
+};
+
+// Runs function repeat times and returns the fastest wall time in seconds
+double measure(std::size_t repeat, const std::function<void()>& function)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for (std::size_t repetition = 0; repetition < repeat; repetition++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        function();
+
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+        best = std::min(best, duration.count());
+    }
+
+    return best;
+}
+
+// Writes rows of data (at rowIndices, or all when nullptr) to a file without header and returns the block index of compressed files
+template <typename T>
+BlockIndex writeFile(const std::filesystem::path& filePath, const T* data, std::size_t numColumns, const std::uint32_t* rowIndices, std::size_t numRows, const ChunkedWriteSettings& settings, WriteMethod writeMethod = WriteMethod::Stream)
+{
+    const auto out = openFileWriter(filePath, writeMethod);
+
+    BlockIndex blockIndex = writeRowsInParallel<T, T>(*out, data, numColumns, rowIndices, numRows, settings);
+
+    out->close();
+
+    blockIndex.numRows = numRows;
+
+    return blockIndex;
+}
+
+// Benchmarks one element type T at one size for all thread counts
+template <typename T>
+void benchmarkType(const BenchSettings& settings, const Report& report, const std::string& typeName, std::size_t sizeInMegabytes)
+{
+    const std::size_t numColumns    = settings.numColumns;
+    const std::size_t numRows       = std::max<std::size_t>(1, (sizeInMegabytes << 20) / sizeof(float) / numColumns);
+    const std::size_t numElements   = numRows * numColumns;
+    const double megabytes          = static_cast<double>(numElements * sizeof(T)) / double(1 << 20);
+
+    // Values that fit all element types, so that conversions do not saturate everywhere
+    std::vector<float> source(numElements);
+    for (std::size_t index = 0; index < numElements; index++)
+        source[index] = static_cast<float>(index % 127);
+
+    std::vector<T> data(numElements);
+    convertElements<float>(reinterpret_cast<const char*>(source.data()), data.data(), numElements);
+
+    const auto filePath             = settings.directory / ("binio_bench_" + typeName + ".bin");
+    const auto compressedFilePath   = settings.directory / ("binio_bench_" + typeName + "_lz.bin");
+
+    // Every fourth point, and the first quarter of the dimensions
+    RowSelectionSettings rowSelectionSettings;
+    rowSelectionSettings.mode = RowSelectionSettings::Mode::Stride;
+    rowSelectionSettings.step = 4;
+
+    const RowSelection allRows      = selectRows(RowSelectionSettings(), numRows);
+    const RowSelection subsetRows   = selectRows(rowSelectionSettings, numRows);
+
+    std::vector<std::uint32_t> projectedColumns(std::max<std::size_t>(1, numColumns / 4));
+    std::iota(projectedColumns.begin(), projectedColumns.end(), 0u);
+
+    std::vector<std::uint32_t> subsetIndices(subsetRows.size());
+    for (std::size_t index = 0; index < subsetIndices.size(); index++)
+        subsetIndices[index] = static_cast<std::uint32_t>(subsetRows.getRow(index));
+
+    for (const auto numberOfThreads : settings.threads)
+    {
+        // Conversion from and to float32 in memory
+        {
+            std::vector<float> converted(numElements);
+            const std::size_t chunkSize = std::size_t(1) << 20;
+            const std::size_t numberOfChunks = (numElements + chunkSize - 1) / chunkSize;
+
+            const double toFloatSeconds = measure(settings.repeat, [&]() {
+                forEachChunkInParallel(numberOfChunks, numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>&) {
+                    const std::size_t first = chunkIndex * chunkSize;
+                    convertElements<T>(reinterpret_cast<const char*>(data.data() + first), converted.data() + first, std::min(chunkSize, numElements - first));
+                });
+            });
+
+            report.add("convert", typeName, megabytes, numberOfThreads, "memory", "to-float32", toFloatSeconds);
+
+            std::vector<T> roundTrip(numElements);
+
+            const double fromFloatSeconds = measure(settings.repeat, [&]() {
+                forEachChunkInParallel(numberOfChunks, numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>&) {
+                    const std::size_t first = chunkIndex * chunkSize;
+                    convertElements<float>(reinterpret_cast<const char*>(converted.data() + first), roundTrip.data() + first, std::min(chunkSize, numElements - first));
+                });
+            });
+
+            report.add("convert", typeName, megabytes, numberOfThreads, "memory", "from-float", fromFloatSeconds);
+        }
+
+        // Export of all points, a subset of the points and compressed
+        BlockIndex blockIndex;
+        {
+            ChunkedWriteSettings writeSettings;
+            writeSettings.numberOfThreads = numberOfThreads;
+
+            for (const auto writeMethod : { WriteMethod::Stream, WriteMethod::DirectWrite })
+            {
+                report.add("export", typeName, megabytes, numberOfThreads, getWriteMethodName(writeMethod), "full", measure(settings.repeat, [&]() {
+                    writeFile(filePath, data.data(), numColumns, nullptr, numRows, writeSettings, writeMethod);
+                }));
+            }
+
+            const auto subsetFilePath = settings.directory / ("binio_bench_" + typeName + "_subset.bin");
+
+            report.add("export", typeName, megabytes / 4, numberOfThreads, "stream", "subset", measure(settings.repeat, [&]() {
+                writeFile(subsetFilePath, data.data(), numColumns, subsetIndices.data(), subsetIndices.size(), writeSettings);
+            }));
+
+            std::filesystem::remove(subsetFilePath);
+
+            ChunkedWriteSettings compressedWriteSettings = writeSettings;
+            compressedWriteSettings.codec = BlockCodec::LZ;
+
+            report.add("export", typeName, megabytes, numberOfThreads, "stream", "lz", measure(settings.repeat, [&]() {
+                blockIndex = writeFile(compressedFilePath, data.data(), numColumns, nullptr, numRows, compressedWriteSettings);
+            }));
+        }
+
+        // Loads in the type of the file and converted to float32
+        ChunkedLoadSettings loadSettings;
+        loadSettings.numberOfThreads = numberOfThreads;
+
+        for (const auto readMethod : { ReadMethod::PositionalRead, ReadMethod::MemoryMap, ReadMethod::DirectRead })
+        {
+            const char* const methodName = getReadMethodName(readMethod);
+
+            const auto benchmarkLoad = [&](const char* pattern, double loadedMegabytes, const std::function<void(const FileReader&)>& load) -> void {
+                const double seconds = measure(settings.repeat, [&]() {
+                    if (settings.cold)
+                        evictFromPageCache(filePath);
+
+                    const auto reader = openFileReader(filePath, readMethod);
+
+                    load(*reader);
+                });
+
+                report.add("load", typeName, loadedMegabytes, numberOfThreads, methodName, pattern, seconds);
+            };
+
+            std::vector<T> output(numElements);
+            std::vector<float> floatOutput(numElements);
+
+            benchmarkLoad("full", megabytes, [&](const FileReader& reader) {
+                loadRowsInParallel<T>(reader, 0, numRows, numColumns, output.data(), loadSettings);
+            });
+
+            if constexpr (!std::is_same_v<T, float>)
+            {
+                benchmarkLoad("full-f32", megabytes, [&](const FileReader& reader) {
+                    loadRowsInParallel<T>(reader, 0, numRows, numColumns, floatOutput.data(), loadSettings);
+                });
+            }
+
+            benchmarkLoad("subset", megabytes / 4, [&](const FileReader& reader) {
+                loadSelectionInParallel<T>(reader, 0, numColumns, subsetRows, {}, output.data(), loadSettings);
+            });
+
+            benchmarkLoad("projected", megabytes * projectedColumns.size() / numColumns, [&](const FileReader& reader) {
+                loadSelectionInParallel<T>(reader, 0, numColumns, allRows, projectedColumns, output.data(), loadSettings);
+            });
+        }
+
+        // Decompression of the compressed file, with the block index the writer returned
+        {
+            std::vector<T> output(numElements);
+
+            const double seconds = measure(settings.repeat, [&]() {
+                if (settings.cold)
+                    evictFromPageCache(compressedFilePath);
+
+                const auto reader = openFileReader(compressedFilePath, ReadMethod::PositionalRead);
+
+                loadBlocksInParallel<T>(*reader, 0, blockIndex, numColumns, allRows, {}, output.data(), loadSettings);
+            });
+
+            report.add("load", typeName, megabytes, numberOfThreads, "pread", "lz", seconds);
+        }
+    }
+
+    std::filesystem::remove(filePath);
+    std::filesystem::remove(compressedFilePath);
+}
+
+void benchmarkType(const BenchSettings& settings, const Report& report, const std::string& typeName, std::size_t sizeInMegabytes)
+{
+    if (typeName == "float32")
+        benchmarkType<float>(settings, report, typeName, sizeInMegabytes);
+    else if (typeName == "bfloat16")
+        benchmarkType<BFloat16>(settings, report, typeName, sizeInMegabytes);
+    else if (typeName == "int16")
+        benchmarkType<std::int16_t>(settings, report, typeName, sizeInMegabytes);
+    else if (typeName == "uint16")
+        benchmarkType<std::uint16_t>(settings, report, typeName, sizeInMegabytes);
+    else if (typeName == "int8")
+        benchmarkType<std::int8_t>(settings, report, typeName, sizeInMegabytes);
+    else if (typeName == "uint8")
+        benchmarkType<std::uint8_t>(settings, report, typeName, sizeInMegabytes);
+    else
+        throw std::runtime_error("Unknown element type " + typeName);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const BenchSettings settings = parseArguments(argc, argv);
+
+        std::fprintf(stderr, "binio_bench: %zu dimensions, %s kernels, files in %s%s\n", settings.numColumns, getSimdLevelName(getSimdLevel()), settings.directory.string().c_str(), settings.cold ? ", cold page cache" : "");
+
+        const Report report(settings.csv);
+
+        for (const auto sizeInMegabytes : settings.sizes)
+            for (const auto& typeName : settings.types)
+                benchmarkType(settings, report, typeName, sizeInMegabytes);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "binio_bench: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
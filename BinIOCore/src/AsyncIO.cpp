@@ -0,0 +1,383 @@
+#include "AsyncIO.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+
+    // IORING_OP_READ and IORING_OP_WRITE came with Linux 5.6, the feature flag with 5.7
+    #if defined(IORING_FEAT_FAST_POLL) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+        #define BINIO_HAS_IO_URING
+    #endif
+#endif
+
+AlignedBuffer allocateAlignedBuffer(std::size_t size)
+{
+    return AlignedBuffer(static_cast<char*>(::operator new[](size, std::align_val_t(ioAlignment))));
+}
+
+#ifdef _WIN32
+
+int openDirectFile(const std::filesystem::path&, bool, bool&)
+{
+    throw std::runtime_error("Direct I/O is not supported on this platform.");
+}
+
+std::unique_ptr<IOQueue> createIOQueue(std::size_t)
+{
+    throw std::runtime_error("Asynchronous I/O is not supported on this platform.");
+}
+
+#else
+
+namespace {
+
+// Runs the requests with positional reads and writes on a pool of threads, one per request in flight
+class ThreadPoolQueue : public IOQueue
+{
+public:
+    explicit ThreadPoolQueue(std::size_t queueDepth) :
+        IOQueue(queueDepth)
+    {
+        for (std::size_t index = 0; index < queueDepth; index++)
+            _threads.emplace_back([this]() { run(); });
+    }
+
+    ~ThreadPoolQueue() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _requestAdded.notify_all();
+
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+    const char* getName() const override {
+        return "threads";
+    }
+
+    void submit(const IORequest& request) override {
+        if (_numberInFlight >= _queueDepth)
+            throw std::logic_error("The I/O queue is full.");
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _requests.push_back(request);
+        }
+
+        _numberInFlight++;
+        _requestAdded.notify_one();
+    }
+
+    IOCompletion wait() override {
+        if (_numberInFlight == 0)
+            throw std::logic_error("No I/O request is in flight.");
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _completionAdded.wait(lock, [this]() { return !_completions.empty(); });
+
+        const IOCompletion completion = _completions.front();
+        _completions.pop_front();
+
+        _numberInFlight--;
+
+        return completion;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true)
+        {
+            _requestAdded.wait(lock, [this]() { return _stop || !_requests.empty(); });
+
+            if (_stop)
+                return;
+
+            const IORequest request = _requests.front();
+            _requests.pop_front();
+
+            lock.unlock();
+
+            ssize_t result;
+
+            do
+            {
+                if (request.isWrite)
+                    result = ::pwrite(request.fileDescriptor, request.buffer, request.size, static_cast<off_t>(request.offset));
+                else
+                    result = ::pread(request.fileDescriptor, request.buffer, request.size, static_cast<off_t>(request.offset));
+            } while (result < 0 && errno == EINTR);
+
+            const IOCompletion completion = { request.tag, result < 0 ? -static_cast<std::int64_t>(errno) : static_cast<std::int64_t>(result) };
+
+            lock.lock();
+
+            _completions.push_back(completion);
+            _completionAdded.notify_one();
+        }
+    }
+
+    std::mutex                  _mutex;
+    std::condition_variable     _requestAdded;
+    std::condition_variable     _completionAdded;
+    std::deque<IORequest>       _requests;              // Submitted requests that no thread picked up yet
+    std::deque<IOCompletion>    _completions;           // Completions that were not waited for yet
+    std::vector<std::thread>    _threads;
+    bool                        _stop = false;
+};
+
+#ifdef BINIO_HAS_IO_URING
+
+// Submits the requests to the kernel through the shared rings of io_uring, without liburing
+class IoUringQueue : public IOQueue
+{
+public:
+    // Throws std::runtime_error when the kernel does not offer io_uring, or not the operations that are used
+    explicit IoUringQueue(std::size_t queueDepth) :
+        IOQueue(queueDepth)
+    {
+        io_uring_params parameters;
+        std::memset(&parameters, 0, sizeof(parameters));
+
+        _ringFileDescriptor = static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(queueDepth), &parameters));
+
+        if (_ringFileDescriptor < 0)
+            throw std::runtime_error(std::string("Could not set up io_uring: ") + std::strerror(errno));
+
+        if (!(parameters.features & IORING_FEAT_FAST_POLL))
+        {
+            ::close(_ringFileDescriptor);
+            throw std::runtime_error("The kernel's io_uring cannot read and write.");
+        }
+
+        _submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+        _completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+        _entriesSize        = parameters.sq_entries * sizeof(io_uring_sqe);
+
+        // Kernels with a single mapping map both rings at once
+        const bool singleMapping = parameters.features & IORING_FEAT_SINGLE_MMAP;
+
+        if (singleMapping)
+            _submissionRingSize = _completionRingSize = std::max(_submissionRingSize, _completionRingSize);
+
+        _submissionRing = map(_submissionRingSize, IORING_OFF_SQ_RING);
+        _completionRing = singleMapping ? _submissionRing : map(_completionRingSize, IORING_OFF_CQ_RING);
+        _entries        = static_cast<io_uring_sqe*>(map(_entriesSize, IORING_OFF_SQES));
+
+        if (_submissionRing == nullptr || _completionRing == nullptr || _entries == nullptr)
+        {
+            const std::string error = std::strerror(errno);
+            unmap();
+            ::close(_ringFileDescriptor);
+            throw std::runtime_error("Could not map the rings of io_uring: " + error);
+        }
+
+        char* const submissionRing = static_cast<char*>(_submissionRing);
+        char* const completionRing = static_cast<char*>(_completionRing);
+
+        _submissionTail     = reinterpret_cast<unsigned*>(submissionRing + parameters.sq_off.tail);
+        _submissionMask     = *reinterpret_cast<unsigned*>(submissionRing + parameters.sq_off.ring_mask);
+        _submissionArray    = reinterpret_cast<unsigned*>(submissionRing + parameters.sq_off.array);
+        _completionHead     = reinterpret_cast<unsigned*>(completionRing + parameters.cq_off.head);
+        _completionTail     = reinterpret_cast<unsigned*>(completionRing + parameters.cq_off.tail);
+        _completionMask     = *reinterpret_cast<unsigned*>(completionRing + parameters.cq_off.ring_mask);
+        _completions        = reinterpret_cast<io_uring_cqe*>(completionRing + parameters.cq_off.cqes);
+    }
+
+    ~IoUringQueue() override
+    {
+        // The kernel may still write into the buffers of requests in flight
+        try
+        {
+            while (_numberInFlight > 0)
+                wait();
+        }
+        catch (const std::exception&)
+        {
+        }
+
+        unmap();
+        ::close(_ringFileDescriptor);
+    }
+
+    const char* getName() const override {
+        return "io_uring";
+    }
+
+    void submit(const IORequest& request) override {
+        if (_numberInFlight >= _queueDepth)
+            throw std::logic_error("The I/O queue is full.");
+
+        // This thread is the only one that adds entries, the kernel only reads the tail
+        const unsigned tail     = *_submissionTail;
+        const unsigned index    = tail & _submissionMask;
+
+        io_uring_sqe& entry = _entries[index];
+        std::memset(&entry, 0, sizeof(entry));
+
+        entry.opcode    = request.isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+        entry.fd        = request.fileDescriptor;
+        entry.addr      = reinterpret_cast<std::uint64_t>(request.buffer);
+        entry.len       = static_cast<std::uint32_t>(request.size);
+        entry.off       = request.offset;
+        entry.user_data = request.tag;
+
+        _submissionArray[index] = index;
+
+        __atomic_store_n(_submissionTail, tail + 1, __ATOMIC_RELEASE);
+
+        while (::syscall(__NR_io_uring_enter, _ringFileDescriptor, 1u, 0u, 0u, nullptr, 0) < 0)
+        {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                // The entry stays in the ring, the request cannot be taken back
+                throw std::runtime_error(std::string("Could not submit to io_uring: ") + std::strerror(errno));
+            }
+        }
+
+        _numberInFlight++;
+    }
+
+    IOCompletion wait() override {
+        if (_numberInFlight == 0)
+            throw std::logic_error("No I/O request is in flight.");
+
+        while (true)
+        {
+            // This thread is the only one that removes completions, the kernel only adds them
+            const unsigned head = *_completionHead;
+
+            if (head != __atomic_load_n(_completionTail, __ATOMIC_ACQUIRE))
+            {
+                const io_uring_cqe& completion = _completions[head & _completionMask];
+                const IOCompletion result = { completion.user_data, completion.res };
+
+                __atomic_store_n(_completionHead, head + 1, __ATOMIC_RELEASE);
+
+                _numberInFlight--;
+
+                return result;
+            }
+
+            if (::syscall(__NR_io_uring_enter, _ringFileDescriptor, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                throw std::runtime_error(std::string("Could not wait for io_uring: ") + std::strerror(errno));
+        }
+    }
+
+private:
+    void* map(std::size_t size, off_t offset) const {
+        void* const address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFileDescriptor, offset);
+
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    void unmap() {
+        if (_entries != nullptr)
+            ::munmap(_entries, _entriesSize);
+
+        if (_completionRing != nullptr && _completionRing != _submissionRing)
+            ::munmap(_completionRing, _completionRingSize);
+
+        if (_submissionRing != nullptr)
+            ::munmap(_submissionRing, _submissionRingSize);
+    }
+
+    int             _ringFileDescriptor = -1;
+    void*           _submissionRing     = nullptr;
+    void*           _completionRing     = nullptr;      // Same as the submission ring with a single mapping
+    io_uring_sqe*   _entries            = nullptr;
+    std::size_t     _submissionRingSize = 0;
+    std::size_t     _completionRingSize = 0;
+    std::size_t     _entriesSize        = 0;
+    unsigned*       _submissionTail     = nullptr;
+    unsigned        _submissionMask     = 0;
+    unsigned*       _submissionArray    = nullptr;
+    unsigned*       _completionHead     = nullptr;
+    unsigned*       _completionTail     = nullptr;
+    unsigned        _completionMask     = 0;
+    io_uring_cqe*   _completions        = nullptr;
+};
+
+#endif
+
+}
+
+int openDirectFile(const std::filesystem::path& filePath, bool write, bool& isDirect)
+{
+    const int flags = write ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY;
+
+    int fileDescriptor = -1;
+
+#ifdef O_DIRECT
+    fileDescriptor = ::open(filePath.c_str(), flags | O_DIRECT, 0644);
+
+    isDirect = fileDescriptor >= 0;
+
+    // File systems without direct I/O refuse the flag
+    if (fileDescriptor < 0 && errno == EINVAL)
+        fileDescriptor = ::open(filePath.c_str(), flags, 0644);
+#else
+    fileDescriptor = ::open(filePath.c_str(), flags, 0644);
+
+    isDirect = false;
+
+    #ifdef F_NOCACHE
+        isDirect = fileDescriptor >= 0 && ::fcntl(fileDescriptor, F_NOCACHE, 1) == 0;
+    #endif
+#endif
+
+    if (fileDescriptor < 0)
+        throw std::runtime_error(std::string(write ? "Could not create the file: " : "File was not found at location: ") + std::strerror(errno));
+
+    return fileDescriptor;
+}
+
+std::unique_ptr<IOQueue> createIOQueue(std::size_t queueDepth)
+{
+    queueDepth = std::max<std::size_t>(queueDepth, 1);
+
+#ifdef BINIO_HAS_IO_URING
+    const char* const queueType = std::getenv("BINIO_IO_QUEUE");
+
+    if (queueType == nullptr || std::string(queueType) != "threads")
+    {
+        // Containers and older kernels may not offer io_uring
+        try
+        {
+            return std::make_unique<IoUringQueue>(queueDepth);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+    }
+#endif
+
+    return std::make_unique<ThreadPoolQueue>(queueDepth);
+}
+
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <new>
+
+/**
+ * Asynchronous direct file I/O
+ *
+ * Direct reads and writes bypass the page cache (O_DIRECT on Linux,
+ * F_NOCACHE on macOS), so that streaming through a large file neither evicts
+ * the cached files of other programs nor copies every byte through the
+ * cache. On Linux they need buffers, offsets and sizes that are multiples of
+ * ioAlignment. Fast storage only reaches its bandwidth with several requests
+ * in flight, which an IOQueue keeps: through io_uring where the kernel
+ * offers it, or else through a pool of threads that run positional reads and
+ * writes. Setting the environment variable BINIO_IO_QUEUE to "threads" uses
+ * the pool of threads everywhere.
+ *
+ * Not available on Windows, where the direct read and write methods fall
+ * back to buffered I/O.
+ */
+
+/** Alignment of the buffers, offsets and sizes of direct I/O, a multiple of the logical block size of common devices */
+constexpr std::size_t ioAlignment = 4096;
+
+/** Size in bytes of one request of direct I/O */
+constexpr std::size_t ioRequestSize = std::size_t(1) << 20;
+
+/** Number of requests of direct I/O that are in flight at once per queue */
+constexpr std::size_t ioQueueDepth = 8;
+
+/** Round value down to a multiple of ioAlignment */
+constexpr std::uint64_t alignDown(std::uint64_t value)
+{
+    return value / ioAlignment * ioAlignment;
+}
+
+/** Round value up to a multiple of ioAlignment */
+constexpr std::uint64_t alignUp(std::uint64_t value)
+{
+    return alignDown(value + ioAlignment - 1);
+}
+
+/** Frees buffers of allocateAlignedBuffer */
+struct AlignedBufferDeleter
+{
+    void operator()(char* buffer) const {
+        ::operator delete[](buffer, std::align_val_t(ioAlignment));
+    }
+};
+
+/** Buffer whose address is a multiple of ioAlignment */
+using AlignedBuffer = std::unique_ptr<char[], AlignedBufferDeleter>;
+
+/** Allocate an uninitialized buffer of size bytes at a multiple of ioAlignment */
+AlignedBuffer allocateAlignedBuffer(std::size_t size);
+
+/*! Open a file for direct I/O
+ *
+ * File systems without direct I/O (such as tmpfs) get a file descriptor of
+ * buffered I/O instead. Throws std::runtime_error when the file cannot be
+ * opened, and on Windows.
+ *
+ * \param filePath Path of the file
+ * \param write Whether the file is created or truncated for writing, otherwise it is opened for reading
+ * \param isDirect Set to whether the file descriptor bypasses the page cache
+ * \return File descriptor, which the caller closes
+*/
+int openDirectFile(const std::filesystem::path& filePath, bool write, bool& isDirect);
+
+/** Read or write of an IOQueue */
+struct IORequest
+{
+    int             fileDescriptor  = -1;
+    char*           buffer          = nullptr;      /** Bytes to write, or destination of the read */
+    std::size_t     size            = 0;            /** Number of bytes */
+    std::uint64_t   offset          = 0;            /** Offset in bytes from the start of the file */
+    bool            isWrite         = false;
+    std::uint64_t   tag             = 0;            /** Identifies the request in its completion */
+};
+
+/** Completion of an IORequest */
+struct IOCompletion
+{
+    std::uint64_t   tag     = 0;        /** Tag of the request */
+    std::int64_t    result  = 0;        /** Number of bytes transferred, which may be fewer than requested, or -errno */
+};
+
+/**
+ * Queue of asynchronous reads and writes
+ *
+ * Requests complete in any order. A queue is used by one thread at a time,
+ * which submits the requests and waits for their completions.
+ */
+class IOQueue
+{
+public:
+    explicit IOQueue(std::size_t queueDepth) : _queueDepth(queueDepth) { }
+
+    virtual ~IOQueue() = default;
+
+    /** Get the name of the mechanism that runs the requests, "io_uring" or "threads" */
+    virtual const char* getName() const = 0;
+
+    /** Get the maximum number of requests in flight */
+    std::size_t getQueueDepth() const {
+        return _queueDepth;
+    }
+
+    /** Get the number of submitted requests whose completion was not waited for */
+    std::size_t getNumberInFlight() const {
+        return _numberInFlight;
+    }
+
+    /*! Submit a request, whose buffer stays valid until it completed
+     *
+     * Throws std::logic_error when getQueueDepth() requests are in flight
+     * and std::runtime_error when the request cannot be submitted.
+     *
+     * \param request Read or write to submit
+    */
+    virtual void submit(const IORequest& request) = 0;
+
+    /** Wait for the completion of a submitted request, throws std::logic_error when none is in flight */
+    virtual IOCompletion wait() = 0;
+
+protected:
+    std::size_t     _queueDepth;            /** Maximum number of requests in flight */
+    std::size_t     _numberInFlight = 0;    /** Number of submitted requests whose completion was not waited for */
+};
+
+/*! Create a queue of asynchronous reads and writes
+ *
+ * Uses io_uring when the kernel offers it (Linux 5.7 and later), otherwise
+ * a pool of queueDepth threads. Throws std::runtime_error on Windows.
+ *
+ * \param queueDepth Maximum number of requests in flight
+*/
+std::unique_ptr<IOQueue> createIOQueue(std::size_t queueDepth);
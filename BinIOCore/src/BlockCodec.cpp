@@ -0,0 +1,344 @@
+#include "BlockCodec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t   minMatchLength  = 4;
+constexpr std::size_t   maxOffset       = 65535;
+constexpr std::size_t   lastLiterals    = 5;        // The last bytes of a block are always literals
+constexpr std::size_t   minInputSize    = 13;       // Smaller inputs are stored as literals only
+constexpr unsigned      hashBits        = 14;
+
+inline std::uint32_t read32(const std::uint8_t* bytes)
+{
+    std::uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+inline std::uint32_t hash(std::uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+// Writes the extra bytes of a length that does not fit in its token nibble
+inline std::uint8_t* writeLength(std::uint8_t* output, std::size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *output++ = 255;
+
+    *output++ = static_cast<std::uint8_t>(length);
+    return output;
+}
+
+// Writes one sequence, returns nullptr when it does not fit before outputEnd
+std::uint8_t* writeSequence(std::uint8_t* output, const std::uint8_t* outputEnd, const std::uint8_t* literals, std::size_t numLiterals, std::size_t offset, std::size_t matchLength)
+{
+    if (static_cast<std::size_t>(outputEnd - output) < 1 + numLiterals / 255 + 1 + numLiterals + 2 + matchLength / 255 + 1)
+        return nullptr;
+
+    std::uint8_t* const token = output++;
+
+    *token = static_cast<std::uint8_t>((numLiterals < 15 ? numLiterals : 15) << 4);
+
+    if (numLiterals >= 15)
+        output = writeLength(output, numLiterals - 15);
+
+    if (numLiterals > 0)
+        std::memcpy(output, literals, numLiterals);
+
+    output += numLiterals;
+
+    // The last sequence has no match
+    if (matchLength == 0)
+        return output;
+
+    *output++ = static_cast<std::uint8_t>(offset & 0xFF);
+    *output++ = static_cast<std::uint8_t>(offset >> 8);
+
+    const std::size_t extraLength = matchLength - minMatchLength;
+
+    *token |= static_cast<std::uint8_t>(extraLength < 15 ? extraLength : 15);
+
+    if (extraLength >= 15)
+        output = writeLength(output, extraLength - 15);
+
+    return output;
+}
+
+// A compile-time element size lets the compiler vectorize the (un)shuffle loops
+template <std::size_t ElementSize>
+void shuffle(const char* input, char* output, std::size_t count)
+{
+    for (std::size_t byteIndex = 0; byteIndex < ElementSize; byteIndex++)
+        for (std::size_t elementIndex = 0; elementIndex < count; elementIndex++)
+            output[byteIndex * count + elementIndex] = input[elementIndex * ElementSize + byteIndex];
+}
+
+template <std::size_t ElementSize>
+void unshuffle(const char* input, char* output, std::size_t count)
+{
+    for (std::size_t elementIndex = 0; elementIndex < count; elementIndex++)
+        for (std::size_t byteIndex = 0; byteIndex < ElementSize; byteIndex++)
+            output[elementIndex * ElementSize + byteIndex] = input[byteIndex * count + elementIndex];
+}
+
+// Reads the extra bytes of a length whose token nibble is 15
+inline std::size_t readLength(const std::uint8_t*& input, const std::uint8_t* inputEnd)
+{
+    std::size_t length = 0;
+    std::uint8_t byte;
+
+    do
+    {
+        if (input >= inputEnd)
+            throw std::runtime_error("Corrupt compressed block.");
+
+        byte = *input++;
+        length += byte;
+    } while (byte == 255);
+
+    return length;
+}
+
+}
+
+std::size_t getEncodedBlockBound(std::size_t rawSize)
+{
+    return rawSize + rawSize / 255 + 16;
+}
+
+void shuffleBytes(const char* input, char* output, std::size_t count, std::size_t elementSize)
+{
+    switch (elementSize)
+    {
+        case 1: std::memcpy(output, input, count); break;
+        case 2: shuffle<2>(input, output, count); break;
+        case 4: shuffle<4>(input, output, count); break;
+        case 8: shuffle<8>(input, output, count); break;
+
+        default:
+            for (std::size_t byteIndex = 0; byteIndex < elementSize; byteIndex++)
+                for (std::size_t elementIndex = 0; elementIndex < count; elementIndex++)
+                    output[byteIndex * count + elementIndex] = input[elementIndex * elementSize + byteIndex];
+    }
+}
+
+void unshuffleBytes(const char* input, char* output, std::size_t count, std::size_t elementSize)
+{
+    switch (elementSize)
+    {
+        case 1: std::memcpy(output, input, count); break;
+        case 2: unshuffle<2>(input, output, count); break;
+        case 4: unshuffle<4>(input, output, count); break;
+        case 8: unshuffle<8>(input, output, count); break;
+
+        default:
+            for (std::size_t byteIndex = 0; byteIndex < elementSize; byteIndex++)
+                for (std::size_t elementIndex = 0; elementIndex < count; elementIndex++)
+                    output[elementIndex * elementSize + byteIndex] = input[byteIndex * count + elementIndex];
+    }
+}
+
+std::size_t compressLZ(const char* input, std::size_t size, char* output, std::size_t capacity)
+{
+    const auto* const begin     = reinterpret_cast<const std::uint8_t*>(input);
+    const auto* const end       = begin + size;
+    auto* op                    = reinterpret_cast<std::uint8_t*>(output);
+    const auto* const outputEnd = op + capacity;
+
+    const std::uint8_t* anchor  = begin;
+
+    if (size >= minInputSize)
+    {
+        // Matches start before matchLimit and end before matchEnd, which leaves literals at the end
+        const std::uint8_t* const matchLimit    = end - minInputSize + 1;
+        const std::uint8_t* const matchEnd      = end - lastLiterals;
+
+        std::vector<std::uint32_t> table(std::size_t(1) << hashBits, 0);
+
+        const std::uint8_t* ip = begin;
+
+        while (ip < matchLimit)
+        {
+            const std::uint32_t sequence    = read32(ip);
+            const std::uint32_t hashValue   = hash(sequence);
+            const std::uint8_t* reference   = begin + table[hashValue];
+
+            table[hashValue] = static_cast<std::uint32_t>(ip - begin);
+
+            if (reference >= ip || static_cast<std::size_t>(ip - reference) > maxOffset || read32(reference) != sequence)
+            {
+                // Step faster through data that does not compress
+                ip += 1 + (static_cast<std::size_t>(ip - anchor) >> 6);
+                continue;
+            }
+
+            // Extend the match forward, then backward over the pending literals
+            std::size_t matchLength = minMatchLength;
+
+            while (ip + matchLength < matchEnd && ip[matchLength] == reference[matchLength])
+                matchLength++;
+
+            while (ip > anchor && reference > begin && ip[-1] == reference[-1])
+            {
+                ip--;
+                reference--;
+                matchLength++;
+            }
+
+            op = writeSequence(op, outputEnd, anchor, static_cast<std::size_t>(ip - anchor), static_cast<std::size_t>(ip - reference), matchLength);
+
+            if (op == nullptr)
+                return 0;
+
+            ip += matchLength;
+            anchor = ip;
+
+            // Remember a position inside the match, which helps runs of repeated data
+            if (ip < matchLimit)
+                table[hash(read32(ip - 2))] = static_cast<std::uint32_t>(ip - 2 - begin);
+        }
+    }
+
+    op = writeSequence(op, outputEnd, anchor, static_cast<std::size_t>(end - anchor), 0, 0);
+
+    if (op == nullptr)
+        return 0;
+
+    return static_cast<std::size_t>(op - reinterpret_cast<std::uint8_t*>(output));
+}
+
+void decompressLZ(const char* input, std::size_t size, char* output, std::size_t outputSize)
+{
+    const auto* ip              = reinterpret_cast<const std::uint8_t*>(input);
+    const auto* const inputEnd  = ip + size;
+    auto* const begin           = reinterpret_cast<std::uint8_t*>(output);
+    auto* op                    = begin;
+    const auto* const outputEnd = begin + outputSize;
+
+    while (true)
+    {
+        if (ip >= inputEnd)
+            throw std::runtime_error("Corrupt compressed block.");
+
+        const std::uint8_t token = *ip++;
+
+        std::size_t numLiterals = token >> 4;
+
+        if (numLiterals == 15)
+            numLiterals += readLength(ip, inputEnd);
+
+        if (numLiterals > static_cast<std::size_t>(inputEnd - ip) || numLiterals > static_cast<std::size_t>(outputEnd - op))
+            throw std::runtime_error("Corrupt compressed block.");
+
+        // Short literal runs are copied as one 16 byte word when there is room for the overshoot, which later sequences overwrite
+        if (numLiterals <= 16 && inputEnd - ip >= 16 && outputEnd - op >= 16)
+            std::memcpy(op, ip, 16);
+        else
+            std::memcpy(op, ip, numLiterals);
+
+        ip += numLiterals;
+        op += numLiterals;
+
+        // The last sequence ends with its literals
+        if (ip == inputEnd)
+            break;
+
+        if (inputEnd - ip < 2)
+            throw std::runtime_error("Corrupt compressed block.");
+
+        const std::size_t offset = static_cast<std::size_t>(ip[0]) | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > static_cast<std::size_t>(op - begin))
+            throw std::runtime_error("Corrupt compressed block.");
+
+        std::size_t matchLength = token & 15;
+
+        if (matchLength == 15)
+            matchLength += readLength(ip, inputEnd);
+
+        matchLength += minMatchLength;
+
+        if (matchLength > static_cast<std::size_t>(outputEnd - op))
+            throw std::runtime_error("Corrupt compressed block.");
+
+        const std::uint8_t* match = op - offset;
+
+        // Distant matches are copied in 16 byte words, overlapping matches repeat the last offset bytes and are copied byte by byte
+        if (offset >= 16 && static_cast<std::size_t>(outputEnd - op) >= matchLength + 16)
+        {
+            for (std::size_t i = 0; i < matchLength; i += 16)
+                std::memcpy(op + i, match + i, 16);
+
+            op += matchLength;
+        }
+        else if (offset >= matchLength)
+        {
+            std::memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < matchLength; i++)
+                *op++ = *match++;
+        }
+    }
+
+    if (op != outputEnd)
+        throw std::runtime_error("Corrupt compressed block.");
+}
+
+std::size_t encodeBlock(const char* raw, std::size_t rawSize, std::size_t elementSize, BlockCodec codec, BlockFilter filter, char* encoded, char* scratch)
+{
+    if (codec == BlockCodec::LZ && rawSize > 0)
+    {
+        const char* input = raw;
+
+        if (filter == BlockFilter::ByteShuffle)
+        {
+            shuffleBytes(raw, scratch, rawSize / elementSize, elementSize);
+            input = scratch;
+        }
+
+        // Only keep the compressed block when it is smaller, a block of rawSize bytes is stored as is
+        const std::size_t encodedSize = compressLZ(input, rawSize, encoded, rawSize - 1);
+
+        if (encodedSize > 0)
+            return encodedSize;
+    }
+
+    if (rawSize > 0)
+        std::memcpy(encoded, raw, rawSize);
+
+    return rawSize;
+}
+
+void decodeBlock(const char* encoded, std::size_t encodedSize, char* raw, std::size_t rawSize, std::size_t elementSize, BlockCodec codec, BlockFilter filter, char* scratch)
+{
+    if (encodedSize == rawSize)
+    {
+        if (rawSize > 0)
+            std::memcpy(raw, encoded, rawSize);
+
+        return;
+    }
+
+    if (codec != BlockCodec::LZ || encodedSize > rawSize)
+        throw std::runtime_error("Corrupt compressed block.");
+
+    if (filter == BlockFilter::ByteShuffle && elementSize > 1)
+    {
+        decompressLZ(encoded, encodedSize, scratch, rawSize);
+        unshuffleBytes(scratch, raw, rawSize / elementSize, elementSize);
+    }
+    else
+    {
+        decompressLZ(encoded, encodedSize, raw, rawSize);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FileFormat.h"
+
+#include <cstddef>
+
+/**
+ * Block filters and compression codecs of block-compressed files
+ *
+ * The LZ codec is a byte-oriented LZ77 variant in the spirit of LZ4: a
+ * sequence of a token, literals and a back reference of at most 64 KB. It
+ * favours speed over ratio, so decoding keeps up with fast disks, and it is
+ * built into the plugins, so no external compression library is needed.
+ *
+ *   token       high 4 bits literal length, low 4 bits match length - 4,
+ *               15 means that bytes of 255 (and a final smaller byte) follow
+ *   literals    literal length bytes
+ *   offset      2 bytes, little-endian distance of the match (not in the last sequence)
+ *
+ * The last sequence of a block only holds literals.
+ */
+
+/** Get the maximum size of encodeBlock output for rawSize input bytes */
+std::size_t getEncodedBlockBound(std::size_t rawSize);
+
+/*! Filter and compress one block
+ *
+ * When compression does not make the block smaller, it is stored as is, so
+ * the encoded size never exceeds rawSize.
+ *
+ * \param raw Raw block of rawSize bytes
+ * \param rawSize Size of the raw block, a multiple of elementSize
+ * \param elementSize Size in bytes of one element, the unit of the byte shuffle
+ * \param codec Compression codec
+ * \param filter Filter applied before compressing
+ * \param encoded Output buffer of at least getEncodedBlockBound(rawSize) bytes
+ * \param scratch Buffer of at least rawSize bytes
+ * \return Size of the encoded block in bytes
+*/
+std::size_t encodeBlock(const char* raw, std::size_t rawSize, std::size_t elementSize, BlockCodec codec, BlockFilter filter, char* encoded, char* scratch);
+
+/*! Decompress and unfilter one block
+ *
+ * Throws std::runtime_error when the encoded block is corrupt.
+ *
+ * \param encoded Encoded block of encodedSize bytes
+ * \param encodedSize Size of the encoded block
+ * \param raw Output buffer of rawSize bytes
+ * \param rawSize Size of the raw block, a multiple of elementSize
+ * \param elementSize Size in bytes of one element, the unit of the byte shuffle
+ * \param codec Compression codec
+ * \param filter Filter applied before compressing
+ * \param scratch Buffer of at least rawSize bytes
+*/
+void decodeBlock(const char* encoded, std::size_t encodedSize, char* raw, std::size_t rawSize, std::size_t elementSize, BlockCodec codec, BlockFilter filter, char* scratch);
+
+/** Group byte k of all count elements of elementSize bytes together */
+void shuffleBytes(const char* input, char* output, std::size_t count, std::size_t elementSize);
+
+/** Undo shuffleBytes */
+void unshuffleBytes(const char* input, char* output, std::size_t count, std::size_t elementSize);
+
+/*! Compress size bytes with the LZ codec
+ *
+ * \return Size of the compressed data, or 0 when it does not fit in capacity bytes
+*/
+std::size_t compressLZ(const char* input, std::size_t size, char* output, std::size_t capacity);
+
+/** Decompress LZ data into exactly outputSize bytes, throws std::runtime_error when the data is corrupt */
+void decompressLZ(const char* input, std::size_t size, char* output, std::size_t outputSize);
@@ -0,0 +1,123 @@
+#include "Checksum.h"
+
+#include "ConversionKernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t prime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+// Checksums are defined on little-endian words, whatever the byte order of the machine
+template <typename Word>
+Word readWord(const char* bytes)
+{
+    Word word;
+    std::memcpy(&word, bytes, sizeof(Word));
+
+    if constexpr (std::endian::native == std::endian::big)
+        return swapBytes(word);
+    else
+        return word;
+}
+
+std::uint64_t mixLane(std::uint64_t accumulator, std::uint64_t input)
+{
+    return std::rotl(accumulator + input * prime2, 31) * prime1;
+}
+
+std::uint64_t mergeLane(std::uint64_t hash, std::uint64_t accumulator)
+{
+    return (hash ^ mixLane(0, accumulator)) * prime1 + prime4;
+}
+
+}
+
+std::uint64_t computeChecksum(const char* bytes, std::size_t size)
+{
+    const char* const end = bytes + size;
+
+    std::uint64_t hash;
+
+    // Four independent lanes take 32 bytes per step
+    if (size >= 32)
+    {
+        std::uint64_t lane1 = prime1 + prime2;
+        std::uint64_t lane2 = prime2;
+        std::uint64_t lane3 = 0;
+        std::uint64_t lane4 = 0 - prime1;
+
+        for (; end - bytes >= 32; bytes += 32)
+        {
+            lane1 = mixLane(lane1, readWord<std::uint64_t>(bytes));
+            lane2 = mixLane(lane2, readWord<std::uint64_t>(bytes + 8));
+            lane3 = mixLane(lane3, readWord<std::uint64_t>(bytes + 16));
+            lane4 = mixLane(lane4, readWord<std::uint64_t>(bytes + 24));
+        }
+
+        hash = std::rotl(lane1, 1) + std::rotl(lane2, 7) + std::rotl(lane3, 12) + std::rotl(lane4, 18);
+        hash = mergeLane(hash, lane1);
+        hash = mergeLane(hash, lane2);
+        hash = mergeLane(hash, lane3);
+        hash = mergeLane(hash, lane4);
+    }
+    else
+    {
+        hash = prime5;
+    }
+
+    hash += size;
+
+    for (; end - bytes >= 8; bytes += 8)
+        hash = std::rotl(hash ^ mixLane(0, readWord<std::uint64_t>(bytes)), 27) * prime1 + prime4;
+
+    if (end - bytes >= 4)
+    {
+        hash = std::rotl(hash ^ (readWord<std::uint32_t>(bytes) * prime1), 23) * prime2 + prime3;
+        bytes += 4;
+    }
+
+    for (; bytes < end; bytes++)
+        hash = std::rotl(hash ^ (static_cast<std::uint8_t>(*bytes) * prime5), 11) * prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+void verifyBlockChecksum(const BlockChecksums& checksums, std::size_t blockNumber, const char* bytes, std::size_t size)
+{
+    if (blockNumber >= checksums.checksums.size())
+        throw std::runtime_error("Block " + std::to_string(blockNumber) + " of the data has no checksum.");
+
+    if (computeChecksum(bytes, size) != checksums.checksums[blockNumber])
+        throw std::runtime_error("Block " + std::to_string(blockNumber) + " of the data does not match its checksum, the file is corrupt.");
+}
+
+void verifyChecksums(const BlockChecksums& checksums, std::uint64_t position, const char* bytes, std::size_t size)
+{
+    const std::uint64_t blockSize = checksums.blockSize;
+
+    for (std::size_t offset = 0; offset < size; offset += static_cast<std::size_t>(blockSize))
+    {
+        const std::size_t blockBytes = static_cast<std::size_t>(std::min<std::uint64_t>(blockSize, size - offset));
+
+        // A range that stops inside a block cannot be checked, only the end of the data ends a block early
+        if (blockBytes < blockSize && position + offset + blockBytes != checksums.dataSize)
+            throw std::invalid_argument("Checksums are verified for whole blocks only.");
+
+        verifyBlockChecksum(checksums, static_cast<std::size_t>((position + offset) / blockSize), bytes + offset, blockBytes);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "FileFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Checksums of the blocks of a file
+ *
+ * Every block of data gets a 64-bit XXH64 checksum (seed 0), a fast
+ * non-cryptographic hash that runs at several GB/s per thread. The writer
+ * computes the checksum of every block on the worker that gathered (and
+ * compressed) it, the loader verifies the blocks on the workers that read
+ * them, before they are converted, so a corrupt or truncated file fails at
+ * its first bad block. See FileFormat.h for the layout of the section.
+ */
+
+/** Get the XXH64 checksum (seed 0) of size bytes */
+std::uint64_t computeChecksum(const char* bytes, std::size_t size);
+
+/*! Verify the checksum of one block
+ *
+ * Throws std::runtime_error when the block has no checksum or its bytes do
+ * not match it.
+ *
+ * \param checksums Checksums of the file
+ * \param blockNumber Number of the block: a block of the block index of block-compressed data, or of checksums.blockSize bytes of uncompressed data
+ * \param bytes Bytes of the block as stored
+ * \param size Size of the block in bytes
+*/
+void verifyBlockChecksum(const BlockChecksums& checksums, std::size_t blockNumber, const char* bytes, std::size_t size);
+
+/*! Verify the blocks of uncompressed data in a range of bytes
+ *
+ * Throws std::runtime_error at the first block that does not match.
+ *
+ * \param checksums Checksums of the file, checksums.blockSize must not be 0
+ * \param position Position of the first byte relative to the start of the data, a multiple of checksums.blockSize
+ * \param bytes Bytes of whole blocks: the range ends at a block boundary or at the end of the data
+ * \param size Size of the range in bytes
+*/
+void verifyChecksums(const BlockChecksums& checksums, std::uint64_t position, const char* bytes, std::size_t size);
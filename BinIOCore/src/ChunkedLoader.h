@@ -0,0 +1,671 @@
+#pragma once
+
+#include "BlockCodec.h"
+#include "Checksum.h"
+#include "ConversionKernels.h"
+#include "FileFormat.h"
+#include "FileReader.h"
+#include "Parallel.h"
+#include "Selection.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Thrown by the load functions when the load is cancelled through LoadProgress::cancel */
+class LoadCancelled : public std::runtime_error
+{
+public:
+    LoadCancelled() : std::runtime_error("The load was cancelled.") { }
+};
+
+/**
+ * Progress and cancellation of a load
+ *
+ * Worker threads add every chunk they finished and stop at the next chunk
+ * once any thread called cancel(). The callback is called on the worker
+ * thread that finished the chunk, so it should return quickly.
+ */
+class LoadProgress
+{
+public:
+    /** Called as callback(bytesRead, rowsLoaded) with the totals so far */
+    using Callback = std::function<void(std::uint64_t, std::uint64_t)>;
+
+    explicit LoadProgress(Callback callback = {}) : _callback(std::move(callback)) { }
+
+    /** Stop the load, the load function throws LoadCancelled */
+    void cancel() {
+        _cancelled = true;
+    }
+
+    /** Whether the load was cancelled */
+    bool isCancelled() const {
+        return _cancelled;
+    }
+
+    /** Throw LoadCancelled when the load was cancelled */
+    void throwIfCancelled() const {
+        if (_cancelled)
+            throw LoadCancelled();
+    }
+
+    /** Add a finished chunk of bytesRead bytes from the file that completed rowsLoaded rows */
+    void addChunk(std::uint64_t bytesRead, std::uint64_t rowsLoaded) {
+        const std::uint64_t totalBytesRead  = _bytesRead += bytesRead;
+        const std::uint64_t totalRowsLoaded = _rowsLoaded += rowsLoaded;
+
+        if (_callback)
+            _callback(totalBytesRead, totalRowsLoaded);
+    }
+
+    /** Get the number of bytes read from the file so far */
+    std::uint64_t getBytesRead() const {
+        return _bytesRead;
+    }
+
+    /** Get the number of rows loaded so far */
+    std::uint64_t getRowsLoaded() const {
+        return _rowsLoaded;
+    }
+
+private:
+    Callback                    _callback;
+    std::atomic<std::uint64_t>  _bytesRead  = 0;
+    std::atomic<std::uint64_t>  _rowsLoaded = 0;
+    std::atomic<bool>           _cancelled  = false;
+};
+
+/** Settings of the chunked, multi-threaded load pipeline */
+struct ChunkedLoadSettings
+{
+    std::size_t                 numberOfThreads = 0;                        /** Number of worker threads, 0 uses all hardware threads */
+    std::size_t                 bufferSize      = std::size_t(256) << 20;   /** Upper bound of raw bytes held at once, over all threads */
+    std::size_t                 mergeGap        = 4096;                     /** Largest gap in bytes between selected columns that is read rather than skipped */
+    LoadProgress*               progress        = nullptr;                  /** Receives the progress and cancels the load, optional */
+    PipelineStats*              stats           = nullptr;                  /** Receives the thread count, buffer memory and task times, optional */
+    const QuantizationTable*    quantization    = nullptr;                  /** Scale and offset of every file column of quantized data, whose codes are dequantized, optional */
+    StatisticsCollector*        statistics      = nullptr;                  /** Receives the statistics of every loaded column, gathered while converting, optional */
+    const BlockChecksums*       checksums       = nullptr;                  /** Checksums that the read bytes are verified against before they are converted, optional; loads of whole rows and of compressed blocks verify them */
+    std::uint64_t               checksumOffset  = 0;                        /** Offset in bytes in the file of the data the checksums cover */
+};
+
+/** Throw LoadCancelled when the load of settings was cancelled, called before every chunk */
+inline void throwIfCancelled(const ChunkedLoadSettings& settings)
+{
+    if (settings.progress != nullptr)
+        settings.progress->throwIfCancelled();
+}
+
+/** Get an accumulator of the statistics of a chunk of rows of numColumns columns when settings collect statistics */
+inline std::optional<StatisticsAccumulator> makeChunkStatistics(const ChunkedLoadSettings& settings, std::size_t numColumns)
+{
+    if (settings.statistics == nullptr)
+        return std::nullopt;
+
+    return StatisticsAccumulator(numColumns);
+}
+
+/** Merge the statistics of a finished chunk into the statistics of settings, if any */
+inline void addChunkStatistics(const ChunkedLoadSettings& settings, const std::optional<StatisticsAccumulator>& accumulator)
+{
+    if (accumulator)
+        settings.statistics->merge(*accumulator);
+}
+
+/** Get the range of whole checksum blocks that holds size bytes at offset in the file, the range itself without checksums */
+inline std::pair<std::uint64_t, std::uint64_t> getChecksumRange(const ChunkedLoadSettings& settings, std::uint64_t offset, std::uint64_t size)
+{
+    if (settings.checksums == nullptr)
+        return { offset, size };
+
+    const std::uint64_t blockSize   = settings.checksums->blockSize;
+    const std::uint64_t first       = (offset - settings.checksumOffset) / blockSize * blockSize;
+    const std::uint64_t end         = std::min((offset - settings.checksumOffset + size + blockSize - 1) / blockSize * blockSize, settings.checksums->dataSize);
+
+    return { settings.checksumOffset + first, end - first };
+}
+
+/** Report a finished chunk to the progress of settings, if any */
+inline void addChunkProgress(const ChunkedLoadSettings& settings, std::uint64_t bytesRead, std::uint64_t rowsLoaded)
+{
+    if (settings.progress != nullptr)
+        settings.progress->addChunk(bytesRead, rowsLoaded);
+}
+
+/*! Convert count elements of consecutive file columns, starting at firstColumn, into destination
+ *
+ * Codes of quantized data (settings.quantization) are dequantized with the
+ * scale and offset of their columns, other data is converted as is.
+*/
+template <typename Source, typename Destination>
+void convertColumns(const char* source, Destination* destination, std::size_t count, std::size_t firstColumn, const ChunkedLoadSettings& settings)
+{
+    if (settings.quantization == nullptr)
+    {
+        convertElements<Source>(source, destination, count);
+    }
+    else if constexpr (std::is_same_v<Source, std::uint8_t> || std::is_same_v<Source, std::uint16_t> || std::is_same_v<Source, ByteSwapped<std::uint16_t>>)
+    {
+        dequantizeElements<Source>(source, destination, count, settings.quantization->scales.data() + firstColumn, settings.quantization->offsets.data() + firstColumn);
+    }
+    else
+    {
+        throw std::invalid_argument("Quantized data must be stored as uint8 or uint16 codes.");
+    }
+}
+
+/*! Convert numRows whole rows of numColumns elements into destination, see convertColumns
+ *
+ * With an accumulator, the rows are converted in groups that fit the cache,
+ * and every group is added to the statistics right after it was converted.
+*/
+template <typename Source, typename Destination>
+void convertRows(const char* source, Destination* destination, std::size_t numRows, std::size_t numColumns, const ChunkedLoadSettings& settings, std::optional<StatisticsAccumulator>& accumulator)
+{
+    const std::size_t rowsPerGroup = accumulator ? std::max<std::size_t>(1, (std::size_t(64) << 10) / (numColumns * sizeof(Destination))) : numRows;
+
+    for (std::size_t firstRow = 0; firstRow < numRows; firstRow += rowsPerGroup)
+    {
+        const std::size_t numGroupRows  = std::min(rowsPerGroup, numRows - firstRow);
+        const char* const groupSource   = source + firstRow * numColumns * sizeof(Source);
+        Destination* const groupOutput  = destination + firstRow * numColumns;
+
+        if (settings.quantization == nullptr)
+        {
+            convertElements<Source>(groupSource, groupOutput, numGroupRows * numColumns);
+        }
+        else
+        {
+            for (std::size_t row = 0; row < numGroupRows; row++)
+                convertColumns<Source>(groupSource + row * numColumns * sizeof(Source), groupOutput + row * numColumns, numColumns, 0, settings);
+        }
+
+        if (accumulator)
+            accumulator->addRows(groupOutput, numGroupRows);
+    }
+}
+
+/*! Read and convert numRows rows of numColumns Source elements into destination
+ *
+ * The rows are split into row-aligned chunks that worker threads read and
+ * convert concurrently, each into its own slice of destination. When the
+ * reader can expose bytes in place (memory map) they are converted without a
+ * scratch copy and released afterwards; when Source and Destination match
+ * and the data is not quantized, the bytes are read straight into destination.
+ *
+ * The file is streamed: chunks are sized so that all threads together never
+ * hold more than settings.bufferSize raw bytes, unless a single row is larger
+ * than that. The thread count is reduced if the buffer cannot give every
+ * thread at least one row.
+ *
+ * With settings.checksums, every chunk verifies the checksum blocks it holds
+ * before it converts them. Chunks hold whole blocks where they can, with the
+ * thread count reduced so that the blocks of all threads fit the buffer,
+ * unless a single block is larger than that. A chunk that starts or ends
+ * inside a block, when blocks do not hold whole rows, also reads the rest of
+ * that block.
+ *
+ * \param reader File to read from
+ * \param dataOffset Offset in bytes of the first row in the file
+ * \param numRows Number of rows to read
+ * \param numColumns Number of elements per row
+ * \param destination Buffer of at least numRows * numColumns elements
+ * \param settings Thread count, raw buffer size and progress
+*/
+template <typename Source, typename Destination>
+void loadRowsInParallel(const FileReader& reader, std::uint64_t dataOffset, std::size_t numRows, std::size_t numColumns, Destination* destination, const ChunkedLoadSettings& settings)
+{
+    if (numRows == 0 || numColumns == 0)
+        return;
+
+    const std::size_t rowSize   = numColumns * sizeof(Source);
+    std::size_t numberOfThreads = std::clamp<std::size_t>(settings.bufferSize / rowSize, 1, resolveNumberOfThreads(settings.numberOfThreads));
+
+    // Stay within the buffer, but keep a few chunks per thread so that the work stays balanced for smaller files
+    std::size_t rowsPerChunk = std::max<std::size_t>(1, std::min(settings.bufferSize / numberOfThreads / rowSize, (numRows + 4 * numberOfThreads - 1) / (4 * numberOfThreads)));
+
+    // Chunks of whole checksum blocks verify every block once
+    if (settings.checksums && settings.checksums->blockSize % rowSize == 0)
+    {
+        const std::size_t rowsPerBlock = static_cast<std::size_t>(settings.checksums->blockSize / rowSize);
+
+        rowsPerChunk = (rowsPerChunk + rowsPerBlock - 1) / rowsPerBlock * rowsPerBlock;
+
+        // Rounded up chunks may no longer fit the share of every thread
+        numberOfThreads = std::clamp<std::size_t>(settings.bufferSize / (rowsPerChunk * rowSize), 1, numberOfThreads);
+    }
+
+    const std::size_t numberOfChunks = (numRows + rowsPerChunk - 1) / rowsPerChunk;
+
+    forEachChunkInParallel(numberOfChunks, numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>& buffer) {
+        throwIfCancelled(settings);
+
+        const std::size_t firstRow      = chunkIndex * rowsPerChunk;
+        const std::size_t numChunkRows  = std::min(rowsPerChunk, numRows - firstRow);
+        const std::uint64_t offset      = dataOffset + static_cast<std::uint64_t>(firstRow) * rowSize;
+        const std::size_t size          = numChunkRows * rowSize;
+
+        Destination* const output = destination + firstRow * numColumns;
+
+        // Checksums are verified for whole blocks, which may extend beyond the chunk
+        const auto [readOffset, readSize] = getChecksumRange(settings, offset, size);
+
+        auto accumulator = makeChunkStatistics(settings, numColumns);
+
+        if (std::is_same_v<Source, Destination> && settings.quantization == nullptr && readSize == size)
+        {
+            reader.read(offset, size, reinterpret_cast<char*>(output));
+
+            if (settings.checksums)
+                verifyChecksums(*settings.checksums, offset - settings.checksumOffset, reinterpret_cast<const char*>(output), size);
+
+            // Nothing is converted, so the statistics take a pass over the rows that were read
+            if (accumulator)
+                accumulator->addRows(output, numChunkRows);
+        }
+        else
+        {
+            const char* bytes = reader.view(readOffset, readSize);
+
+            if (bytes == nullptr)
+            {
+                buffer.resize(readSize);
+                reader.read(readOffset, readSize, buffer.data());
+            }
+
+            const char* const readBytes = bytes != nullptr ? bytes : buffer.data();
+
+            if (settings.checksums)
+                verifyChecksums(*settings.checksums, readOffset - settings.checksumOffset, readBytes, readSize);
+
+            convertRows<Source>(readBytes + (offset - readOffset), output, numChunkRows, numColumns, settings, accumulator);
+
+            if (bytes != nullptr)
+                reader.release(readOffset, readSize);
+        }
+
+        addChunkStatistics(settings, accumulator);
+        addChunkProgress(settings, size, numChunkRows);
+    }, settings.stats);
+}
+
+/*! Get the column runs of a selection, all columns form a single run */
+inline std::vector<ColumnRun> getSelectedColumnRuns(const std::vector<std::uint32_t>& columns, std::size_t numColumns)
+{
+    if (columns.empty())
+        return { ColumnRun{ 0, numColumns, 0 } };
+
+    return getColumnRuns(columns);
+}
+
+/*! Read and convert the selected rows and columns of row-major data into destination
+ *
+ * Only the bytes of the selected rows and columns are read, so I/O and
+ * memory scale with the selection rather than with the file size:
+ *  - memory mapped files are converted in place, which only touches the
+ *    pages that hold selected values
+ *  - otherwise, every selected row is read with one positional read per
+ *    range of nearby selected columns (see ChunkedLoadSettings::mergeGap)
+ *  - unless the selected ranges cover at least half of the row, in which
+ *    case whole rows are read, in large chunks when the rows are contiguous
+ *
+ * \param reader File to read from
+ * \param dataOffset Offset in bytes of the first row in the file
+ * \param numColumns Number of elements per row in the file
+ * \param rows Rows to load
+ * \param columns Columns to load in output order, empty loads all columns
+ * \param destination Buffer of at least rows.size() * (number of loaded columns) elements
+ * \param settings Thread count, raw buffer size, merge gap and progress
+*/
+template <typename Source, typename Destination>
+void loadSelectionInParallel(const FileReader& reader, std::uint64_t dataOffset, std::size_t numColumns, const RowSelection& rows, const std::vector<std::uint32_t>& columns, Destination* destination, const ChunkedLoadSettings& settings)
+{
+    const std::size_t numRows           = static_cast<std::size_t>(rows.size());
+    const std::size_t numOutputColumns  = columns.empty() ? numColumns : columns.size();
+
+    if (numRows == 0 || numOutputColumns == 0)
+        return;
+
+    const auto runs                     = getSelectedColumnRuns(columns, numColumns);
+    const auto ranges                   = getRowByteRanges(runs, sizeof(Source), settings.mergeGap);
+    const std::size_t rowSize           = numColumns * sizeof(Source);
+    const bool contiguous               = rows.isContiguous();
+
+    std::size_t selectedRowSize = 0;
+    for (const auto& range : ranges)
+        selectedRowSize += range.end - range.begin;
+
+    const bool inPlace          = reader.view(dataOffset, rowSize) != nullptr;
+    const bool readWholeRows    = !inPlace && 2 * selectedRowSize >= rowSize;
+
+    // Offset of every run within the bytes of a row in the buffer: whole rows keep the file layout, ranges are packed
+    std::vector<std::size_t> runOffsets;
+    for (const auto& run : runs)
+    {
+        const std::size_t runBegin = run.firstColumn * sizeof(Source);
+
+        if (inPlace || readWholeRows)
+        {
+            runOffsets.push_back(runBegin);
+        }
+        else
+        {
+            std::size_t packedOffset = 0;
+
+            for (const auto& range : ranges)
+            {
+                if (runBegin >= range.begin && runBegin < range.end)
+                {
+                    runOffsets.push_back(packedOffset + runBegin - range.begin);
+                    break;
+                }
+
+                packedOffset += range.end - range.begin;
+            }
+        }
+    }
+
+    const std::size_t bufferRowSize     = (inPlace || readWholeRows) ? rowSize : selectedRowSize;
+    const std::size_t numberOfThreads   = std::clamp<std::size_t>(settings.bufferSize / bufferRowSize, 1, resolveNumberOfThreads(settings.numberOfThreads));
+    const std::size_t rowsPerChunk      = std::max<std::size_t>(1, std::min(settings.bufferSize / numberOfThreads / bufferRowSize, (numRows + 4 * numberOfThreads - 1) / (4 * numberOfThreads)));
+    const std::size_t numberOfChunks    = (numRows + rowsPerChunk - 1) / rowsPerChunk;
+
+    forEachChunkInParallel(numberOfChunks, numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>& buffer) {
+        throwIfCancelled(settings);
+
+        const std::size_t firstRow      = chunkIndex * rowsPerChunk;
+        const std::size_t numChunkRows  = std::min(rowsPerChunk, numRows - firstRow);
+
+        const auto getRowOffset = [&](std::size_t row) -> std::uint64_t {
+            return dataOffset + rows.getRow(firstRow + row) * rowSize;
+        };
+
+        // Contiguous memory mapped rows are viewed as one span, which is released as a whole
+        const std::uint64_t spanOffset  = getRowOffset(0);
+        const std::size_t spanSize      = numChunkRows * rowSize;
+
+        const char* span = (inPlace && contiguous) ? reader.view(spanOffset, spanSize) : nullptr;
+
+        auto accumulator = makeChunkStatistics(settings, numOutputColumns);
+
+        if (!inPlace)
+        {
+            buffer.resize(numChunkRows * bufferRowSize);
+
+            if (readWholeRows && contiguous)
+            {
+                reader.read(spanOffset, spanSize, buffer.data());
+            }
+            else
+            {
+                char* output = buffer.data();
+
+                for (std::size_t row = 0; row < numChunkRows; row++)
+                {
+                    if (readWholeRows)
+                    {
+                        reader.read(getRowOffset(row), rowSize, output);
+                        output += rowSize;
+                    }
+                    else
+                    {
+                        for (const auto& range : ranges)
+                        {
+                            reader.read(getRowOffset(row) + range.begin, range.end - range.begin, output);
+                            output += range.end - range.begin;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (std::size_t row = 0; row < numChunkRows; row++)
+        {
+            const char* rowBytes = nullptr;
+
+            if (span != nullptr)
+                rowBytes = span + row * rowSize;
+            else if (inPlace)
+                rowBytes = reader.view(getRowOffset(row), rowSize);
+            else
+                rowBytes = buffer.data() + row * bufferRowSize;
+
+            if (rowBytes == nullptr)
+                throw std::runtime_error("Could not view the file.");
+
+            Destination* const rowOutput = destination + (firstRow + row) * numOutputColumns;
+
+            for (std::size_t runIndex = 0; runIndex < runs.size(); runIndex++)
+                convertColumns<Source>(rowBytes + runOffsets[runIndex], rowOutput + runs[runIndex].outputColumn, runs[runIndex].numColumns, runs[runIndex].firstColumn, settings);
+
+            if (accumulator)
+                accumulator->addRows(rowOutput, 1);
+
+            if (inPlace && span == nullptr)
+                reader.release(getRowOffset(row), rowSize);
+        }
+
+        if (span != nullptr)
+            reader.release(spanOffset, spanSize);
+
+        addChunkStatistics(settings, accumulator);
+        addChunkProgress(settings, numChunkRows * (readWholeRows ? rowSize : selectedRowSize), numChunkRows);
+    }, settings.stats);
+}
+
+/*! Read and convert the selected rows and columns of column-major data into row-major destination
+ *
+ * Every column is stored contiguously, so only the selected columns are
+ * read, in chunks of selected rows that worker threads convert and
+ * interleave into destination concurrently. A chunk reads the span of file
+ * rows from its first to its last selected row; memory mapped files only
+ * touch the pages that hold selected values.
+ *
+ * \param reader File to read from
+ * \param dataOffset Offset in bytes of the first column in the file
+ * \param numRows Number of rows in the file (elements per column)
+ * \param numColumns Number of columns in the file
+ * \param rows Rows to load
+ * \param columns Columns to load in output order, empty loads all columns
+ * \param destination Buffer of at least rows.size() * (number of loaded columns) elements
+ * \param settings Thread count, raw buffer size and progress
+*/
+template <typename Source, typename Destination>
+void loadColumnMajorInParallel(const FileReader& reader, std::uint64_t dataOffset, std::size_t numRows, std::size_t numColumns, const RowSelection& rows, const std::vector<std::uint32_t>& columns, Destination* destination, const ChunkedLoadSettings& settings)
+{
+    const std::size_t numOutputRows     = static_cast<std::size_t>(rows.size());
+    const std::size_t numOutputColumns  = columns.empty() ? numColumns : columns.size();
+
+    if (settings.quantization != nullptr)
+        throw std::invalid_argument("Quantized data must be stored row-major.");
+
+    if (numOutputRows == 0 || numOutputColumns == 0)
+        return;
+
+    // Every chunk holds the raw bytes of its span of rows and their conversion before they are interleaved
+    const std::size_t rowStep           = rows.rows.empty() ? static_cast<std::size_t>(rows.step) : std::max<std::size_t>(1, numRows / numOutputRows);
+    const std::size_t bytesPerRow       = rowStep * sizeof(Source) + sizeof(Destination);
+    const std::size_t numberOfThreads   = std::clamp<std::size_t>(settings.bufferSize / bytesPerRow, 1, resolveNumberOfThreads(settings.numberOfThreads));
+    const std::size_t rowsPerChunk      = std::max<std::size_t>(1, std::min(settings.bufferSize / numberOfThreads / bytesPerRow, (numOutputRows * numOutputColumns + 4 * numberOfThreads - 1) / (4 * numberOfThreads)));
+    const std::size_t chunksPerColumn   = (numOutputRows + rowsPerChunk - 1) / rowsPerChunk;
+
+    forEachChunkInParallel(numOutputColumns * chunksPerColumn, numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>& buffer) {
+        throwIfCancelled(settings);
+
+        const std::size_t outputColumn  = chunkIndex / chunksPerColumn;
+        const std::size_t column        = columns.empty() ? outputColumn : columns[outputColumn];
+        const std::size_t firstRow      = (chunkIndex % chunksPerColumn) * rowsPerChunk;
+        const std::size_t numChunkRows  = std::min(rowsPerChunk, numOutputRows - firstRow);
+        const std::uint64_t firstSpanRow = rows.getRow(firstRow);
+        const std::size_t numSpanRows   = static_cast<std::size_t>(rows.getRow(firstRow + numChunkRows - 1) - firstSpanRow) + 1;
+        const std::uint64_t offset      = dataOffset + (static_cast<std::uint64_t>(column) * numRows + firstSpanRow) * sizeof(Source);
+        const std::size_t size          = numSpanRows * sizeof(Source);
+
+        const char* bytes = reader.view(offset, size);
+
+        // Layout of the buffer: raw bytes (unless viewed in place), converted values at an aligned offset
+        const std::size_t rawSize           = bytes == nullptr ? size : 0;
+        const std::size_t convertedOffset   = (rawSize + alignof(Destination) - 1) / alignof(Destination) * alignof(Destination);
+
+        buffer.resize(convertedOffset + numChunkRows * sizeof(Destination));
+
+        if (bytes == nullptr)
+        {
+            reader.read(offset, size, buffer.data());
+            bytes = buffer.data();
+        }
+
+        Destination* const converted = reinterpret_cast<Destination*>(buffer.data() + convertedOffset);
+
+        if (rows.isContiguous())
+        {
+            convertElements<Source>(bytes, converted, numChunkRows);
+        }
+        else
+        {
+            for (std::size_t row = 0; row < numChunkRows; row++)
+                convertElements<Source>(bytes + (rows.getRow(firstRow + row) - firstSpanRow) * sizeof(Source), converted + row, 1);
+        }
+
+        for (std::size_t row = 0; row < numChunkRows; row++)
+            destination[(firstRow + row) * numOutputColumns + outputColumn] = converted[row];
+
+        auto accumulator = makeChunkStatistics(settings, numOutputColumns);
+
+        if (accumulator)
+            accumulator->addColumn(converted, numChunkRows, outputColumn);
+
+        addChunkStatistics(settings, accumulator);
+
+        reader.release(offset, size);
+
+        // Rows are complete once all of their columns are loaded, so every column reports its share of the rows
+        addChunkProgress(settings, size, numChunkRows * (outputColumn + 1) / numOutputColumns - numChunkRows * outputColumn / numOutputColumns);
+    }, settings.stats);
+}
+
+/*! Decompress and convert the selected rows and columns of block-compressed data into destination
+ *
+ * Worker threads decode the blocks that hold selected rows concurrently,
+ * straight into their slice of destination when all rows and columns of a
+ * block are loaded as they are. Encoded bytes are viewed in place when the
+ * reader allows it. The thread count is reduced when the blocks of all
+ * threads would not fit in settings.bufferSize.
+ *
+ * Blocks hold whole rows, so selected columns are picked from the decoded
+ * rows: memory use follows the selection, but all blocks with selected rows
+ * are read. With settings.checksums, every block is verified before it is
+ * decoded.
+ *
+ * \param reader File to read from
+ * \param dataOffset Offset in bytes of the first block in the file
+ * \param blockIndex Location of the blocks, see parseBlockIndex
+ * \param numColumns Number of elements per row in the file
+ * \param rows Rows to load
+ * \param columns Columns to load in output order, empty loads all columns
+ * \param destination Buffer of at least rows.size() * (number of loaded columns) elements
+ * \param settings Thread count, raw buffer size and progress
+*/
+template <typename Source, typename Destination>
+void loadBlocksInParallel(const FileReader& reader, std::uint64_t dataOffset, const BlockIndex& blockIndex, std::size_t numColumns, const RowSelection& rows, const std::vector<std::uint32_t>& columns, Destination* destination, const ChunkedLoadSettings& settings)
+{
+    const std::size_t numberOfBlocks = blockIndex.getNumberOfBlocks();
+
+    if (numberOfBlocks == 0 || numColumns == 0 || rows.size() == 0)
+        return;
+
+    const std::size_t rowSize           = numColumns * sizeof(Source);
+    const std::size_t rowsPerBlock      = static_cast<std::size_t>(blockIndex.rowsPerBlock);
+    const std::size_t numRows           = static_cast<std::size_t>(blockIndex.numRows);
+    const std::size_t numOutputColumns  = columns.empty() ? numColumns : columns.size();
+    const auto runs                     = getSelectedColumnRuns(columns, numColumns);
+
+    // Only the blocks that hold selected rows are decoded
+    std::vector<std::size_t> selectedBlocks;
+    for (std::size_t blockNumber = 0; blockNumber < numberOfBlocks; blockNumber++)
+        if (rows.lowerBound(blockNumber * rowsPerBlock) < rows.lowerBound(std::min((blockNumber + 1) * rowsPerBlock, numRows)))
+            selectedBlocks.push_back(blockNumber);
+
+    // Every thread holds up to three block-sized buffers: encoded bytes, filter scratch and decoded rows
+    const std::size_t numberOfThreads   = std::clamp<std::size_t>(settings.bufferSize / (3 * rowsPerBlock * rowSize), 1, resolveNumberOfThreads(settings.numberOfThreads));
+
+    forEachChunkInParallel(selectedBlocks.size(), numberOfThreads, [&](std::size_t chunkIndex, std::vector<char>& buffer) {
+        throwIfCancelled(settings);
+
+        const std::size_t blockNumber   = selectedBlocks[chunkIndex];
+        const std::size_t firstRow      = blockNumber * rowsPerBlock;
+        const std::size_t numBlockRows  = std::min(rowsPerBlock, numRows - firstRow);
+        const std::size_t rawSize       = numBlockRows * rowSize;
+        const std::uint64_t offset      = dataOffset + blockIndex.blockOffsets[blockNumber];
+        const std::size_t encodedSize   = static_cast<std::size_t>(blockIndex.blockOffsets[blockNumber + 1] - blockIndex.blockOffsets[blockNumber]);
+
+        // Selected rows in this block, as indices into the selection (and destination rows)
+        const std::size_t firstOutputRow    = static_cast<std::size_t>(rows.lowerBound(firstRow));
+        const std::size_t endOutputRow      = static_cast<std::size_t>(rows.lowerBound(firstRow + numBlockRows));
+
+        Destination* const output = destination + firstOutputRow * numOutputColumns;
+
+        // Rows are decoded straight into destination when nothing needs to be converted or picked
+        const bool decodeInPlace = std::is_same_v<Source, Destination> && settings.quantization == nullptr && columns.empty() && endOutputRow - firstOutputRow == numBlockRows;
+
+        const char* encoded = reader.view(offset, encodedSize);
+
+        // Layout of the buffer: encoded bytes (unless viewed in place), filter scratch, decoded rows (unless decoded in place)
+        buffer.resize((encoded == nullptr ? encodedSize : 0) + rawSize + (decodeInPlace ? 0 : rawSize));
+
+        char* scratch = buffer.data();
+
+        if (encoded == nullptr)
+        {
+            reader.read(offset, encodedSize, buffer.data());
+            encoded = buffer.data();
+            scratch += encodedSize;
+        }
+
+        // A corrupt block fails before it is decoded
+        if (settings.checksums)
+            verifyBlockChecksum(*settings.checksums, blockNumber, encoded, encodedSize);
+
+        auto accumulator = makeChunkStatistics(settings, numOutputColumns);
+
+        if (decodeInPlace)
+        {
+            decodeBlock(encoded, encodedSize, reinterpret_cast<char*>(output), rawSize, sizeof(Source), blockIndex.codec, blockIndex.filter, scratch);
+
+            if (accumulator)
+                accumulator->addRows(output, numBlockRows);
+        }
+        else
+        {
+            char* const decoded = scratch + rawSize;
+
+            decodeBlock(encoded, encodedSize, decoded, rawSize, sizeof(Source), blockIndex.codec, blockIndex.filter, scratch);
+
+            for (std::size_t outputRow = firstOutputRow; outputRow < endOutputRow; outputRow++)
+            {
+                const char* const rowBytes = decoded + static_cast<std::size_t>(rows.getRow(outputRow) - firstRow) * rowSize;
+
+                for (const auto& run : runs)
+                    convertColumns<Source>(rowBytes + run.firstColumn * sizeof(Source), destination + outputRow * numOutputColumns + run.outputColumn, run.numColumns, run.firstColumn, settings);
+
+                if (accumulator)
+                    accumulator->addRows(destination + outputRow * numOutputColumns, 1);
+            }
+        }
+
+        reader.release(offset, encodedSize);
+
+        addChunkStatistics(settings, accumulator);
+
+        addChunkProgress(settings, encodedSize, endOutputRow - firstOutputRow);
+    }, settings.stats);
+}
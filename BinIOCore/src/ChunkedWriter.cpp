@@ -0,0 +1,108 @@
+#include "ChunkedWriter.h"
+
+#include "BlockCodec.h"
+#include "Checksum.h"
+
+#include <stdexcept>
+
+BlockIndex writeBlocksInParallel(std::ostream& out, std::size_t numRows, std::size_t rowSize, std::size_t elementSize, const std::function<void(std::size_t, std::size_t, char*)>& gather, const ChunkedWriteSettings& settings)
+{
+    const bool compress = settings.codec != BlockCodec::None;
+
+    // Blocks of fixed rows can be checked against their checksums by any reader
+    const std::size_t fixedRowsPerBlock = std::max<std::size_t>(1, settings.blockSize / std::max<std::size_t>(rowSize, 1));
+
+    BlockIndex blockIndex;
+
+    if (compress)
+    {
+        blockIndex.codec        = settings.codec;
+        blockIndex.filter       = settings.filter;
+        blockIndex.numRows      = numRows;
+        blockIndex.rowsPerBlock = fixedRowsPerBlock;
+        blockIndex.blockOffsets.push_back(0);
+    }
+
+    if (settings.checksums)
+    {
+        settings.checksums->blockSize   = compress ? 0 : fixedRowsPerBlock * rowSize;
+        settings.checksums->dataSize    = compress ? 0 : numRows * rowSize;
+        settings.checksums->checksums.clear();
+    }
+
+    if (numRows == 0 || rowSize == 0)
+        return blockIndex;
+
+    const std::size_t numberOfThreads   = resolveNumberOfThreads(settings.numberOfThreads);
+
+    // Two buffers per worker, so that every worker can fill a block while the previous one is written
+    const std::size_t numberOfBuffers   = 2 * numberOfThreads;
+
+    // Compressed and checksummed blocks have a fixed number of rows, the block index or the block size describes the layout
+    const std::size_t rowsPerBlock      = compress || settings.checksums ? fixedRowsPerBlock : std::max<std::size_t>(1, std::min(settings.bufferSize / numberOfBuffers / rowSize, (numRows + 4 * numberOfThreads - 1) / (4 * numberOfThreads)));
+    const std::size_t numberOfBlocks    = (numRows + rowsPerBlock - 1) / rowsPerBlock;
+
+    // Every worker fills in the checksums of its own blocks
+    if (settings.checksums)
+        settings.checksums->checksums.resize(numberOfBlocks);
+
+    const auto produce = [&](std::size_t blockNumber, std::vector<char>& buffer) -> void {
+        const std::size_t firstRow      = blockNumber * rowsPerBlock;
+        const std::size_t numBlockRows  = std::min(rowsPerBlock, numRows - firstRow);
+        const std::size_t rawSize       = numBlockRows * rowSize;
+
+        if (settings.progress)
+            settings.progress->throwIfCancelled();
+
+        if (!compress)
+        {
+            buffer.resize(rawSize);
+            gather(firstRow, numBlockRows, buffer.data());
+
+            if (settings.checksums)
+                settings.checksums->checksums[blockNumber] = computeChecksum(buffer.data(), buffer.size());
+
+            return;
+        }
+
+        // Layout of the buffer while encoding: raw rows, filter scratch, encoded block
+        buffer.resize(2 * rawSize + getEncodedBlockBound(rawSize));
+
+        char* const raw     = buffer.data();
+        char* const scratch = raw + rawSize;
+        char* const encoded = scratch + rawSize;
+
+        gather(firstRow, numBlockRows, raw);
+
+        const std::size_t encodedSize = encodeBlock(raw, rawSize, elementSize, settings.codec, settings.filter, encoded, scratch);
+
+        std::memmove(buffer.data(), encoded, encodedSize);
+        buffer.resize(encodedSize);
+
+        if (settings.checksums)
+            settings.checksums->checksums[blockNumber] = computeChecksum(buffer.data(), buffer.size());
+    };
+
+    const auto consume = [&](std::size_t blockNumber, const std::vector<char>& buffer) -> void {
+        if (settings.progress)
+            settings.progress->throwIfCancelled();
+
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+        if (!out)
+            throw std::runtime_error("Could not write to the file.");
+
+        if (compress)
+            blockIndex.blockOffsets.push_back(blockIndex.blockOffsets.back() + buffer.size());
+
+        if (settings.progress)
+            settings.progress->addBlock(buffer.size(), std::min(rowsPerBlock, numRows - blockNumber * rowsPerBlock));
+    };
+
+    runOrderedPipeline(numberOfBlocks, numberOfThreads, numberOfBuffers, produce, consume, settings.stats);
+
+    if (settings.checksums && compress)
+        settings.checksums->dataSize = blockIndex.blockOffsets.back();
+
+    return blockIndex;
+}
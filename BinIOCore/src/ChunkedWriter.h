@@ -0,0 +1,172 @@
+#pragma once
+
+#include "ConversionKernels.h"
+#include "FileFormat.h"
+#include "Parallel.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Thrown by the write functions when the write is cancelled through WriteProgress::cancel */
+class WriteCancelled : public std::runtime_error
+{
+public:
+    WriteCancelled() : std::runtime_error("The write was cancelled.") { }
+};
+
+/**
+ * Progress and cancellation of a write
+ *
+ * The writing thread adds every block it wrote, and all threads stop at the
+ * next block once cancel() was called. The callback is called on the
+ * writing thread, so it should return quickly.
+ */
+class WriteProgress
+{
+public:
+    /** Called as callback(bytesWritten, rowsWritten) with the totals so far */
+    using Callback = std::function<void(std::uint64_t, std::uint64_t)>;
+
+    explicit WriteProgress(Callback callback = {}) : _callback(std::move(callback)) { }
+
+    /** Stop the write, the write function throws WriteCancelled */
+    void cancel() {
+        _cancelled = true;
+    }
+
+    /** Whether the write was cancelled */
+    bool isCancelled() const {
+        return _cancelled;
+    }
+
+    /** Throw WriteCancelled when the write was cancelled */
+    void throwIfCancelled() const {
+        if (_cancelled)
+            throw WriteCancelled();
+    }
+
+    /** Add a written block of bytesWritten bytes that completed rowsWritten rows */
+    void addBlock(std::uint64_t bytesWritten, std::uint64_t rowsWritten) {
+        const std::uint64_t totalBytesWritten   = _bytesWritten += bytesWritten;
+        const std::uint64_t totalRowsWritten    = _rowsWritten += rowsWritten;
+
+        if (_callback)
+            _callback(totalBytesWritten, totalRowsWritten);
+    }
+
+private:
+    Callback                    _callback;
+    std::atomic<std::uint64_t>  _bytesWritten   = 0;
+    std::atomic<std::uint64_t>  _rowsWritten    = 0;
+    std::atomic<bool>           _cancelled      = false;
+};
+
+/** Settings of the pipelined, multi-threaded write of rows */
+struct ChunkedWriteSettings
+{
+    std::size_t             numberOfThreads = 0;                        /** Number of gathering worker threads, 0 uses all hardware threads */
+    std::size_t             bufferSize      = std::size_t(256) << 20;   /** Upper bound of gathered bytes held at once, over all block buffers */
+    BlockCodec              codec           = BlockCodec::None;         /** Compress every block with this codec, None writes raw rows */
+    BlockFilter             filter          = BlockFilter::ByteShuffle; /** Filter applied to compressed blocks */
+    std::size_t             blockSize       = std::size_t(1) << 20;     /** Raw bytes per compressed block, rounded down to whole rows */
+    PipelineStats*          stats           = nullptr;                  /** Receives the thread count, buffer memory, gather and write times, optional */
+    WriteProgress*          progress        = nullptr;                  /** Receives the written blocks and cancels the write, optional */
+    StatisticsCollector*    statistics      = nullptr;                  /** Receives the statistics of every written column, gathered with the rows, optional */
+    BlockChecksums*         checksums       = nullptr;                  /** Receives the checksum of every written block, computed by the gathering workers, optional */
+};
+
+/*! Write numRows rows of rowSize bytes to out, gathered block by block
+ *
+ * Worker threads gather (and compress) blocks of consecutive rows into
+ * reusable buffers while the calling thread writes the finished blocks to
+ * out in order, so that gathering overlaps with I/O. All block buffers
+ * together hold at most about settings.bufferSize bytes, unless a single
+ * block is larger than that.
+ *
+ * With settings.checksums, uncompressed rows are written in blocks of
+ * settings.blockSize bytes (rounded down to whole rows) as well, and every
+ * worker computes the checksum of the block it gathered (and compressed).
+ *
+ * Throws std::runtime_error when writing to out fails and WriteCancelled
+ * when the write is cancelled through settings.progress.
+ *
+ * \param out Stream to write to, positioned where the first row goes
+ * \param numRows Number of rows
+ * \param rowSize Size of a row in bytes
+ * \param elementSize Size of an element in bytes, the unit of the byte shuffle filter
+ * \param gather Called on a worker as gather(firstRow, numRows, output) to fill output with numRows rows
+ * \param settings Thread count, buffer size, compression and progress
+ * \return Block index of the written blocks when settings.codec is not None, otherwise an empty block index
+*/
+BlockIndex writeBlocksInParallel(std::ostream& out, std::size_t numRows, std::size_t rowSize, std::size_t elementSize, const std::function<void(std::size_t, std::size_t, char*)>& gather, const ChunkedWriteSettings& settings);
+
+/*! Gather the rows at rowIndices from data, convert them to Destination and write them to out
+ *
+ * Runs of consecutive row indices (as in sorted selections) are copied or
+ * converted in one go. See writeBlocksInParallel for the pipeline.
+ *
+ * \param out Stream to write to, positioned where the first row goes
+ * \param data Rows of numColumns Source elements
+ * \param numColumns Number of elements per row
+ * \param rowIndices Indices of the rows to write in output order, nullptr writes all rows in order
+ * \param numRows Number of rows to write
+ * \param settings Thread count, buffer size, compression and progress
+ * \return Block index of the written blocks when settings.codec is not None, otherwise an empty block index
+*/
+template <typename Source, typename Destination>
+BlockIndex writeRowsInParallel(std::ostream& out, const Source* data, std::size_t numColumns, const std::uint32_t* rowIndices, std::size_t numRows, const ChunkedWriteSettings& settings)
+{
+    StatisticsCollector* const statistics = settings.statistics;
+
+    const auto gather = [data, numColumns, rowIndices, statistics](std::size_t firstRow, std::size_t numBlockRows, char* buffer) -> void {
+        Destination* output = reinterpret_cast<Destination*>(buffer);
+
+        std::optional<StatisticsAccumulator> accumulator;
+
+        if (statistics != nullptr)
+            accumulator.emplace(numColumns);
+
+        for (std::size_t row = firstRow; row < firstRow + numBlockRows;)
+        {
+            // Coalesce a run of consecutive row indices into one copy
+            std::size_t runEnd = row + 1;
+
+            if (rowIndices == nullptr)
+                runEnd = firstRow + numBlockRows;
+            else
+                while (runEnd < firstRow + numBlockRows && rowIndices[runEnd] == rowIndices[runEnd - 1] + 1)
+                    runEnd++;
+
+            const Source* const input   = data + static_cast<std::size_t>(rowIndices == nullptr ? row : rowIndices[row]) * numColumns;
+            const std::size_t count     = (runEnd - row) * numColumns;
+
+            if constexpr (std::is_same_v<Source, Destination>)
+                std::memcpy(output, input, count * sizeof(Destination));
+            else
+                convertElements<Source>(reinterpret_cast<const char*>(input), output, count);
+
+            // The statistics are of the written values, taken while the run is still in the cache
+            if (accumulator)
+                accumulator->addRows(output, runEnd - row);
+
+            output += count;
+            row = runEnd;
+        }
+
+        if (accumulator)
+            statistics->merge(*accumulator);
+    };
+
+    return writeBlocksInParallel(out, numColumns == 0 ? 0 : numRows, numColumns * sizeof(Destination), sizeof(Destination), gather, settings);
+}
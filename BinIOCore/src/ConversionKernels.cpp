@@ -0,0 +1,624 @@
+#include "ConversionKernels.h"
+
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define BINIO_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define BINIO_TARGET(instructionSets)
+    #else
+        #define BINIO_TARGET(instructionSets) __attribute__((target(instructionSets)))
+    #endif
+#endif
+
+static_assert(sizeof(BFloat16) == sizeof(std::uint16_t), "BFloat16 must be layout compatible with its raw bits");
+static_assert(sizeof(Float16) == sizeof(std::uint16_t), "Float16 must be layout compatible with its raw bits");
+
+namespace {
+
+// =============================================================================
+// Scalar kernels
+// =============================================================================
+
+inline float loadFloat(const char* source)
+{
+    float value;
+    std::memcpy(&value, source, sizeof(float));
+    return value;
+}
+
+void float32ToBFloat16Scalar(const char* source, BFloat16* destination, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+        destination[i] = floatToBFloat16(loadFloat(source + i * sizeof(float)));
+}
+
+template <typename Integer>
+void float32ToIntegerScalar(const char* source, Integer* destination, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+        destination[i] = saturateFloat<Integer>(loadFloat(source + i * sizeof(float)));
+}
+
+void uint8ToFloat32Scalar(const char* source, float* destination, std::size_t count)
+{
+    const auto bytes = reinterpret_cast<const std::uint8_t*>(source);
+
+    for (std::size_t i = 0; i < count; i++)
+        destination[i] = static_cast<float>(bytes[i]);
+}
+
+void uint8ToBFloat16Scalar(const char* source, BFloat16* destination, std::size_t count)
+{
+    const auto bytes = reinterpret_cast<const std::uint8_t*>(source);
+
+    // Bytes are exactly representable in bfloat16, the low half of the float bits is always zero
+    for (std::size_t i = 0; i < count; i++)
+        destination[i] = floatToBFloat16(static_cast<float>(bytes[i]));
+}
+
+template <typename Code>
+void dequantizeScalar(const char* source, float* destination, std::size_t count, const float* scales, const float* offsets)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        Code code;
+        std::memcpy(&code, source + i * sizeof(Code), sizeof(Code));
+
+        destination[i] = offsets[i] + scales[i] * static_cast<float>(code);
+    }
+}
+
+template <typename Integer>
+void uint8ToInteger(const char* source, Integer* destination, std::size_t count)
+{
+    const auto bytes = reinterpret_cast<const std::uint8_t*>(source);
+
+    if constexpr (std::is_same_v<Integer, std::int8_t>)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            destination[i] = static_cast<std::int8_t>(bytes[i] < 127 ? bytes[i] : 127);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; i++)
+            destination[i] = static_cast<Integer>(bytes[i]);
+    }
+}
+
+#ifdef BINIO_X86
+
+// =============================================================================
+// SSE4.1 kernels
+// =============================================================================
+
+BINIO_TARGET("sse4.1")
+inline __m128i float32ToBFloat16BitsSse41(__m128 values)
+{
+    const __m128i bits      = _mm_castps_si128(values);
+    const __m128i upper     = _mm_srli_epi32(bits, 16);
+    const __m128i bias      = _mm_add_epi32(_mm_and_si128(upper, _mm_set1_epi32(1)), _mm_set1_epi32(0x7FFF));
+    const __m128i rounded   = _mm_srli_epi32(_mm_add_epi32(bits, bias), 16);
+    const __m128i quietNaN  = _mm_or_si128(upper, _mm_set1_epi32(0x0040));
+    const __m128i isNaN     = _mm_castps_si128(_mm_cmpunord_ps(values, values));
+
+    return _mm_blendv_epi8(rounded, quietNaN, isNaN);
+}
+
+BINIO_TARGET("sse4.1")
+void float32ToBFloat16Sse41(const char* source, BFloat16* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i low   = float32ToBFloat16BitsSse41(_mm_loadu_ps(reinterpret_cast<const float*>(source) + i));
+        const __m128i high  = float32ToBFloat16BitsSse41(_mm_loadu_ps(reinterpret_cast<const float*>(source) + i + 4));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi32(low, high));
+    }
+
+    float32ToBFloat16Scalar(source + i * sizeof(float), destination + i, count - i);
+}
+
+template <typename Integer>
+BINIO_TARGET("sse4.1")
+inline __m128i float32ToInt32Sse41(const char* source)
+{
+    const __m128 lowest     = _mm_set1_ps(static_cast<float>(std::numeric_limits<Integer>::lowest()));
+    const __m128 highest    = _mm_set1_ps(static_cast<float>(std::numeric_limits<Integer>::max()));
+    const __m128 values     = _mm_loadu_ps(reinterpret_cast<const float*>(source));
+
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(values, lowest), highest));
+}
+
+template <typename Integer>
+BINIO_TARGET("sse4.1")
+void float32ToIntegerSse41(const char* source, Integer* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const char* const block = source + i * sizeof(float);
+
+        const __m128i a = float32ToInt32Sse41<Integer>(block);
+        const __m128i b = float32ToInt32Sse41<Integer>(block + 16);
+        const __m128i c = float32ToInt32Sse41<Integer>(block + 32);
+        const __m128i d = float32ToInt32Sse41<Integer>(block + 48);
+
+        const auto output = reinterpret_cast<__m128i*>(destination + i);
+
+        if constexpr (std::is_same_v<Integer, std::int16_t>)
+        {
+            _mm_storeu_si128(output, _mm_packs_epi32(a, b));
+            _mm_storeu_si128(output + 1, _mm_packs_epi32(c, d));
+        }
+        else if constexpr (std::is_same_v<Integer, std::uint16_t>)
+        {
+            _mm_storeu_si128(output, _mm_packus_epi32(a, b));
+            _mm_storeu_si128(output + 1, _mm_packus_epi32(c, d));
+        }
+        else if constexpr (std::is_same_v<Integer, std::int8_t>)
+        {
+            _mm_storeu_si128(output, _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+        else
+        {
+            _mm_storeu_si128(output, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+    }
+
+    float32ToIntegerScalar(source + i * sizeof(float), destination + i, count - i);
+}
+
+BINIO_TARGET("sse4.1")
+void uint8ToFloat32Sse41(const char* source, float* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+        _mm_storeu_ps(destination + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes)));
+        _mm_storeu_ps(destination + i + 4, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4))));
+        _mm_storeu_ps(destination + i + 8, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8))));
+        _mm_storeu_ps(destination + i + 12, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12))));
+    }
+
+    uint8ToFloat32Scalar(source + i, destination + i, count - i);
+}
+
+BINIO_TARGET("sse4.1")
+void uint8ToBFloat16Sse41(const char* source, BFloat16* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    // Exact conversion: the bfloat16 bits are the upper half of the float bits
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i low   = _mm_srli_epi32(_mm_castps_si128(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes))), 16);
+        const __m128i high  = _mm_srli_epi32(_mm_castps_si128(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)))), 16);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi32(low, high));
+    }
+
+    uint8ToBFloat16Scalar(source + i, destination + i, count - i);
+}
+
+template <typename Code>
+BINIO_TARGET("sse4.1")
+void dequantizeSse41(const char* source, float* destination, std::size_t count, const float* scales, const float* offsets)
+{
+    std::size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i codes;
+
+        if constexpr (sizeof(Code) == 1)
+        {
+            std::int32_t bytes;
+            std::memcpy(&bytes, source + i, sizeof(bytes));
+            codes = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+        }
+        else
+        {
+            codes = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i * sizeof(Code))));
+        }
+
+        const __m128 scaled = _mm_mul_ps(_mm_loadu_ps(scales + i), _mm_cvtepi32_ps(codes));
+
+        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(offsets + i), scaled));
+    }
+
+    dequantizeScalar<Code>(source + i * sizeof(Code), destination + i, count - i, scales + i, offsets + i);
+}
+
+// =============================================================================
+// AVX2 kernels
+// =============================================================================
+
+BINIO_TARGET("avx2")
+inline __m256i float32ToBFloat16BitsAvx2(__m256 values)
+{
+    const __m256i bits      = _mm256_castps_si256(values);
+    const __m256i upper     = _mm256_srli_epi32(bits, 16);
+    const __m256i bias      = _mm256_add_epi32(_mm256_and_si256(upper, _mm256_set1_epi32(1)), _mm256_set1_epi32(0x7FFF));
+    const __m256i rounded   = _mm256_srli_epi32(_mm256_add_epi32(bits, bias), 16);
+    const __m256i quietNaN  = _mm256_or_si256(upper, _mm256_set1_epi32(0x0040));
+    const __m256i isNaN     = _mm256_castps_si256(_mm256_cmp_ps(values, values, _CMP_UNORD_Q));
+
+    return _mm256_blendv_epi8(rounded, quietNaN, isNaN);
+}
+
+BINIO_TARGET("avx2")
+void float32ToBFloat16Avx2(const char* source, BFloat16* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256i low   = float32ToBFloat16BitsAvx2(_mm256_loadu_ps(reinterpret_cast<const float*>(source) + i));
+        const __m256i high  = float32ToBFloat16BitsAvx2(_mm256_loadu_ps(reinterpret_cast<const float*>(source) + i + 8));
+
+        // packus works per 128-bit lane, restore the element order afterwards
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), packed);
+    }
+
+    float32ToBFloat16Sse41(source + i * sizeof(float), destination + i, count - i);
+}
+
+template <typename Integer>
+BINIO_TARGET("avx2")
+inline __m256i float32ToInt32Avx2(const char* source)
+{
+    const __m256 lowest     = _mm256_set1_ps(static_cast<float>(std::numeric_limits<Integer>::lowest()));
+    const __m256 highest    = _mm256_set1_ps(static_cast<float>(std::numeric_limits<Integer>::max()));
+    const __m256 values     = _mm256_loadu_ps(reinterpret_cast<const float*>(source));
+
+    return _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(values, lowest), highest));
+}
+
+template <typename Integer>
+BINIO_TARGET("avx2")
+void float32ToIntegerAvx2(const char* source, Integer* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 32 <= count; i += 32)
+    {
+        const char* const block = source + i * sizeof(float);
+
+        const __m256i a = float32ToInt32Avx2<Integer>(block);
+        const __m256i b = float32ToInt32Avx2<Integer>(block + 32);
+        const __m256i c = float32ToInt32Avx2<Integer>(block + 64);
+        const __m256i d = float32ToInt32Avx2<Integer>(block + 96);
+
+        const auto output = reinterpret_cast<__m256i*>(destination + i);
+
+        // The pack instructions work per 128-bit lane, the permutes restore the element order
+        if constexpr (std::is_same_v<Integer, std::int16_t>)
+        {
+            _mm256_storeu_si256(output, _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+            _mm256_storeu_si256(output + 1, _mm256_permute4x64_epi64(_mm256_packs_epi32(c, d), 0xD8));
+        }
+        else if constexpr (std::is_same_v<Integer, std::uint16_t>)
+        {
+            _mm256_storeu_si256(output, _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8));
+            _mm256_storeu_si256(output + 1, _mm256_permute4x64_epi64(_mm256_packus_epi32(c, d), 0xD8));
+        }
+        else
+        {
+            const __m256i order     = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+            const __m256i ab        = _mm256_packs_epi32(a, b);
+            const __m256i cd        = _mm256_packs_epi32(c, d);
+            const __m256i packed    = std::is_same_v<Integer, std::int8_t> ? _mm256_packs_epi16(ab, cd) : _mm256_packus_epi16(ab, cd);
+
+            _mm256_storeu_si256(output, _mm256_permutevar8x32_epi32(packed, order));
+        }
+    }
+
+    float32ToIntegerSse41(source + i * sizeof(float), destination + i, count - i);
+}
+
+BINIO_TARGET("avx2")
+void uint8ToFloat32Avx2(const char* source, float* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i low   = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i high  = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i + 8));
+
+        _mm256_storeu_ps(destination + i, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(low)));
+        _mm256_storeu_ps(destination + i + 8, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(high)));
+    }
+
+    uint8ToFloat32Sse41(source + i, destination + i, count - i);
+}
+
+BINIO_TARGET("avx2")
+void uint8ToBFloat16Avx2(const char* source, BFloat16* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256i low   = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i)));
+        const __m256i high  = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i + 8)));
+
+        const __m256i lowBits   = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(low)), 16);
+        const __m256i highBits  = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(high)), 16);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(lowBits, highBits), 0xD8));
+    }
+
+    uint8ToBFloat16Sse41(source + i, destination + i, count - i);
+}
+
+template <typename Code>
+BINIO_TARGET("avx2")
+void dequantizeAvx2(const char* source, float* destination, std::size_t count, const float* scales, const float* offsets)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i codes;
+
+        if constexpr (sizeof(Code) == 1)
+            codes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i)));
+        else
+            codes = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * sizeof(Code))));
+
+        const __m256 scaled = _mm256_mul_ps(_mm256_loadu_ps(scales + i), _mm256_cvtepi32_ps(codes));
+
+        _mm256_storeu_ps(destination + i, _mm256_add_ps(_mm256_loadu_ps(offsets + i), scaled));
+    }
+
+    dequantizeSse41<Code>(source + i * sizeof(Code), destination + i, count - i, scales + i, offsets + i);
+}
+
+// =============================================================================
+// AVX-512 kernels
+// =============================================================================
+
+BINIO_TARGET("avx512f")
+void float32ToBFloat16Avx512(const char* source, BFloat16* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    const __m512i one   = _mm512_set1_epi32(1);
+    const __m512i half  = _mm512_set1_epi32(0x7FFF);
+    const __m512i quiet = _mm512_set1_epi32(0x0040);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512 values     = _mm512_loadu_ps(reinterpret_cast<const float*>(source) + i);
+        const __m512i bits      = _mm512_castps_si512(values);
+        const __m512i upper     = _mm512_srli_epi32(bits, 16);
+        const __m512i bias      = _mm512_add_epi32(_mm512_and_si512(upper, one), half);
+        const __m512i rounded   = _mm512_srli_epi32(_mm512_add_epi32(bits, bias), 16);
+        const __mmask16 isNaN   = _mm512_cmp_ps_mask(values, values, _CMP_UNORD_Q);
+        const __m512i result    = _mm512_mask_blend_epi32(isNaN, rounded, _mm512_or_si512(upper, quiet));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm512_cvtepi32_epi16(result));
+    }
+
+    float32ToBFloat16Avx2(source + i * sizeof(float), destination + i, count - i);
+}
+
+template <typename Integer>
+BINIO_TARGET("avx512f")
+void float32ToIntegerAvx512(const char* source, Integer* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    const __m512 lowest     = _mm512_set1_ps(static_cast<float>(std::numeric_limits<Integer>::lowest()));
+    const __m512 highest    = _mm512_set1_ps(static_cast<float>(std::numeric_limits<Integer>::max()));
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512 values     = _mm512_loadu_ps(reinterpret_cast<const float*>(source) + i);
+        const __m512i integers  = _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(values, lowest), highest));
+
+        // Values are clamped to the range of Integer, so the truncating down-conversions are exact
+        if constexpr (sizeof(Integer) == 2)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm512_cvtepi32_epi16(integers));
+        else
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm512_cvtepi32_epi8(integers));
+    }
+
+    float32ToIntegerAvx2(source + i * sizeof(float), destination + i, count - i);
+}
+
+BINIO_TARGET("avx512f")
+void uint8ToFloat32Avx512(const char* source, float* destination, std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+        _mm512_storeu_ps(destination + i, _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes)));
+    }
+
+    uint8ToFloat32Avx2(source + i, destination + i, count - i);
+}
+
+template <typename Code>
+BINIO_TARGET("avx512f")
+void dequantizeAvx512(const char* source, float* destination, std::size_t count, const float* scales, const float* offsets)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512i codes;
+
+        if constexpr (sizeof(Code) == 1)
+            codes = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+        else
+            codes = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * sizeof(Code))));
+
+        // AVX-512 always has fused multiply-add, which may differ from the other kernels in the last bit
+        _mm512_storeu_ps(destination + i, _mm512_fmadd_ps(_mm512_loadu_ps(scales + i), _mm512_cvtepi32_ps(codes), _mm512_loadu_ps(offsets + i)));
+    }
+
+    dequantizeAvx2<Code>(source + i * sizeof(Code), destination + i, count - i, scales + i, offsets + i);
+}
+
+#endif // BINIO_X86
+
+SimdLevel detectSimdLevel()
+{
+#ifdef BINIO_X86
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse41    = (info[2] & (1 << 19)) != 0;
+        const bool osxsave  = (info[2] & (1 << 27)) != 0;
+
+        // The OS has to save the YMM (and ZMM) registers on context switches
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        const bool ymmEnabled = (xcr0 & 0x06) == 0x06;
+        const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+        bool avx2 = false, avx512 = false;
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2    = (info[1] & (1 << 5)) != 0;
+            avx512  = (info[1] & (1 << 16)) != 0;
+        }
+
+        if (avx512 && zmmEnabled)
+            return SimdLevel::AVX512;
+
+        if (avx2 && ymmEnabled)
+            return SimdLevel::AVX2;
+
+        if (sse41)
+            return SimdLevel::SSE41;
+    #else
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::AVX512;
+
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+
+        if (__builtin_cpu_supports("sse4.1"))
+            return SimdLevel::SSE41;
+    #endif
+#endif
+
+    return SimdLevel::Scalar;
+}
+
+ConversionKernels makeConversionKernels(SimdLevel simdLevel)
+{
+    ConversionKernels kernels = {
+        float32ToBFloat16Scalar,
+        float32ToIntegerScalar<std::int16_t>,
+        float32ToIntegerScalar<std::uint16_t>,
+        float32ToIntegerScalar<std::int8_t>,
+        float32ToIntegerScalar<std::uint8_t>,
+        uint8ToFloat32Scalar,
+        uint8ToBFloat16Scalar,
+        uint8ToInteger<std::int16_t>,
+        uint8ToInteger<std::uint16_t>,
+        uint8ToInteger<std::int8_t>,
+        dequantizeScalar<std::uint8_t>,
+        dequantizeScalar<std::uint16_t>
+    };
+
+#ifdef BINIO_X86
+    switch (simdLevel)
+    {
+        case SimdLevel::AVX512:
+            kernels.float32ToBFloat16   = float32ToBFloat16Avx512;
+            kernels.float32ToInt16      = float32ToIntegerAvx512<std::int16_t>;
+            kernels.float32ToUInt16     = float32ToIntegerAvx512<std::uint16_t>;
+            kernels.float32ToInt8       = float32ToIntegerAvx512<std::int8_t>;
+            kernels.float32ToUInt8      = float32ToIntegerAvx512<std::uint8_t>;
+            kernels.uint8ToFloat32      = uint8ToFloat32Avx512;
+            kernels.uint8ToBFloat16     = uint8ToBFloat16Avx2;
+            kernels.dequantizeUInt8     = dequantizeAvx512<std::uint8_t>;
+            kernels.dequantizeUInt16    = dequantizeAvx512<std::uint16_t>;
+            break;
+
+        case SimdLevel::AVX2:
+            kernels.float32ToBFloat16   = float32ToBFloat16Avx2;
+            kernels.float32ToInt16      = float32ToIntegerAvx2<std::int16_t>;
+            kernels.float32ToUInt16     = float32ToIntegerAvx2<std::uint16_t>;
+            kernels.float32ToInt8       = float32ToIntegerAvx2<std::int8_t>;
+            kernels.float32ToUInt8      = float32ToIntegerAvx2<std::uint8_t>;
+            kernels.uint8ToFloat32      = uint8ToFloat32Avx2;
+            kernels.uint8ToBFloat16     = uint8ToBFloat16Avx2;
+            kernels.dequantizeUInt8     = dequantizeAvx2<std::uint8_t>;
+            kernels.dequantizeUInt16    = dequantizeAvx2<std::uint16_t>;
+            break;
+
+        case SimdLevel::SSE41:
+            kernels.float32ToBFloat16   = float32ToBFloat16Sse41;
+            kernels.float32ToInt16      = float32ToIntegerSse41<std::int16_t>;
+            kernels.float32ToUInt16     = float32ToIntegerSse41<std::uint16_t>;
+            kernels.float32ToInt8       = float32ToIntegerSse41<std::int8_t>;
+            kernels.float32ToUInt8      = float32ToIntegerSse41<std::uint8_t>;
+            kernels.uint8ToFloat32      = uint8ToFloat32Sse41;
+            kernels.uint8ToBFloat16     = uint8ToBFloat16Sse41;
+            kernels.dequantizeUInt8     = dequantizeSse41<std::uint8_t>;
+            kernels.dequantizeUInt16    = dequantizeSse41<std::uint16_t>;
+            break;
+
+        case SimdLevel::Scalar:
+            break;
+    }
+#else
+    static_cast<void>(simdLevel);
+#endif
+
+    return kernels;
+}
+
+}
+
+SimdLevel getSimdLevel()
+{
+    static const SimdLevel simdLevel = detectSimdLevel();
+    return simdLevel;
+}
+
+const char* getSimdLevelName(SimdLevel simdLevel)
+{
+    switch (simdLevel)
+    {
+        case SimdLevel::AVX512: return "AVX-512";
+        case SimdLevel::AVX2:   return "AVX2";
+        case SimdLevel::SSE41:  return "SSE4.1";
+        case SimdLevel::Scalar: break;
+    }
+
+    return "Scalar";
+}
+
+const ConversionKernels& getConversionKernels()
+{
+    static const ConversionKernels kernels = makeConversionKernels(getSimdLevel());
+    return kernels;
+}
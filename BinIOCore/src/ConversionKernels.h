@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/**
+ * Element conversion kernels
+ *
+ * Each kernel converts count elements from raw (possibly unaligned) source
+ * bytes into a destination buffer that the caller has sized up front. Kernels
+ * with a SIMD implementation are selected once at runtime, based on the
+ * instruction sets the CPU supports (SSE4.1, AVX2, AVX-512), and fall back to
+ * plain loops otherwise.
+ *
+ * Conversion rules:
+ *  - float to bfloat16 rounds to nearest even, NaN stays NaN
+ *  - float to an integer type truncates toward zero and saturates to the
+ *    range of the integer type, NaN becomes the lowest value of that type
+ *  - integer to integer conversions saturate as well
+ *
+ * Pairs without a dedicated kernel (e.g. int16 to bfloat16) convert through
+ * float, which represents all of the 8 and 16 bit source types exactly.
+ * int32, uint32 and float64 sources round to the nearest float first, which
+ * only matters for float destinations: all other destination types have at
+ * most 16 bits.
+ *
+ * Sources in the byte order opposite to the machine's are wrapped in
+ * ByteSwapped; their bytes are swapped before they are converted.
+ */
+
+/** Raw bits of a bfloat16 value, layout compatible with biovault::bfloat16_t */
+struct BFloat16
+{
+    std::uint16_t bits;
+};
+
+/** Convert a float to bfloat16 bits, rounding to nearest even */
+inline BFloat16 floatToBFloat16(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+
+    // Keep NaN a (quiet) NaN, rounding could turn it into infinity
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u)
+        return { static_cast<std::uint16_t>((bits >> 16) | 0x0040u) };
+
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return { static_cast<std::uint16_t>(bits >> 16) };
+}
+
+/** Convert bfloat16 bits to float (exact) */
+inline float bfloat16ToFloat(BFloat16 value)
+{
+    const std::uint32_t bits = static_cast<std::uint32_t>(value.bits) << 16;
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(float));
+    return result;
+}
+
+/** Raw bits of an IEEE 754 half precision (float16) value */
+struct Float16
+{
+    std::uint16_t bits;
+};
+
+/** Convert float16 bits to float (exact, including subnormals, infinities and NaN) */
+inline float float16ToFloat(Float16 value)
+{
+    const std::uint32_t sign    = static_cast<std::uint32_t>(value.bits & 0x8000u) << 16;
+    std::uint32_t exponent      = (value.bits >> 10) & 0x1Fu;
+    std::uint32_t mantissa      = value.bits & 0x3FFu;
+    std::uint32_t bits;
+
+    if (exponent == 0x1Fu)
+    {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0)
+    {
+        bits = sign;
+    }
+    else
+    {
+        // Normalize the subnormal value, float has the exponent range to represent it
+        exponent = 113;
+
+        while ((mantissa & 0x400u) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(float));
+    return result;
+}
+
+/** Element of type T that is stored in the byte order opposite to the machine's */
+template <typename T>
+struct ByteSwapped
+{
+    T value;
+};
+
+template <typename T>
+struct IsByteSwapped : std::false_type { };
+
+template <typename T>
+struct IsByteSwapped<ByteSwapped<T>> : std::true_type { };
+
+/** Reverse the bytes of a value */
+template <typename T>
+inline T swapBytes(T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+/** Convert a float to an integer type, truncating and saturating (same clamping order as the SIMD min/max instructions, so NaN ends up at the lowest value) */
+template <typename Integer>
+inline Integer saturateFloat(float value)
+{
+    constexpr auto lowest   = static_cast<float>(std::numeric_limits<Integer>::lowest());
+    constexpr auto highest  = static_cast<float>(std::numeric_limits<Integer>::max());
+
+    value = value > lowest ? value : lowest;
+    value = value < highest ? value : highest;
+
+    return static_cast<Integer>(value);
+}
+
+/** Convert a single element to float */
+template <typename Source>
+inline float elementToFloat(Source value)
+{
+    if constexpr (IsByteSwapped<Source>::value)
+        return elementToFloat(swapBytes(value.value));
+    else if constexpr (std::is_same_v<Source, BFloat16>)
+        return bfloat16ToFloat(value);
+    else if constexpr (std::is_same_v<Source, Float16>)
+        return float16ToFloat(value);
+    else
+        return static_cast<float>(value);
+}
+
+/** Convert a float to a single element, following the conversion rules */
+template <typename Destination>
+inline Destination floatToElement(float value)
+{
+    if constexpr (std::is_same_v<Destination, BFloat16>)
+        return floatToBFloat16(value);
+    else if constexpr (std::is_same_v<Destination, float>)
+        return value;
+    else
+        return saturateFloat<Destination>(value);
+}
+
+enum class SimdLevel
+{
+    Scalar, SSE41, AVX2, AVX512
+};
+
+/** Get the SIMD level of the conversion kernels in use */
+SimdLevel getSimdLevel();
+
+/** Get a readable name of the given SIMD level */
+const char* getSimdLevelName(SimdLevel simdLevel);
+
+/** Table of the runtime dispatched conversion kernels */
+struct ConversionKernels
+{
+    void (*float32ToBFloat16)(const char* source, BFloat16* destination, std::size_t count);
+    void (*float32ToInt16)(const char* source, std::int16_t* destination, std::size_t count);
+    void (*float32ToUInt16)(const char* source, std::uint16_t* destination, std::size_t count);
+    void (*float32ToInt8)(const char* source, std::int8_t* destination, std::size_t count);
+    void (*float32ToUInt8)(const char* source, std::uint8_t* destination, std::size_t count);
+
+    void (*uint8ToFloat32)(const char* source, float* destination, std::size_t count);
+    void (*uint8ToBFloat16)(const char* source, BFloat16* destination, std::size_t count);
+    void (*uint8ToInt16)(const char* source, std::int16_t* destination, std::size_t count);
+    void (*uint8ToUInt16)(const char* source, std::uint16_t* destination, std::size_t count);
+    void (*uint8ToInt8)(const char* source, std::int8_t* destination, std::size_t count);
+
+    void (*dequantizeUInt8)(const char* source, float* destination, std::size_t count, const float* scales, const float* offsets);
+    void (*dequantizeUInt16)(const char* source, float* destination, std::size_t count, const float* scales, const float* offsets);
+};
+
+/** Get the kernels for the best SIMD level of this CPU (selected on first use) */
+const ConversionKernels& getConversionKernels();
+
+/*! Convert count elements of type Source, stored as raw bytes, into destination
+ *
+ * Source is one of the kernel element types (int8 to uint32, Float16,
+ * BFloat16, float, double), possibly wrapped in ByteSwapped. Destination is
+ * one of the element types of PointData, in kernel representation.
+ *
+ * \param source Raw source bytes, need not be aligned
+ * \param destination Destination buffer of at least count elements
+ * \param count Number of elements to convert
+*/
+template <typename Source, typename Destination>
+void convertElements(const char* source, Destination* destination, std::size_t count)
+{
+    const auto& kernels = getConversionKernels();
+
+    if constexpr (std::is_same_v<Source, Destination>)
+    {
+        std::memcpy(destination, source, count * sizeof(Source));
+    }
+    else if constexpr (std::is_same_v<Source, ByteSwapped<Destination>>)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Destination value;
+            std::memcpy(&value, source + i * sizeof(Destination), sizeof(Destination));
+
+            destination[i] = swapBytes(value);
+        }
+    }
+    else if constexpr (std::is_same_v<Source, float>)
+    {
+        if constexpr (std::is_same_v<Destination, BFloat16>)
+            kernels.float32ToBFloat16(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::int16_t>)
+            kernels.float32ToInt16(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::uint16_t>)
+            kernels.float32ToUInt16(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::int8_t>)
+            kernels.float32ToInt8(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::uint8_t>)
+            kernels.float32ToUInt8(source, destination, count);
+        else
+            static_assert(!sizeof(Destination), "Unsupported destination type");
+    }
+    else if constexpr (std::is_same_v<Source, std::uint8_t>)
+    {
+        if constexpr (std::is_same_v<Destination, float>)
+            kernels.uint8ToFloat32(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, BFloat16>)
+            kernels.uint8ToBFloat16(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::int16_t>)
+            kernels.uint8ToInt16(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::uint16_t>)
+            kernels.uint8ToUInt16(source, destination, count);
+        else if constexpr (std::is_same_v<Destination, std::int8_t>)
+            kernels.uint8ToInt8(source, destination, count);
+        else
+            static_assert(!sizeof(Destination), "Unsupported destination type");
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Source value;
+            std::memcpy(&value, source + i * sizeof(Source), sizeof(Source));
+
+            destination[i] = floatToElement<Destination>(elementToFloat(value));
+        }
+    }
+}
+
+/*! Dequantize count codes of type Code, stored as raw bytes, into destination
+ *
+ * Every code becomes offsets[i] + scales[i] * code, see Quantization.h. The
+ * uint8 and uint16 codes of the machine's byte order are dequantized by SIMD
+ * kernels; other destination types than float are converted from the float
+ * values, following the conversion rules.
+ *
+ * \param source Raw codes, need not be aligned
+ * \param destination Destination buffer of at least count elements
+ * \param count Number of codes to dequantize
+ * \param scales Scale of every code
+ * \param offsets Offset of every code
+*/
+template <typename Code, typename Destination>
+void dequantizeElements(const char* source, Destination* destination, std::size_t count, const float* scales, const float* offsets)
+{
+    const auto& kernels = getConversionKernels();
+
+    if constexpr (!std::is_same_v<Destination, float>)
+    {
+        // Dequantize to float in blocks that stay in the L1 cache, then convert
+        constexpr std::size_t blockSize = 256;
+
+        float values[blockSize];
+
+        for (std::size_t first = 0; first < count; first += blockSize)
+        {
+            const std::size_t numValues = std::min(blockSize, count - first);
+
+            dequantizeElements<Code>(source + first * sizeof(Code), values, numValues, scales + first, offsets + first);
+            convertElements<float>(reinterpret_cast<const char*>(values), destination + first, numValues);
+        }
+    }
+    else if constexpr (std::is_same_v<Code, std::uint8_t>)
+    {
+        kernels.dequantizeUInt8(source, destination, count, scales, offsets);
+    }
+    else if constexpr (std::is_same_v<Code, std::uint16_t>)
+    {
+        kernels.dequantizeUInt16(source, destination, count, scales, offsets);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Code code;
+            std::memcpy(&code, source + i * sizeof(Code), sizeof(Code));
+
+            destination[i] = offsets[i] + scales[i] * elementToFloat(code);
+        }
+    }
+}
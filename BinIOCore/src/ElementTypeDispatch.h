@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ConversionKernels.h"
+#include "FileFormat.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Compile-time dispatch over the element types of a file
+ *
+ * Every element type code (see ElementType) and byte order of a file maps to
+ * one kernel element type: the type itself when the file has the byte order
+ * of this machine, otherwise the type wrapped in ByteSwapped. Tables of
+ * functions that are specialized for all of these types are generated at
+ * compile time and indexed by getFileElementTypeIndex, so that selecting the
+ * kernel for a file is a single lookup.
+ */
+
+/** Kernel element types in the order of their ElementType codes */
+using KernelElementTypes = std::tuple<std::int8_t, std::uint8_t, std::int16_t, std::uint16_t, std::int32_t, std::uint32_t, Float16, BFloat16, float, double>;
+
+/** Number of combinations of an element type and a byte order */
+constexpr std::size_t numberOfFileElementTypes = 2 * std::tuple_size_v<KernelElementTypes>;
+
+/** Get the index of the element type and byte order of a file in a table of makeFileElementTypeTable */
+constexpr std::size_t getFileElementTypeIndex(ElementType elementType, ByteOrder byteOrder)
+{
+    return 2 * (static_cast<std::size_t>(elementType) - static_cast<std::size_t>(ElementType::Int8)) + static_cast<std::size_t>(byteOrder);
+}
+
+/** Kernel element type of the file element type at Index, see getFileElementTypeIndex */
+template <std::size_t Index>
+using FileElementTypeAt = std::conditional_t<
+    (static_cast<ByteOrder>(Index % 2) == ByteOrder::BigEndian) == (std::endian::native == std::endian::big),
+    std::tuple_element_t<Index / 2, KernelElementTypes>,
+    ByteSwapped<std::tuple_element_t<Index / 2, KernelElementTypes>>>;
+
+static_assert(getFileElementTypeIndex(ElementType::Float64, ByteOrder::BigEndian) == numberOfFileElementTypes - 1, "Element type codes must be consecutive");
+
+/*! Make a table of Factory::template get<Source>() for all file element types
+ *
+ * Factory::get returns the function (pointer) that is specialized for kernel
+ * element type Source. The table is indexed by getFileElementTypeIndex.
+*/
+template <typename Factory>
+constexpr auto makeFileElementTypeTable()
+{
+    return []<std::size_t... Indices>(std::index_sequence<Indices...>) {
+        return std::array{ Factory::template get<FileElementTypeAt<Indices>>()... };
+    }(std::make_index_sequence<numberOfFileElementTypes>());
+}
@@ -0,0 +1,488 @@
+#include "FileFormat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr char magic[8] = { 'B', 'I', 'N', 'I', 'O', '\r', '\n', '\x1A' };
+
+// Required feature flags this version of the reader understands
+constexpr std::uint32_t knownFlags = FileFlags::BlockCompressed | FileFlags::Indices | FileFlags::Quantized;
+
+template <typename T>
+T readLittleEndian(const char* bytes)
+{
+    T value = 0;
+
+    for (std::size_t i = 0; i < sizeof(T); i++)
+        value |= static_cast<T>(static_cast<std::uint8_t>(bytes[i])) << (8 * i);
+
+    return value;
+}
+
+template <typename T>
+void writeLittleEndian(char* bytes, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+bool isValidElementType(std::uint8_t elementType)
+{
+    return elementType >= static_cast<std::uint8_t>(ElementType::Int8) && elementType <= static_cast<std::uint8_t>(ElementType::UInt64);
+}
+
+}
+
+std::size_t getElementSize(ElementType elementType)
+{
+    switch (elementType)
+    {
+        case ElementType::Int8:
+        case ElementType::UInt8:
+            return 1;
+
+        case ElementType::Int16:
+        case ElementType::UInt16:
+        case ElementType::Float16:
+        case ElementType::BFloat16:
+            return 2;
+
+        case ElementType::Int32:
+        case ElementType::UInt32:
+        case ElementType::Float32:
+            return 4;
+
+        case ElementType::Float64:
+        case ElementType::UInt64:
+            return 8;
+    }
+
+    return 0;
+}
+
+const char* getElementTypeName(ElementType elementType)
+{
+    switch (elementType)
+    {
+        case ElementType::Int8:     return "int8";
+        case ElementType::UInt8:    return "uint8";
+        case ElementType::Int16:    return "int16";
+        case ElementType::UInt16:   return "uint16";
+        case ElementType::Int32:    return "int32";
+        case ElementType::UInt32:   return "uint32";
+        case ElementType::Float16:  return "float16";
+        case ElementType::BFloat16: return "bfloat16";
+        case ElementType::Float32:  return "float32";
+        case ElementType::Float64:  return "float64";
+        case ElementType::UInt64:   return "uint64";
+    }
+
+    return "unknown";
+}
+
+const char* getIndexEncodingName(IndexEncoding encoding)
+{
+    switch (encoding)
+    {
+        case IndexEncoding::Plain:  return "plain";
+        case IndexEncoding::Runs:   return "runs";
+        case IndexEncoding::Bitmap: return "bitmap";
+    }
+
+    return "unknown";
+}
+
+ByteOrder getNativeByteOrder()
+{
+    return std::endian::native == std::endian::big ? ByteOrder::BigEndian : ByteOrder::LittleEndian;
+}
+
+bool hasFileHeader(const char* bytes, std::size_t size)
+{
+    return size >= sizeof(magic) && std::memcmp(bytes, magic, sizeof(magic)) == 0;
+}
+
+FileHeader parseFileHeader(const char* bytes, std::size_t size)
+{
+    if (!hasFileHeader(bytes, size))
+        throw std::runtime_error("Not a BinIO v2 file.");
+
+    if (size < 64)
+        throw std::runtime_error("The file header is truncated.");
+
+    FileHeader header;
+
+    header.version = readLittleEndian<std::uint32_t>(bytes + 8);
+    header.flags   = readLittleEndian<std::uint32_t>(bytes + 12);
+
+    if (header.version != FileHeader::currentVersion)
+        throw std::runtime_error("Unsupported BinIO file version " + std::to_string(header.version) + ".");
+
+    if ((header.flags & ~knownFlags) != 0)
+        throw std::runtime_error("The file uses features that this version of the loader does not support.");
+
+    const auto elementType  = static_cast<std::uint8_t>(bytes[16]);
+    const auto byteOrder    = static_cast<std::uint8_t>(bytes[17]);
+    const auto layout       = static_cast<std::uint8_t>(bytes[18]);
+
+    if (!isValidElementType(elementType))
+        throw std::runtime_error("Unknown element type " + std::to_string(elementType) + " in the file header.");
+
+    if (byteOrder > static_cast<std::uint8_t>(ByteOrder::BigEndian))
+        throw std::runtime_error("Unknown byte order in the file header.");
+
+    if (layout > static_cast<std::uint8_t>(Layout::ColumnMajor))
+        throw std::runtime_error("Unknown data layout in the file header.");
+
+    header.elementType  = static_cast<ElementType>(elementType);
+    header.byteOrder    = static_cast<ByteOrder>(byteOrder);
+    header.layout       = static_cast<Layout>(layout);
+
+    // Point values are of the element types up to float64, uint64 only holds indices
+    if (header.elementType == ElementType::UInt64 && !(header.flags & FileFlags::Indices))
+        throw std::runtime_error("The element type uint64 is only supported for index files.");
+
+    if ((header.flags & FileFlags::Indices) && (header.flags & FileFlags::BlockCompressed))
+        throw std::runtime_error("Index files cannot be block-compressed.");
+
+    if (header.flags & FileFlags::Quantized)
+    {
+        if (header.flags & FileFlags::Indices)
+            throw std::runtime_error("Index files cannot be quantized.");
+
+        if (header.elementType != ElementType::UInt8 && header.elementType != ElementType::UInt16)
+            throw std::runtime_error("Quantized data must be stored as uint8 or uint16 codes.");
+
+        if (header.layout != Layout::RowMajor)
+            throw std::runtime_error("Quantized data must be stored row-major.");
+    }
+
+    const auto numberOfSections = readLittleEndian<std::uint32_t>(bytes + 20);
+
+    header.numRows      = readLittleEndian<std::uint64_t>(bytes + 24);
+    header.numColumns   = readLittleEndian<std::uint64_t>(bytes + 32);
+    header.dataOffset   = readLittleEndian<std::uint64_t>(bytes + 40);
+    header.dataSize     = readLittleEndian<std::uint64_t>(bytes + 48);
+
+    if (numberOfSections > FileHeader::maxSections)
+        throw std::runtime_error("Invalid number of sections in the file header.");
+
+    if (size < 64 + 24 * std::size_t(numberOfSections))
+        throw std::runtime_error("The file header is truncated.");
+
+    for (std::uint32_t sectionIndex = 0; sectionIndex < numberOfSections; sectionIndex++)
+    {
+        const char* const entry = bytes + 64 + 24 * std::size_t(sectionIndex);
+
+        FileSection section;
+
+        section.type    = readLittleEndian<std::uint32_t>(entry);
+        section.offset  = readLittleEndian<std::uint64_t>(entry + 8);
+        section.size    = readLittleEndian<std::uint64_t>(entry + 16);
+
+        header.sections.push_back(section);
+    }
+
+    if (header.numColumns == 0)
+        throw std::runtime_error("The file header specifies zero dimensions.");
+
+    if (header.dataOffset < 64)
+        throw std::runtime_error("Invalid data offset in the file header.");
+
+    return header;
+}
+
+const FileSection* findSection(const FileHeader& header, SectionType type)
+{
+    for (const auto& section : header.sections)
+        if (section.type == static_cast<std::uint32_t>(type))
+            return &section;
+
+    return nullptr;
+}
+
+std::vector<char> serializeFileHeader(const FileHeader& header)
+{
+    if (header.sections.size() > FileHeader::maxSections)
+        throw std::runtime_error("Too many sections for the file header.");
+
+    std::vector<char> bytes(FileHeader::headerSize, 0);
+
+    std::memcpy(bytes.data(), magic, sizeof(magic));
+
+    writeLittleEndian(bytes.data() + 8, header.version);
+    writeLittleEndian(bytes.data() + 12, header.flags);
+
+    bytes[16] = static_cast<char>(header.elementType);
+    bytes[17] = static_cast<char>(header.byteOrder);
+    bytes[18] = static_cast<char>(header.layout);
+
+    writeLittleEndian(bytes.data() + 20, static_cast<std::uint32_t>(header.sections.size()));
+    writeLittleEndian(bytes.data() + 24, header.numRows);
+    writeLittleEndian(bytes.data() + 32, header.numColumns);
+    writeLittleEndian(bytes.data() + 40, header.dataOffset);
+    writeLittleEndian(bytes.data() + 48, header.dataSize);
+
+    for (std::size_t sectionIndex = 0; sectionIndex < header.sections.size(); sectionIndex++)
+    {
+        char* const entry = bytes.data() + 64 + 24 * sectionIndex;
+
+        writeLittleEndian(entry, header.sections[sectionIndex].type);
+        writeLittleEndian(entry + 8, header.sections[sectionIndex].offset);
+        writeLittleEndian(entry + 16, header.sections[sectionIndex].size);
+    }
+
+    return bytes;
+}
+
+void validateFileSize(const FileHeader& header, std::uint64_t fileSize)
+{
+    const std::uint64_t elementSize = getElementSize(header.elementType);
+
+    if (header.flags & FileFlags::Indices)
+    {
+        if (findSection(header, SectionType::IndexInfo) == nullptr)
+            throw std::runtime_error("The index file has no index info.");
+    }
+    else if (header.flags & FileFlags::BlockCompressed)
+    {
+        if (findSection(header, SectionType::BlockIndex) == nullptr)
+            throw std::runtime_error("The file is compressed but has no block index.");
+
+        if (header.numRows > std::numeric_limits<std::uint64_t>::max() / elementSize / header.numColumns)
+            throw std::runtime_error("Invalid number of points in the file header.");
+    }
+    else if (header.numRows > header.dataSize / elementSize / header.numColumns || header.numRows * header.numColumns * elementSize != header.dataSize)
+        throw std::runtime_error("The data size in the file header does not match " + std::to_string(header.numRows) + " points of " + std::to_string(header.numColumns) + " " + getElementTypeName(header.elementType) + " dimensions.");
+
+    if ((header.flags & FileFlags::Quantized) && findSection(header, SectionType::Quantization) == nullptr)
+        throw std::runtime_error("The file is quantized but has no quantization table.");
+
+    if (header.dataOffset > fileSize || fileSize - header.dataOffset < header.dataSize)
+        throw std::runtime_error("The file is truncated: expected " + std::to_string(header.dataOffset + header.dataSize) + " bytes but found " + std::to_string(fileSize) + ".");
+
+    for (const auto& section : header.sections)
+        if (section.offset > fileSize || fileSize - section.offset < section.size)
+            throw std::runtime_error("The file is truncated: a section lies beyond the end of the file.");
+}
+
+BlockIndex parseBlockIndex(const FileHeader& header, const char* bytes, std::size_t size)
+{
+    if (size < 24)
+        throw std::runtime_error("The block index is truncated.");
+
+    BlockIndex blockIndex;
+
+    const auto codec    = static_cast<std::uint8_t>(bytes[0]);
+    const auto filter   = static_cast<std::uint8_t>(bytes[1]);
+
+    if (codec > static_cast<std::uint8_t>(BlockCodec::LZ))
+        throw std::runtime_error("Unknown compression codec " + std::to_string(codec) + " in the block index.");
+
+    if (filter > static_cast<std::uint8_t>(BlockFilter::ByteShuffle))
+        throw std::runtime_error("Unknown filter " + std::to_string(filter) + " in the block index.");
+
+    blockIndex.codec        = static_cast<BlockCodec>(codec);
+    blockIndex.filter       = static_cast<BlockFilter>(filter);
+    blockIndex.rowsPerBlock = readLittleEndian<std::uint64_t>(bytes + 8);
+    blockIndex.numRows      = header.numRows;
+
+    const auto numberOfBlocks = readLittleEndian<std::uint64_t>(bytes + 16);
+
+    if (blockIndex.rowsPerBlock == 0 && header.numRows > 0)
+        throw std::runtime_error("Invalid number of rows per block in the block index.");
+
+    if (numberOfBlocks != (header.numRows == 0 ? 0 : (header.numRows - 1) / blockIndex.rowsPerBlock + 1))
+        throw std::runtime_error("The number of blocks in the block index does not match the number of points.");
+
+    if (numberOfBlocks > (size - 24) / 8)
+        throw std::runtime_error("The block index is truncated.");
+
+    const std::uint64_t rowSize = header.numColumns * getElementSize(header.elementType);
+
+    blockIndex.blockOffsets.reserve(static_cast<std::size_t>(numberOfBlocks) + 1);
+    blockIndex.blockOffsets.push_back(0);
+
+    for (std::uint64_t blockNumber = 0; blockNumber < numberOfBlocks; blockNumber++)
+    {
+        const auto encodedSize  = readLittleEndian<std::uint64_t>(bytes + 24 + 8 * blockNumber);
+        const auto numBlockRows = std::min(blockIndex.rowsPerBlock, header.numRows - blockNumber * blockIndex.rowsPerBlock);
+
+        // Blocks never grow, incompressible blocks are stored as is
+        if (encodedSize > numBlockRows * rowSize)
+            throw std::runtime_error("Invalid block size in the block index.");
+
+        blockIndex.blockOffsets.push_back(blockIndex.blockOffsets.back() + encodedSize);
+    }
+
+    if (blockIndex.blockOffsets.back() != header.dataSize)
+        throw std::runtime_error("The blocks in the block index do not add up to the data size in the file header.");
+
+    return blockIndex;
+}
+
+std::vector<char> serializeBlockIndex(const BlockIndex& blockIndex)
+{
+    const std::size_t numberOfBlocks = blockIndex.getNumberOfBlocks();
+
+    std::vector<char> bytes(24 + 8 * numberOfBlocks, 0);
+
+    bytes[0] = static_cast<char>(blockIndex.codec);
+    bytes[1] = static_cast<char>(blockIndex.filter);
+
+    writeLittleEndian(bytes.data() + 8, blockIndex.rowsPerBlock);
+    writeLittleEndian(bytes.data() + 16, static_cast<std::uint64_t>(numberOfBlocks));
+
+    for (std::size_t blockNumber = 0; blockNumber < numberOfBlocks; blockNumber++)
+        writeLittleEndian(bytes.data() + 24 + 8 * blockNumber, blockIndex.blockOffsets[blockNumber + 1] - blockIndex.blockOffsets[blockNumber]);
+
+    return bytes;
+}
+
+IndexInfo parseIndexInfo(const char* bytes, std::size_t size)
+{
+    if (size < 16)
+        throw std::runtime_error("The index info is truncated.");
+
+    const auto encoding = static_cast<std::uint8_t>(bytes[0]);
+
+    if (encoding > static_cast<std::uint8_t>(IndexEncoding::Bitmap))
+        throw std::runtime_error("Unknown index encoding " + std::to_string(encoding) + " in the index info.");
+
+    IndexInfo indexInfo;
+
+    indexInfo.encoding  = static_cast<IndexEncoding>(encoding);
+    indexInfo.numPoints = readLittleEndian<std::uint64_t>(bytes + 8);
+
+    return indexInfo;
+}
+
+std::vector<char> serializeIndexInfo(const IndexInfo& indexInfo)
+{
+    std::vector<char> bytes(16, 0);
+
+    bytes[0] = static_cast<char>(indexInfo.encoding);
+
+    writeLittleEndian(bytes.data() + 8, indexInfo.numPoints);
+
+    return bytes;
+}
+
+QuantizationTable parseQuantizationTable(const FileHeader& header, const char* bytes, std::size_t size)
+{
+    if (size / 8 != header.numColumns || size % 8 != 0)
+        throw std::runtime_error("The quantization table does not match " + std::to_string(header.numColumns) + " dimensions.");
+
+    QuantizationTable quantizationTable;
+
+    quantizationTable.scales.resize(static_cast<std::size_t>(header.numColumns));
+    quantizationTable.offsets.resize(static_cast<std::size_t>(header.numColumns));
+
+    for (std::size_t column = 0; column < quantizationTable.scales.size(); column++)
+    {
+        const float scale   = std::bit_cast<float>(readLittleEndian<std::uint32_t>(bytes + 8 * column));
+        const float offset  = std::bit_cast<float>(readLittleEndian<std::uint32_t>(bytes + 8 * column + 4));
+
+        if (!std::isfinite(scale) || !std::isfinite(offset))
+            throw std::runtime_error("Invalid scale or offset of dimension " + std::to_string(column) + " in the quantization table.");
+
+        quantizationTable.scales[column]    = scale;
+        quantizationTable.offsets[column]   = offset;
+    }
+
+    return quantizationTable;
+}
+
+std::vector<char> serializeQuantizationTable(const QuantizationTable& quantizationTable)
+{
+    std::vector<char> bytes(8 * quantizationTable.scales.size(), 0);
+
+    for (std::size_t column = 0; column < quantizationTable.scales.size(); column++)
+    {
+        writeLittleEndian(bytes.data() + 8 * column, std::bit_cast<std::uint32_t>(quantizationTable.scales[column]));
+        writeLittleEndian(bytes.data() + 8 * column + 4, std::bit_cast<std::uint32_t>(quantizationTable.offsets[column]));
+    }
+
+    return bytes;
+}
+
+std::vector<ColumnStatistics> parseColumnStatistics(const FileHeader& header, const char* bytes, std::size_t size)
+{
+    if (size / 40 != header.numColumns || size % 40 != 0)
+        throw std::runtime_error("The statistics do not match " + std::to_string(header.numColumns) + " dimensions.");
+
+    std::vector<ColumnStatistics> statistics(static_cast<std::size_t>(header.numColumns));
+
+    for (std::size_t column = 0; column < statistics.size(); column++)
+    {
+        const char* const entry = bytes + 40 * column;
+
+        statistics[column].count    = readLittleEndian<std::uint64_t>(entry);
+        statistics[column].min      = std::bit_cast<double>(readLittleEndian<std::uint64_t>(entry + 8));
+        statistics[column].max      = std::bit_cast<double>(readLittleEndian<std::uint64_t>(entry + 16));
+        statistics[column].mean     = std::bit_cast<double>(readLittleEndian<std::uint64_t>(entry + 24));
+        statistics[column].variance = std::bit_cast<double>(readLittleEndian<std::uint64_t>(entry + 32));
+    }
+
+    return statistics;
+}
+
+std::vector<char> serializeColumnStatistics(const std::vector<ColumnStatistics>& statistics)
+{
+    std::vector<char> bytes(40 * statistics.size(), 0);
+
+    for (std::size_t column = 0; column < statistics.size(); column++)
+    {
+        char* const entry = bytes.data() + 40 * column;
+
+        writeLittleEndian(entry, statistics[column].count);
+        writeLittleEndian(entry + 8, std::bit_cast<std::uint64_t>(statistics[column].min));
+        writeLittleEndian(entry + 16, std::bit_cast<std::uint64_t>(statistics[column].max));
+        writeLittleEndian(entry + 24, std::bit_cast<std::uint64_t>(statistics[column].mean));
+        writeLittleEndian(entry + 32, std::bit_cast<std::uint64_t>(statistics[column].variance));
+    }
+
+    return bytes;
+}
+
+BlockChecksums parseBlockChecksums(const FileHeader& header, const char* bytes, std::size_t size)
+{
+    if (size < 8 || size % 8 != 0)
+        throw std::runtime_error("The checksums section is truncated.");
+
+    BlockChecksums checksums;
+
+    checksums.blockSize = readLittleEndian<std::uint64_t>(bytes);
+    checksums.dataSize  = header.dataSize;
+
+    checksums.checksums.resize(size / 8 - 1);
+
+    for (std::size_t blockNumber = 0; blockNumber < checksums.checksums.size(); blockNumber++)
+        checksums.checksums[blockNumber] = readLittleEndian<std::uint64_t>(bytes + 8 + 8 * blockNumber);
+
+    if ((checksums.blockSize == 0) != ((header.flags & FileFlags::BlockCompressed) != 0))
+        throw std::runtime_error("The checksums do not match the compression of the data.");
+
+    if (checksums.blockSize > 0 && checksums.checksums.size() != (header.dataSize + checksums.blockSize - 1) / checksums.blockSize)
+        throw std::runtime_error("The checksums do not cover the " + std::to_string(header.dataSize) + " bytes of data.");
+
+    return checksums;
+}
+
+std::vector<char> serializeBlockChecksums(const BlockChecksums& checksums)
+{
+    std::vector<char> bytes(8 + 8 * checksums.checksums.size(), 0);
+
+    writeLittleEndian(bytes.data(), checksums.blockSize);
+
+    for (std::size_t blockNumber = 0; blockNumber < checksums.checksums.size(); blockNumber++)
+        writeLittleEndian(bytes.data() + 8 + 8 * blockNumber, checksums.checksums[blockNumber]);
+
+    return bytes;
+}
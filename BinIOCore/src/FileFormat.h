@@ -0,0 +1,374 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * BinIO file format, version 2
+ *
+ * A v2 .bin file starts with a fixed-size header that describes the data,
+ * followed by the data itself at dataOffset. Files without the header are
+ * legacy raw files: headerless, native byte order, described only by the
+ * settings in the loader dialog.
+ *
+ * All header fields are stored little-endian:
+ *
+ *   offset  size  field
+ *        0     8  magic "BINIO\r\n\x1A"
+ *        8     4  version
+ *       12     4  required feature flags (a reader rejects flags it does not know)
+ *       16     1  element type
+ *       17     1  byte order of the data
+ *       18     1  layout of the data
+ *       19     1  reserved (0)
+ *       20     4  number of sections
+ *       24     8  number of rows (points)
+ *       32     8  number of columns (dimensions)
+ *       40     8  data offset in bytes from the start of the file
+ *       48     8  data size in bytes
+ *       56     8  reserved (0)
+ *       64  24*n  section directory: type (4), reserved (4), offset (8), size (8)
+ *
+ * The header occupies headerSize bytes, so that the data starts page aligned,
+ * which suits memory mapping, direct I/O and aligned SIMD loads alike.
+ * Sections hold optional extra blocks of the file; readers ignore section
+ * types they do not know.
+ *
+ * Block-compressed files (FileFlags::BlockCompressed) split the rows into
+ * blocks of rowsPerBlock rows that are filtered and compressed separately,
+ * so that they can be decoded in parallel. The encoded blocks follow each
+ * other from dataOffset on, dataSize is their total size, and a section of
+ * type SectionType::BlockIndex locates them:
+ *
+ *   offset  size  field
+ *        0     1  codec
+ *        1     1  filter
+ *        2     6  reserved (0)
+ *        8     8  rows per block
+ *       16     8  number of blocks
+ *       24   8*n  encoded size of every block
+ *
+ * A block whose encoded size equals its raw size is stored as is.
+ *
+ * Index files (FileFlags::Indices) hold the indices of points, e.g. of a
+ * selection, instead of point values. numRows is the number of indices and
+ * numColumns is 1; the data is encoded as described by a section of type
+ * SectionType::IndexInfo:
+ *
+ *   offset  size  field
+ *        0     1  index encoding
+ *        1     7  reserved (0)
+ *        8     8  number of points of the data set the indices refer to (0 if unknown)
+ *
+ * Plain indices are stored as uint32 or uint64 words in their order, runs as
+ * (first index, number of indices) pairs of such words, and bitmaps as one
+ * bit per point (bit i % 8 of byte i / 8) with the element type uint8. See
+ * IndexCodec.h.
+ *
+ * Quantized files (FileFlags::Quantized) store every value as a uint8 or
+ * uint16 code of its dimension, value = offset + scale * code, row-major. A
+ * section of type SectionType::Quantization holds the scale and offset of
+ * every dimension as pairs of float32 values, i.e. 8 * numColumns bytes. See
+ * Quantization.h.
+ *
+ * Files may describe their values with an optional section of type
+ * SectionType::Statistics, which holds the number of finite values (uint64)
+ * and their minimum, maximum, mean and variance (float64) for every
+ * dimension, i.e. 40 * numColumns bytes. See Statistics.h.
+ *
+ * Files may protect their data with an optional section of type
+ * SectionType::Checksums, which holds 64-bit checksums of the stored data:
+ *
+ *   offset  size  field
+ *        0     8  block size in bytes, 0 for one checksum per block of block-compressed data
+ *        8   8*n  checksum of every block
+ *
+ * Uncompressed data is split into blocks of the block size from dataOffset
+ * on, the last block may be shorter; block-compressed data has a checksum of
+ * the encoded bytes of every block of its block index. See Checksum.h.
+ */
+
+/** Element type codes as stored in the header */
+enum class ElementType : std::uint8_t
+{
+    Int8        = 1,
+    UInt8       = 2,
+    Int16       = 3,
+    UInt16      = 4,
+    Int32       = 5,
+    UInt32      = 6,
+    Float16     = 7,
+    BFloat16    = 8,
+    Float32     = 9,
+    Float64     = 10,
+    UInt64      = 11    /** Only used by index files */
+};
+
+enum class ByteOrder : std::uint8_t
+{
+    LittleEndian    = 0,
+    BigEndian       = 1
+};
+
+enum class Layout : std::uint8_t
+{
+    RowMajor        = 0,    /** All dimensions of a point are consecutive */
+    ColumnMajor     = 1     /** All points of a dimension are consecutive */
+};
+
+/** Required feature flags */
+enum FileFlags : std::uint32_t
+{
+    BlockCompressed = 1u << 0,      /** The data is stored in separately compressed blocks, see BlockIndex */
+    Indices         = 1u << 1,      /** The data holds encoded point indices instead of point values, see IndexInfo */
+    Quantized       = 1u << 2       /** The data holds integer codes of the point values, see QuantizationTable */
+};
+
+/** Section types */
+enum class SectionType : std::uint32_t
+{
+    BlockIndex      = 1,            /** Block index of block-compressed data */
+    IndexInfo       = 2,            /** Encoding of the indices in an index file */
+    Quantization    = 3,            /** Scale and offset of every dimension of quantized data */
+    Statistics      = 4,            /** Minimum, maximum, mean and variance of every dimension, optional */
+    Checksums       = 5             /** Checksums of the blocks of the data, optional */
+};
+
+/** Compression codecs of block-compressed data */
+enum class BlockCodec : std::uint8_t
+{
+    None    = 0,    /** Blocks are stored as is */
+    LZ      = 1     /** Built-in LZ77 codec, see BlockCodec.h */
+};
+
+/** Filters that are applied to a block before it is compressed */
+enum class BlockFilter : std::uint8_t
+{
+    None        = 0,
+    ByteShuffle = 1     /** Groups byte k of all elements together, which makes numeric data compress better */
+};
+
+/** Encodings of the indices in an index file */
+enum class IndexEncoding : std::uint8_t
+{
+    Plain   = 0,    /** Every index as a uint32 or uint64 word */
+    Runs    = 1,    /** Runs of consecutive indices as (first index, length) pairs of words */
+    Bitmap  = 2     /** One bit per point, for indices in increasing order */
+};
+
+/** Entry of the section directory */
+struct FileSection
+{
+    std::uint32_t   type    = 0;    /** Section type, defined by the feature that writes it */
+    std::uint64_t   offset  = 0;    /** Offset in bytes from the start of the file */
+    std::uint64_t   size    = 0;    /** Size in bytes */
+};
+
+/** Header of a v2 .bin file */
+struct FileHeader
+{
+    static constexpr std::uint32_t  currentVersion  = 2;
+    static constexpr std::size_t    headerSize      = 4096;     /** Bytes reserved for the header, also the alignment of the data */
+    static constexpr std::size_t    maxSections     = (headerSize - 64) / 24;
+
+    std::uint32_t               version         = currentVersion;
+    std::uint32_t               flags           = 0;
+    ElementType                 elementType     = ElementType::Float32;
+    ByteOrder                   byteOrder       = ByteOrder::LittleEndian;
+    Layout                      layout          = Layout::RowMajor;
+    std::uint64_t               numRows         = 0;
+    std::uint64_t               numColumns      = 0;
+    std::uint64_t               dataOffset      = headerSize;
+    std::uint64_t               dataSize        = 0;
+    std::vector<FileSection>    sections;
+};
+
+/** Location of the blocks of block-compressed data */
+struct BlockIndex
+{
+    BlockCodec                  codec           = BlockCodec::LZ;
+    BlockFilter                 filter          = BlockFilter::ByteShuffle;
+    std::uint64_t               rowsPerBlock    = 0;
+    std::uint64_t               numRows         = 0;    /** Number of rows over all blocks, from the file header */
+    std::vector<std::uint64_t>  blockOffsets;           /** Offset of every block relative to the data offset, plus the end of the last block */
+
+    /** Get the number of blocks */
+    std::size_t getNumberOfBlocks() const {
+        return blockOffsets.empty() ? 0 : blockOffsets.size() - 1;
+    }
+};
+
+/** Contents of the SectionType::IndexInfo section of an index file */
+struct IndexInfo
+{
+    IndexEncoding   encoding    = IndexEncoding::Plain;
+    std::uint64_t   numPoints   = 0;    /** Number of points of the data set the indices refer to, 0 if unknown */
+};
+
+/** Contents of the SectionType::Quantization section: value = offsets[column] + scales[column] * code */
+struct QuantizationTable
+{
+    std::vector<float>  scales;     /** Scale of every column, 0 for columns with a single value */
+    std::vector<float>  offsets;    /** Offset of every column, the value of code 0 */
+};
+
+/** Statistics of the finite values of a column, as stored in the SectionType::Statistics section */
+struct ColumnStatistics
+{
+    std::uint64_t   count       = 0;    /** Number of finite values, the other fields are 0 without any */
+    double          min         = 0;
+    double          max         = 0;
+    double          mean        = 0;
+    double          variance    = 0;    /** Population variance */
+};
+
+/** Contents of the SectionType::Checksums section */
+struct BlockChecksums
+{
+    std::uint64_t               blockSize   = 0;    /** Bytes of data per checksum, 0 for one checksum per block of block-compressed data */
+    std::uint64_t               dataSize    = 0;    /** Bytes of data the checksums cover, from the file header */
+    std::vector<std::uint64_t>  checksums;          /** Checksum of every block in file order, see computeChecksum */
+};
+
+/** Get the element type code of a standard arithmetic type */
+template <typename T>
+constexpr ElementType getElementType()
+{
+    if constexpr (std::is_same_v<T, std::int8_t>)
+        return ElementType::Int8;
+    else if constexpr (std::is_same_v<T, std::uint8_t>)
+        return ElementType::UInt8;
+    else if constexpr (std::is_same_v<T, std::int16_t>)
+        return ElementType::Int16;
+    else if constexpr (std::is_same_v<T, std::uint16_t>)
+        return ElementType::UInt16;
+    else if constexpr (std::is_same_v<T, std::int32_t>)
+        return ElementType::Int32;
+    else if constexpr (std::is_same_v<T, std::uint32_t>)
+        return ElementType::UInt32;
+    else if constexpr (std::is_same_v<T, std::uint64_t>)
+        return ElementType::UInt64;
+    else if constexpr (std::is_same_v<T, float>)
+        return ElementType::Float32;
+    else if constexpr (std::is_same_v<T, double>)
+        return ElementType::Float64;
+    else
+        static_assert(!sizeof(T), "No element type code for this type");
+}
+
+/** Get the size in bytes of one element of the given type */
+std::size_t getElementSize(ElementType elementType);
+
+/** Get a readable name of the given element type, e.g. "float32" */
+const char* getElementTypeName(ElementType elementType);
+
+/** Get a readable name of the given index encoding, e.g. "runs" */
+const char* getIndexEncodingName(IndexEncoding encoding);
+
+/** Get the byte order of this machine */
+ByteOrder getNativeByteOrder();
+
+/** Check whether bytes start with the v2 magic (size is the number of available bytes) */
+bool hasFileHeader(const char* bytes, std::size_t size);
+
+/*! Parse and validate a v2 header
+ *
+ * Throws std::runtime_error when the header is truncated, of an unknown
+ * version, uses unknown required features or contains invalid values.
+ *
+ * \param bytes Start of the file
+ * \param size Number of available bytes, at least FileHeader::headerSize for complete files
+*/
+FileHeader parseFileHeader(const char* bytes, std::size_t size);
+
+/** Get the first section of the given type, or nullptr when the header has none */
+const FileSection* findSection(const FileHeader& header, SectionType type);
+
+/** Serialize a header into FileHeader::headerSize bytes */
+std::vector<char> serializeFileHeader(const FileHeader& header);
+
+/*! Check that a file of fileSize bytes holds the data the header describes
+ *
+ * Throws std::runtime_error when the file is truncated or the data size does
+ * not match the number of rows, columns and the element type. The size of
+ * block-compressed data is checked by parseBlockIndex instead, the size of
+ * encoded indices by decodeIndices.
+ *
+ * \param header Parsed header
+ * \param fileSize Size of the file in bytes
+*/
+void validateFileSize(const FileHeader& header, std::uint64_t fileSize);
+
+/*! Parse and validate the block index section of a block-compressed file
+ *
+ * Throws std::runtime_error when the section is truncated, uses an unknown
+ * codec or filter, or its blocks do not match the header.
+ *
+ * \param header Parsed header of the file
+ * \param bytes Contents of the SectionType::BlockIndex section
+ * \param size Size of the section in bytes
+*/
+BlockIndex parseBlockIndex(const FileHeader& header, const char* bytes, std::size_t size);
+
+/** Serialize a block index into the contents of a SectionType::BlockIndex section */
+std::vector<char> serializeBlockIndex(const BlockIndex& blockIndex);
+
+/*! Parse and validate the index info section of an index file
+ *
+ * Throws std::runtime_error when the section is truncated or uses an
+ * unknown encoding.
+ *
+ * \param bytes Contents of the SectionType::IndexInfo section
+ * \param size Size of the section in bytes
+*/
+IndexInfo parseIndexInfo(const char* bytes, std::size_t size);
+
+/** Serialize index info into the contents of a SectionType::IndexInfo section */
+std::vector<char> serializeIndexInfo(const IndexInfo& indexInfo);
+
+/*! Parse and validate the quantization section of a quantized file
+ *
+ * Throws std::runtime_error when the section does not hold a finite scale
+ * and offset for every column of the header.
+ *
+ * \param header Parsed header of the file
+ * \param bytes Contents of the SectionType::Quantization section
+ * \param size Size of the section in bytes
+*/
+QuantizationTable parseQuantizationTable(const FileHeader& header, const char* bytes, std::size_t size);
+
+/** Serialize a quantization table into the contents of a SectionType::Quantization section */
+std::vector<char> serializeQuantizationTable(const QuantizationTable& quantizationTable);
+
+/*! Parse and validate the statistics section of a file
+ *
+ * Throws std::runtime_error when the section does not hold the statistics
+ * of every column of the header.
+ *
+ * \param header Parsed header of the file
+ * \param bytes Contents of the SectionType::Statistics section
+ * \param size Size of the section in bytes
+*/
+std::vector<ColumnStatistics> parseColumnStatistics(const FileHeader& header, const char* bytes, std::size_t size);
+
+/** Serialize the statistics of all columns into the contents of a SectionType::Statistics section */
+std::vector<char> serializeColumnStatistics(const std::vector<ColumnStatistics>& statistics);
+
+/*! Parse and validate the checksums section of a file
+ *
+ * Throws std::runtime_error when the section is truncated or, for
+ * uncompressed data, does not hold a checksum for every block of the data.
+ * The number of checksums of block-compressed data is checked against the
+ * block index by the reader.
+ *
+ * \param header Parsed header of the file
+ * \param bytes Contents of the SectionType::Checksums section
+ * \param size Size of the section in bytes
+*/
+BlockChecksums parseBlockChecksums(const FileHeader& header, const char* bytes, std::size_t size);
+
+/** Serialize checksums into the contents of a SectionType::Checksums section */
+std::vector<char> serializeBlockChecksums(const BlockChecksums& checksums);
@@ -0,0 +1,506 @@
+#include "FileReader.h"
+
+#include "AsyncIO.h"
+#include "MemoryMappedFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+class MappedFileReader : public FileReader
+{
+public:
+    MappedFileReader(const std::filesystem::path& filePath, AccessPattern accessPattern) :
+        _file(filePath)
+    {
+#ifndef _WIN32
+        if (_file.size() > 0)
+            ::madvise(const_cast<char*>(_file.data()), _file.size(), accessPattern == AccessPattern::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+    }
+
+    std::uint64_t size() const override {
+        return _file.size();
+    }
+
+    const char* view(std::uint64_t offset, std::size_t size) const override {
+        if (offset + size > _file.size())
+            throw std::runtime_error("Read past the end of the file.");
+
+        return _file.data() + offset;
+    }
+
+    void release(std::uint64_t offset, std::size_t size) const override {
+        _file.release(offset, size);
+    }
+
+    void read(std::uint64_t offset, std::size_t size, char* destination) const override {
+        std::memcpy(destination, view(offset, size), size);
+        release(offset, size);
+    }
+
+private:
+    MemoryMappedFile    _file;
+};
+
+class PositionalFileReader : public FileReader
+{
+public:
+    PositionalFileReader(const std::filesystem::path& filePath, AccessPattern accessPattern)
+    {
+#ifdef _WIN32
+        _fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_fileHandle == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("File was not found at location.");
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(_fileHandle, &fileSize))
+        {
+            CloseHandle(_fileHandle);
+            throw std::runtime_error("Could not determine the file size.");
+        }
+
+        _size = static_cast<std::uint64_t>(fileSize.QuadPart);
+#else
+        _fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+        if (_fileDescriptor < 0)
+            throw std::runtime_error("File was not found at location.");
+
+        struct stat fileStatus;
+        if (::fstat(_fileDescriptor, &fileStatus) != 0)
+        {
+            ::close(_fileDescriptor);
+            throw std::runtime_error("Could not determine the file size.");
+        }
+
+        _size = static_cast<std::uint64_t>(fileStatus.st_size);
+
+    #ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(_fileDescriptor, 0, 0, accessPattern == AccessPattern::Random ? POSIX_FADV_RANDOM : POSIX_FADV_SEQUENTIAL);
+    #endif
+#endif
+    }
+
+    ~PositionalFileReader() override
+    {
+#ifdef _WIN32
+        CloseHandle(_fileHandle);
+#else
+        ::close(_fileDescriptor);
+#endif
+    }
+
+    std::uint64_t size() const override {
+        return _size;
+    }
+
+    void read(std::uint64_t offset, std::size_t size, char* destination) const override {
+        if (offset + size > _size)
+            throw std::runtime_error("Read past the end of the file.");
+
+        // Large reads are split up, a single call may transfer fewer bytes than requested
+        while (size > 0)
+        {
+            const std::size_t request = std::min<std::size_t>(size, std::size_t(1) << 30);
+
+#ifdef _WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset       = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+            overlapped.OffsetHigh   = static_cast<DWORD>(offset >> 32);
+
+            DWORD numberOfBytesRead = 0;
+            if (!ReadFile(_fileHandle, destination, static_cast<DWORD>(request), &numberOfBytesRead, &overlapped) || numberOfBytesRead == 0)
+                throw std::runtime_error("Could not read from the file.");
+
+            const std::size_t received = numberOfBytesRead;
+#else
+            const auto numberOfBytesRead = ::pread(_fileDescriptor, destination, request, static_cast<off_t>(offset));
+
+            if (numberOfBytesRead < 0 && errno == EINTR)
+                continue;
+
+            if (numberOfBytesRead < 0)
+                throw std::runtime_error(std::string("Could not read from the file: ") + std::strerror(errno));
+
+            if (numberOfBytesRead == 0)
+                throw std::runtime_error("Unexpected end of file.");
+
+            const auto received = static_cast<std::size_t>(numberOfBytesRead);
+#endif
+
+            offset      += received;
+            destination += received;
+            size        -= received;
+        }
+    }
+
+private:
+    std::uint64_t   _size = 0;              /** File size in bytes */
+#ifdef _WIN32
+    HANDLE          _fileHandle;            /** Win32 file handle */
+#else
+    int             _fileDescriptor;        /** POSIX file descriptor */
+#endif
+};
+
+#ifndef _WIN32
+
+// Reads around the page cache with requests of ioRequestSize bytes, ioQueueDepth of them in flight. Offsets and sizes
+// need not be aligned: the aligned range around the requested bytes is read into aligned buffers and copied out.
+// Without the page cache nothing reads ahead, so small sequential reads, such as the rows of a subset, are served
+// from a window of ioRequestSize bytes that is read at once.
+class DirectFileReader : public FileReader
+{
+public:
+    DirectFileReader(const std::filesystem::path& filePath, AccessPattern accessPattern) :
+        _readAhead(accessPattern == AccessPattern::Sequential)
+    {
+        bool isDirect = false;
+
+        _fileDescriptor = openDirectFile(filePath, false, isDirect);
+
+        struct stat fileStatus;
+        if (::fstat(_fileDescriptor, &fileStatus) != 0)
+        {
+            ::close(_fileDescriptor);
+            throw std::runtime_error("Could not determine the file size.");
+        }
+
+        _size       = static_cast<std::uint64_t>(fileStatus.st_size);
+        _dropCache  = !isDirect;
+    }
+
+    ~DirectFileReader() override
+    {
+        _contexts.clear();
+
+        ::close(_fileDescriptor);
+    }
+
+    std::uint64_t size() const override {
+        return _size;
+    }
+
+    void read(std::uint64_t offset, std::size_t size, char* destination) const override {
+        if (offset + size > _size)
+            throw std::runtime_error("Read past the end of the file.");
+
+        if (size == 0)
+            return;
+
+        std::unique_ptr<Context> context = acquireContext(offset, size);
+
+        try
+        {
+            if (context->windowContains(offset, size))
+            {
+                std::memcpy(destination, context->window.get() + (offset - context->windowOffset), size);
+            }
+            else if (_readAhead && size <= ioRequestSize / 4)
+            {
+                // The window starts at the aligned block of offset, so it holds all requested bytes
+                context->windowSize     = 0;
+                context->windowOffset   = alignDown(offset);
+
+                if (!context->window)
+                    context->window = allocateAlignedBuffer(ioRequestSize);
+
+                const std::size_t windowSize = static_cast<std::size_t>(std::min<std::uint64_t>(ioRequestSize, _size - context->windowOffset));
+
+                readRequests(*context, context->windowOffset, windowSize, context->window.get());
+
+                context->windowSize = windowSize;
+
+                std::memcpy(destination, context->window.get() + (offset - context->windowOffset), size);
+            }
+            else
+            {
+                readRequests(*context, offset, size, destination);
+            }
+        }
+        catch (...)
+        {
+            // The buffers of requests in flight are only reused once they completed
+            while (context->queue->getNumberInFlight() > 0)
+                context->queue->wait();
+
+            releaseContext(std::move(context));
+            throw;
+        }
+
+        releaseContext(std::move(context));
+    }
+
+private:
+    // Queue and request buffers of a thread that reads, the queue completes its requests before the buffers are freed
+    struct Context
+    {
+        std::vector<AlignedBuffer>  buffers;                // One per request in flight
+        std::unique_ptr<IOQueue>    queue;
+        AlignedBuffer               window;                 // Bytes that were read ahead of small reads
+        std::uint64_t               windowOffset    = 0;    // Offset in the file of the window
+        std::size_t                 windowSize      = 0;    // Number of bytes in the window
+
+        bool windowContains(std::uint64_t offset, std::size_t size) const {
+            return windowSize > 0 && offset >= windowOffset && offset + size <= windowOffset + windowSize;
+        }
+    };
+
+    // Part of the aligned range that one request reads
+    struct Piece
+    {
+        std::uint64_t   offset  = 0;    // Offset in the file
+        std::size_t     size    = 0;
+        std::size_t     done    = 0;    // Number of bytes read so far
+    };
+
+    void readRequests(Context& context, std::uint64_t offset, std::size_t size, char* destination) const {
+        const std::uint64_t end         = offset + size;
+        const std::uint64_t alignedEnd  = alignUp(end);
+
+        std::uint64_t nextOffset = alignDown(offset);
+
+        std::vector<Piece> pieces(context.buffers.size());
+
+        const auto submit = [this, &context, &pieces](std::size_t slot) -> void {
+            const Piece& piece = pieces[slot];
+
+            IORequest request;
+            request.fileDescriptor  = _fileDescriptor;
+            request.buffer          = context.buffers[slot].get() + piece.done;
+            request.size            = piece.size - piece.done;
+            request.offset          = piece.offset + piece.done;
+            request.tag             = slot;
+
+            context.queue->submit(request);
+        };
+
+        // Every slot starts with a piece, and takes the next piece when its piece is complete
+        for (std::size_t slot = 0; slot < pieces.size() && nextOffset < alignedEnd; slot++)
+        {
+            pieces[slot] = { nextOffset, static_cast<std::size_t>(std::min<std::uint64_t>(ioRequestSize, alignedEnd - nextOffset)), 0 };
+            nextOffset += pieces[slot].size;
+
+            submit(slot);
+        }
+
+        while (context.queue->getNumberInFlight() > 0)
+        {
+            const IOCompletion completion   = context.queue->wait();
+            const std::size_t slot          = static_cast<std::size_t>(completion.tag);
+
+            Piece& piece = pieces[slot];
+
+            if (completion.result == -EINTR || completion.result == -EAGAIN)
+            {
+                submit(slot);
+                continue;
+            }
+
+            if (completion.result < 0)
+                throw std::runtime_error(std::string("Could not read from the file: ") + std::strerror(static_cast<int>(-completion.result)));
+
+            piece.done += static_cast<std::size_t>(completion.result);
+
+            // Reads stop short at the end of the file, which may end inside the last aligned block
+            const std::uint64_t pieceEnd = std::min<std::uint64_t>(piece.offset + piece.size, end);
+
+            if (piece.offset + piece.done < pieceEnd)
+            {
+                if (completion.result == 0)
+                    throw std::runtime_error("Unexpected end of file.");
+
+                submit(slot);
+                continue;
+            }
+
+            const std::uint64_t first = std::max(piece.offset, offset);
+
+            std::memcpy(destination + (first - offset), context.buffers[slot].get() + (first - piece.offset), static_cast<std::size_t>(pieceEnd - first));
+
+            // Without direct I/O the read bytes are cached, the cache is told that they are not needed again
+#ifdef POSIX_FADV_DONTNEED
+            if (_dropCache)
+                ::posix_fadvise(_fileDescriptor, static_cast<off_t>(piece.offset), static_cast<off_t>(piece.size), POSIX_FADV_DONTNEED);
+#endif
+
+            if (nextOffset < alignedEnd)
+            {
+                piece = { nextOffset, static_cast<std::size_t>(std::min<std::uint64_t>(ioRequestSize, alignedEnd - nextOffset)), 0 };
+                nextOffset += piece.size;
+
+                submit(slot);
+            }
+        }
+    }
+
+    // Takes an idle context, preferably one whose window holds the requested bytes, or makes one; every thread that
+    // reads at the same time has its own
+    std::unique_ptr<Context> acquireContext(std::uint64_t offset, std::size_t size) const {
+        {
+            std::lock_guard<std::mutex> lock(_contextMutex);
+
+            if (!_contexts.empty())
+            {
+                auto found = std::find_if(_contexts.begin(), _contexts.end(), [offset, size](const auto& context) { return context->windowContains(offset, size); });
+
+                if (found == _contexts.end())
+                    found = std::prev(_contexts.end());
+
+                auto context = std::move(*found);
+                _contexts.erase(found);
+
+                return context;
+            }
+        }
+
+        auto context = std::make_unique<Context>();
+
+        for (std::size_t slot = 0; slot < ioQueueDepth; slot++)
+            context->buffers.push_back(allocateAlignedBuffer(ioRequestSize));
+
+        context->queue = createIOQueue(ioQueueDepth);
+
+        return context;
+    }
+
+    void releaseContext(std::unique_ptr<Context> context) const {
+        std::lock_guard<std::mutex> lock(_contextMutex);
+
+        _contexts.push_back(std::move(context));
+    }
+
+    std::uint64_t                                       _size           = 0;        /** File size in bytes */
+    int                                                 _fileDescriptor = -1;       /** POSIX file descriptor, of direct I/O when the file system supports it */
+    bool                                                _dropCache      = false;    /** Whether read bytes are dropped from the page cache, when the file system has no direct I/O */
+    bool                                                _readAhead      = false;    /** Whether small reads fill a window of the context, for sequential access */
+    mutable std::mutex                                  _contextMutex;
+    mutable std::vector<std::unique_ptr<Context>>       _contexts;                  /** Idle contexts */
+};
+
+#endif
+
+// Whether name matches pattern, where * matches any number of characters and ? one character
+template <typename Char>
+bool matchesWildcards(const std::basic_string<Char>& name, const std::basic_string<Char>& pattern)
+{
+    std::size_t nameIndex       = 0;
+    std::size_t patternIndex    = 0;
+    std::size_t starIndex       = std::basic_string<Char>::npos;    // Position of the last * in pattern
+    std::size_t starNameIndex   = 0;                                // Position in name that the last * matched up to
+
+    while (nameIndex < name.size())
+    {
+        if (patternIndex < pattern.size() && (pattern[patternIndex] == Char('?') || pattern[patternIndex] == name[nameIndex]))
+        {
+            nameIndex++;
+            patternIndex++;
+        }
+        else if (patternIndex < pattern.size() && pattern[patternIndex] == Char('*'))
+        {
+            starIndex       = patternIndex++;
+            starNameIndex   = nameIndex;
+        }
+        else if (starIndex != std::basic_string<Char>::npos)
+        {
+            // Let the last * match one more character
+            patternIndex    = starIndex + 1;
+            nameIndex       = ++starNameIndex;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (patternIndex < pattern.size() && pattern[patternIndex] == Char('*'))
+        patternIndex++;
+
+    return patternIndex == pattern.size();
+}
+
+}
+
+std::unique_ptr<FileReader> openFileReader(const std::filesystem::path& filePath, ReadMethod readMethod, AccessPattern accessPattern)
+{
+    switch (readMethod)
+    {
+        case ReadMethod::MemoryMap:
+            return std::make_unique<MappedFileReader>(filePath, accessPattern);
+
+        case ReadMethod::DirectRead:
+#ifndef _WIN32
+            return std::make_unique<DirectFileReader>(filePath, accessPattern);
+#else
+            break;
+#endif
+
+        case ReadMethod::PositionalRead:
+            break;
+    }
+
+    return std::make_unique<PositionalFileReader>(filePath, accessPattern);
+}
+
+const char* getReadMethodName(ReadMethod readMethod)
+{
+    switch (readMethod)
+    {
+        case ReadMethod::MemoryMap:         return "mmap";
+        case ReadMethod::PositionalRead:    return "pread";
+        case ReadMethod::DirectRead:        return "direct";
+    }
+
+    return "unknown";
+}
+
+std::vector<std::filesystem::path> expandFilePattern(const std::filesystem::path& pattern)
+{
+    using String = std::filesystem::path::string_type;
+
+    const String fileNamePattern    = pattern.filename().native();
+    const String wildcards          = { '*', '?' };
+
+    if (fileNamePattern.find_first_of(wildcards) == String::npos)
+        return std::filesystem::is_regular_file(pattern) ? std::vector<std::filesystem::path>{ pattern } : std::vector<std::filesystem::path>{};
+
+    const auto directory = pattern.has_parent_path() ? pattern.parent_path() : std::filesystem::path(".");
+
+    std::vector<std::filesystem::path> filePaths;
+
+    try
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+            if (entry.is_regular_file() && matchesWildcards(entry.path().filename().native(), fileNamePattern))
+                filePaths.push_back(entry.path());
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        throw std::runtime_error("Cannot list " + directory.string() + ": " + e.what());
+    }
+
+    std::sort(filePaths.begin(), filePaths.end());
+
+    return filePaths;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/** How the bytes of a file are read */
+enum class ReadMethod
+{
+    MemoryMap,          /** Map the whole file and read from the mapping */
+    PositionalRead,     /** Read chunks with positional reads (pread/ReadFile) */
+    DirectRead          /** Read around the page cache into aligned buffers, with several requests in flight (see AsyncIO.h) */
+};
+
+/** How the bytes of a file are accessed, which the reader passes on to the operating system as a hint */
+enum class AccessPattern
+{
+    Sequential,         /** Every thread streams through a range, the operating system reads ahead */
+    Random              /** Scattered points, e.g. of a random sample, reading ahead wastes I/O */
+};
+
+/**
+ * Random access, read-only file interface
+ *
+ * All member functions are thread-safe, so worker threads can read disjoint
+ * parts of one file concurrently.
+ */
+class FileReader
+{
+public:
+    virtual ~FileReader() = default;
+
+    /** Get the size of the file in bytes */
+    virtual std::uint64_t size() const = 0;
+
+    /*! Get a pointer to size bytes at offset without copying them
+     *
+     * \param offset Offset in bytes from the start of the file
+     * \param size Number of bytes
+     * \return Pointer to the bytes, or nullptr when the reader cannot expose them in place
+    */
+    virtual const char* view([[maybe_unused]] std::uint64_t offset, [[maybe_unused]] std::size_t size) const {
+        return nullptr;
+    }
+
+    /*! Tell the reader that the bytes of a view are no longer needed
+     *
+     * Readers that keep viewed bytes resident (memory maps) release them, so
+     * that memory use stays bounded while streaming through a large file.
+     *
+     * \param offset Offset in bytes from the start of the file
+     * \param size Number of bytes
+    */
+    virtual void release([[maybe_unused]] std::uint64_t offset, [[maybe_unused]] std::size_t size) const {
+    }
+
+    /*! Copy size bytes at offset into destination
+     *
+     * Throws std::runtime_error when the bytes cannot be read.
+     *
+     * \param offset Offset in bytes from the start of the file
+     * \param size Number of bytes
+     * \param destination Buffer of at least size bytes
+    */
+    virtual void read(std::uint64_t offset, std::size_t size, char* destination) const = 0;
+};
+
+/*! Open a file for reading with the given method
+ *
+ * Throws std::runtime_error when the file cannot be opened. Direct reads
+ * fall back to positional reads on Windows.
+ *
+ * \param filePath Path of the file to open
+ * \param readMethod How the file is read
+ * \param accessPattern How the file will be accessed, a hint for the read ahead of all methods
+*/
+std::unique_ptr<FileReader> openFileReader(const std::filesystem::path& filePath, ReadMethod readMethod, AccessPattern accessPattern = AccessPattern::Sequential);
+
+/** Get a short name of the given read method, e.g. "pread" */
+const char* getReadMethodName(ReadMethod readMethod);
+
+/*! Get the files that match a pattern, sorted by name
+ *
+ * The file name of the pattern may contain the wildcards * (any number of
+ * characters) and ? (one character), e.g. "/data/run/part-*.bin"; its
+ * directory may not. A pattern without wildcards yields itself when the file
+ * exists. Throws std::runtime_error when the directory cannot be listed.
+ *
+ * \param pattern Path whose file name may contain wildcards
+ * \return Regular files that match, sorted by name
+*/
+std::vector<std::filesystem::path> expandFilePattern(const std::filesystem::path& pattern);
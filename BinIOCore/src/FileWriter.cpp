@@ -0,0 +1,371 @@
+#include "FileWriter.h"
+
+#include "AsyncIO.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+class StreamFileWriter : public FileWriter
+{
+public:
+    explicit StreamFileWriter(const std::filesystem::path& filePath)
+    {
+        if (!_buffer.open(filePath, std::ios::out | std::ios::binary | std::ios::trunc))
+            throw std::runtime_error("Could not create the file.");
+
+        rdbuf(&_buffer);
+        exceptions(std::ios::badbit);
+    }
+
+    void close() override {
+        flush();
+
+        if (_buffer.is_open() && _buffer.close() == nullptr)
+            throw std::runtime_error("Could not close the file.");
+    }
+
+private:
+    std::filebuf    _buffer;
+};
+
+#ifndef _WIN32
+
+/**
+ * Stream buffer that writes around the page cache
+ *
+ * The stream fills aligned buffers of ioRequestSize bytes, which are written
+ * asynchronously while the stream fills the next ones, up to ioQueueDepth
+ * writes in flight. Direct writes need aligned offsets and sizes: bytes that
+ * do not fill an aligned block, such as the end of the data or the sections
+ * behind it, are written through a second, buffered file descriptor. Seeks
+ * wait for all writes in flight, so that the writes of a range happen in
+ * the order of the stream.
+ */
+class DirectFileBuffer : public std::streambuf
+{
+public:
+    explicit DirectFileBuffer(const std::filesystem::path& filePath) :
+        _slots(ioQueueDepth)
+    {
+        bool isDirect = false;
+
+        _directFileDescriptor   = openDirectFile(filePath, true, isDirect);
+        _bufferedFileDescriptor = isDirect ? ::open(filePath.c_str(), O_WRONLY) : _directFileDescriptor;
+
+        if (_bufferedFileDescriptor < 0)
+        {
+            ::close(_directFileDescriptor);
+            throw std::runtime_error(std::string("Could not open the file: ") + std::strerror(errno));
+        }
+
+        try
+        {
+            for (std::size_t slot = 0; slot < ioQueueDepth; slot++)
+                _buffers.push_back(allocateAlignedBuffer(ioRequestSize));
+
+            _queue = createIOQueue(ioQueueDepth);
+        }
+        catch (...)
+        {
+            closeFiles();
+            throw;
+        }
+    }
+
+    ~DirectFileBuffer() override
+    {
+        // Errors can only be reported by close()
+        try
+        {
+            close();
+        }
+        catch (const std::exception&)
+        {
+            _queue.reset();
+            closeFiles();
+        }
+    }
+
+    // Completes the writes and closes the file
+    void close() {
+        if (_directFileDescriptor < 0)
+            return;
+
+        try
+        {
+            flushBuffer();
+            waitForAll();
+        }
+        catch (...)
+        {
+            _queue.reset();
+            closeFiles();
+            throw;
+        }
+
+        if (!closeFiles())
+            throw std::runtime_error(std::string("Could not close the file: ") + std::strerror(errno));
+    }
+
+protected:
+    int_type overflow(int_type character) override {
+        flushBuffer();
+        startBuffer();
+
+        if (!traits_type::eq_int_type(character, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(character);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(character);
+    }
+
+    std::streamsize xsputn(const char_type* bytes, std::streamsize count) override {
+        std::streamsize written = 0;
+
+        while (written < count)
+        {
+            if (pptr() == epptr())
+            {
+                flushBuffer();
+                startBuffer();
+            }
+
+            const auto size = std::min<std::streamsize>(count - written, epptr() - pptr());
+
+            std::memcpy(pptr(), bytes + written, static_cast<std::size_t>(size));
+            pbump(static_cast<int>(size));
+
+            written += size;
+        }
+
+        return written;
+    }
+
+    int sync() override {
+        flushBuffer();
+        waitForAll();
+
+        return 0;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override {
+        const std::uint64_t current = _position + static_cast<std::uint64_t>(pptr() - pbase());
+
+        // Telling the position does not interrupt the writes
+        if (offset == 0 && direction == std::ios_base::cur)
+            return pos_type(static_cast<off_type>(current));
+
+        flushBuffer();
+        waitForAll();
+
+        const std::uint64_t origin = direction == std::ios_base::beg ? 0 : (direction == std::ios_base::cur ? current : _end);
+
+        _position = origin + offset;
+
+        return pos_type(static_cast<off_type>(_position));
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+
+private:
+    // Request of a buffer that is written
+    struct Slot
+    {
+        std::uint64_t   offset  = 0;        // Offset in the file
+        std::size_t     size    = 0;
+        std::size_t     done    = 0;        // Number of bytes written so far
+        bool            busy    = false;
+    };
+
+    // Puts an idle buffer behind the stream, which ends at the next aligned offset, so that its bytes can be written directly
+    void startBuffer() {
+        std::size_t slot = 0;
+
+        while (slot < _slots.size() && _slots[slot].busy)
+            slot++;
+
+        if (slot == _slots.size())
+            slot = waitForOne();
+
+        _currentSlot = slot;
+
+        const std::size_t capacity = _position % ioAlignment == 0 ? ioRequestSize : static_cast<std::size_t>(alignUp(_position) - _position);
+
+        char* const buffer = _buffers[slot].get();
+
+        setp(buffer, buffer + capacity);
+    }
+
+    // Writes the bytes of the current buffer: the aligned blocks asynchronously, the rest right away
+    void flushBuffer() {
+        if (pbase() == nullptr)
+            return;
+
+        char* const buffer          = pbase();
+        const std::size_t size      = static_cast<std::size_t>(pptr() - pbase());
+        const std::size_t direct    = _position % ioAlignment == 0 ? static_cast<std::size_t>(alignDown(size)) : 0;
+
+        setp(nullptr, nullptr);
+
+        if (direct > 0)
+        {
+            Slot& slot = _slots[_currentSlot];
+
+            slot = { _position, direct, 0, true };
+
+            submit(_currentSlot);
+        }
+
+        std::size_t done = direct;
+
+        while (done < size)
+        {
+            const auto result = ::pwrite(_bufferedFileDescriptor, buffer + done, size - done, static_cast<off_t>(_position + done));
+
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            if (result <= 0)
+                throw std::runtime_error(std::string("Could not write to the file: ") + std::strerror(errno));
+
+            done += static_cast<std::size_t>(result);
+        }
+
+        _position  += size;
+        _end        = std::max(_end, _position);
+    }
+
+    void submit(std::size_t slotIndex) {
+        const Slot& slot = _slots[slotIndex];
+
+        IORequest request;
+        request.fileDescriptor  = _directFileDescriptor;
+        request.buffer          = _buffers[slotIndex].get() + slot.done;
+        request.size            = slot.size - slot.done;
+        request.offset          = slot.offset + slot.done;
+        request.isWrite         = true;
+        request.tag             = slotIndex;
+
+        _queue->submit(request);
+    }
+
+    // Waits until a buffer was written completely and returns its slot
+    std::size_t waitForOne() {
+        while (true)
+        {
+            const IOCompletion completion   = _queue->wait();
+            const std::size_t slotIndex     = static_cast<std::size_t>(completion.tag);
+
+            Slot& slot = _slots[slotIndex];
+
+            if (completion.result < 0 && completion.result != -EINTR && completion.result != -EAGAIN)
+                throw std::runtime_error(std::string("Could not write to the file: ") + std::strerror(static_cast<int>(-completion.result)));
+
+            if (completion.result == 0)
+                throw std::runtime_error("Could not write to the file.");
+
+            if (completion.result > 0)
+                slot.done += static_cast<std::size_t>(completion.result);
+
+            if (slot.done < slot.size)
+            {
+                submit(slotIndex);
+                continue;
+            }
+
+            slot.busy = false;
+
+            return slotIndex;
+        }
+    }
+
+    void waitForAll() {
+        while (_queue && _queue->getNumberInFlight() > 0)
+            waitForOne();
+    }
+
+    // Closes the file descriptors and returns whether that succeeded
+    bool closeFiles() {
+        bool closed = true;
+
+        if (_bufferedFileDescriptor >= 0 && _bufferedFileDescriptor != _directFileDescriptor)
+            closed = ::close(_bufferedFileDescriptor) == 0;
+
+        if (_directFileDescriptor >= 0)
+            closed = ::close(_directFileDescriptor) == 0 && closed;
+
+        _directFileDescriptor   = -1;
+        _bufferedFileDescriptor = -1;
+
+        return closed;
+    }
+
+    int                             _directFileDescriptor   = -1;   // Of direct I/O when the file system supports it
+    int                             _bufferedFileDescriptor = -1;   // Of buffered I/O, for the bytes that do not fill aligned blocks
+    std::vector<AlignedBuffer>      _buffers;                       // One per slot
+    std::vector<Slot>               _slots;
+    std::unique_ptr<IOQueue>        _queue;                         // Completes its writes before the buffers are freed
+    std::size_t                     _currentSlot            = 0;    // Slot of the buffer behind the stream
+    std::uint64_t                   _position               = 0;    // Offset in the file of the start of the buffer behind the stream
+    std::uint64_t                   _end                    = 0;    // End of the written bytes
+};
+
+class DirectFileWriter : public FileWriter
+{
+public:
+    explicit DirectFileWriter(const std::filesystem::path& filePath) :
+        _buffer(filePath)
+    {
+        rdbuf(&_buffer);
+        exceptions(std::ios::badbit);
+    }
+
+    void close() override {
+        _buffer.close();
+    }
+
+private:
+    DirectFileBuffer    _buffer;
+};
+
+#endif
+
+}
+
+std::unique_ptr<FileWriter> openFileWriter(const std::filesystem::path& filePath, WriteMethod writeMethod)
+{
+#ifndef _WIN32
+    if (writeMethod == WriteMethod::DirectWrite)
+        return std::make_unique<DirectFileWriter>(filePath);
+#endif
+
+    return std::make_unique<StreamFileWriter>(filePath);
+}
+
+const char* getWriteMethodName(WriteMethod writeMethod)
+{
+    switch (writeMethod)
+    {
+        case WriteMethod::Stream:       return "stream";
+        case WriteMethod::DirectWrite:  return "direct";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <ostream>
+
+/** How the bytes of a file are written */
+enum class WriteMethod
+{
+    Stream,             /** Write through a standard file stream and the page cache */
+    DirectWrite         /** Write around the page cache from aligned buffers, with several requests in flight (see AsyncIO.h) */
+};
+
+/**
+ * Output stream of a file, written with a WriteMethod
+ *
+ * Writes and seeks work like those of a std::ofstream, but errors throw:
+ * badbit is set in the exceptions of the stream. Direct writes are
+ * asynchronous, they are complete once the stream is flushed or closed, so
+ * close() has to succeed before the file is complete.
+ */
+class FileWriter : public std::ostream
+{
+public:
+    FileWriter() : std::ostream(nullptr) { }
+
+    /** Complete the writes and close the file, throws std::runtime_error when that fails */
+    virtual void close() = 0;
+};
+
+/*! Create or truncate a file and open it for writing with the given method
+ *
+ * Throws std::runtime_error when the file cannot be created. Direct writes
+ * fall back to a standard file stream on Windows.
+ *
+ * \param filePath Path of the file to write
+ * \param writeMethod How the file is written
+*/
+std::unique_ptr<FileWriter> openFileWriter(const std::filesystem::path& filePath, WriteMethod writeMethod);
+
+/** Get a short name of the given write method, e.g. "stream" */
+const char* getWriteMethodName(WriteMethod writeMethod);
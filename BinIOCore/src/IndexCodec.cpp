@@ -0,0 +1,272 @@
+#include "IndexCodec.h"
+
+#include "ConversionKernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t maxUInt32 = std::numeric_limits<std::uint32_t>::max();
+
+// Shape of a sequence of indices, gathered in one pass
+struct IndexStatistics
+{
+    std::uint64_t   maxIndex        = 0;
+    std::uint64_t   numberOfRuns    = 0;        // Runs of consecutive indices
+    bool            isIncreasing    = true;     // Strictly increasing, so that a bitmap keeps the order
+};
+
+template <typename Index>
+IndexStatistics getIndexStatistics(const Index* indices, std::size_t count)
+{
+    IndexStatistics statistics;
+
+    for (std::size_t position = 0; position < count; position++)
+    {
+        const std::uint64_t index = indices[position];
+
+        statistics.maxIndex = std::max(statistics.maxIndex, index);
+
+        if (position == 0 || index != static_cast<std::uint64_t>(indices[position - 1]) + 1)
+            statistics.numberOfRuns++;
+
+        if (position > 0 && index <= static_cast<std::uint64_t>(indices[position - 1]))
+            statistics.isIncreasing = false;
+    }
+
+    return statistics;
+}
+
+// Number of points a bitmap covers: all points of the data set, and at least all points up to the largest index
+std::uint64_t getNumberOfBitmapPoints(const IndexStatistics& statistics, std::size_t count, std::uint64_t numPoints)
+{
+    return count == 0 ? numPoints : std::max(numPoints, statistics.maxIndex + 1);
+}
+
+IndexEncoding chooseEncoding(const IndexStatistics& statistics, std::size_t count, std::uint64_t numPoints)
+{
+    const std::uint64_t wordSize    = statistics.maxIndex > maxUInt32 ? 8 : 4;
+    const std::uint64_t plainBytes  = count * wordSize;
+    const std::uint64_t runsBytes   = statistics.numberOfRuns * 2 * wordSize;
+    const std::uint64_t bitmapBytes = (getNumberOfBitmapPoints(statistics, count, numPoints) + 7) / 8;
+
+    if (statistics.isIncreasing && bitmapBytes < std::min(plainBytes, runsBytes))
+        return IndexEncoding::Bitmap;
+
+    if (runsBytes < plainBytes)
+        return IndexEncoding::Runs;
+
+    return IndexEncoding::Plain;
+}
+
+template <typename Word>
+void writeWord(char* bytes, std::size_t wordIndex, std::uint64_t value)
+{
+    const Word word = static_cast<Word>(value);
+    std::memcpy(bytes + wordIndex * sizeof(Word), &word, sizeof(Word));
+}
+
+// Stores plain indices or runs as words of type Word
+template <typename Word, typename Index>
+void encodeWords(const Index* indices, std::size_t count, const IndexStatistics& statistics, EncodedIndices& encoded)
+{
+    encoded.elementType = getElementType<Word>();
+
+    if (encoded.info.encoding == IndexEncoding::Plain)
+    {
+        encoded.bytes.resize(count * sizeof(Word));
+
+        for (std::size_t position = 0; position < count; position++)
+            writeWord<Word>(encoded.bytes.data(), position, indices[position]);
+
+        return;
+    }
+
+    encoded.bytes.resize(static_cast<std::size_t>(statistics.numberOfRuns) * 2 * sizeof(Word));
+
+    std::size_t wordIndex = 0;
+
+    for (std::size_t first = 0; first < count;)
+    {
+        std::size_t end = first + 1;
+
+        while (end < count && static_cast<std::uint64_t>(indices[end]) == static_cast<std::uint64_t>(indices[end - 1]) + 1)
+            end++;
+
+        writeWord<Word>(encoded.bytes.data(), wordIndex++, indices[first]);
+        writeWord<Word>(encoded.bytes.data(), wordIndex++, end - first);
+
+        first = end;
+    }
+}
+
+template <typename Word>
+std::uint64_t readWord(const char* bytes, std::size_t wordIndex, bool isByteSwapped)
+{
+    Word word;
+    std::memcpy(&word, bytes + wordIndex * sizeof(Word), sizeof(Word));
+
+    return isByteSwapped ? swapBytes(word) : word;
+}
+
+// Checks every decoded index against the size of the data set and the 32 bits of the destination
+class IndexSink
+{
+public:
+    IndexSink(std::uint32_t* destination, std::uint64_t numIndices, std::uint64_t numPoints) :
+        _destination(destination),
+        _numIndices(numIndices),
+        _limit(numPoints > 0 ? std::min(numPoints, maxUInt32 + 1) : maxUInt32 + 1),
+        _numPoints(numPoints),
+        _position(0)
+    {
+    }
+
+    // Adds the indices first to first + length - 1
+    void addRun(std::uint64_t first, std::uint64_t length)
+    {
+        if (length == 0)
+            return;
+
+        if (length > _numIndices - _position)
+            throw std::runtime_error("The index file holds more indices than its header specifies.");
+
+        if (first >= _limit || length > _limit - first)
+            throw std::runtime_error(getInvalidIndexMessage(first >= _limit ? first : _limit));
+
+        for (std::uint64_t index = first; index < first + length; index++)
+            _destination[_position++] = static_cast<std::uint32_t>(index);
+    }
+
+    // Checks that all indices of the header were decoded
+    void finish() const
+    {
+        if (_position != _numIndices)
+            throw std::runtime_error("The index file holds " + std::to_string(_position) + " indices instead of " + std::to_string(_numIndices) + ".");
+    }
+
+private:
+    std::string getInvalidIndexMessage(std::uint64_t index) const
+    {
+        if (_numPoints > 0 && index >= _numPoints)
+            return "Invalid index " + std::to_string(index) + " in a data set of " + std::to_string(_numPoints) + " points.";
+
+        return "The index " + std::to_string(index) + " does not fit 32 bits.";
+    }
+
+    std::uint32_t*  _destination;
+    std::uint64_t   _numIndices;
+    std::uint64_t   _limit;         // First index that cannot be stored
+    std::uint64_t   _numPoints;
+    std::uint64_t   _position;      // Number of indices decoded so far
+};
+
+template <typename Word>
+void decodeWords(const FileHeader& header, IndexEncoding encoding, const char* bytes, std::size_t size, IndexSink& sink)
+{
+    const bool isByteSwapped = header.byteOrder != getNativeByteOrder();
+
+    if (encoding == IndexEncoding::Plain)
+    {
+        if (size / sizeof(Word) != header.numRows || size % sizeof(Word) != 0)
+            throw std::runtime_error("The data size of the index file does not match " + std::to_string(header.numRows) + " " + getElementTypeName(header.elementType) + " indices.");
+
+        for (std::size_t wordIndex = 0; wordIndex < size / sizeof(Word); wordIndex++)
+            sink.addRun(readWord<Word>(bytes, wordIndex, isByteSwapped), 1);
+
+        return;
+    }
+
+    if (size % (2 * sizeof(Word)) != 0)
+        throw std::runtime_error("The runs of the index file are truncated.");
+
+    for (std::size_t wordIndex = 0; wordIndex < size / sizeof(Word); wordIndex += 2)
+        sink.addRun(readWord<Word>(bytes, wordIndex, isByteSwapped), readWord<Word>(bytes, wordIndex + 1, isByteSwapped));
+}
+
+}
+
+template <typename Index>
+IndexEncoding chooseIndexEncoding(const Index* indices, std::size_t count, std::uint64_t numPoints)
+{
+    return chooseEncoding(getIndexStatistics(indices, count), count, numPoints);
+}
+
+template <typename Index>
+EncodedIndices encodeIndices(const Index* indices, std::size_t count, std::uint64_t numPoints, std::optional<IndexEncoding> encoding)
+{
+    const IndexStatistics statistics = getIndexStatistics(indices, count);
+
+    EncodedIndices encoded;
+
+    encoded.info.encoding   = encoding.value_or(chooseEncoding(statistics, count, numPoints));
+    encoded.info.numPoints  = numPoints;
+    encoded.numIndices      = count;
+
+    if (encoded.info.encoding == IndexEncoding::Bitmap)
+    {
+        if (!statistics.isIncreasing)
+            throw std::invalid_argument("A bitmap only holds strictly increasing indices.");
+
+        encoded.info.numPoints  = getNumberOfBitmapPoints(statistics, count, numPoints);
+        encoded.elementType     = ElementType::UInt8;
+
+        encoded.bytes.assign(static_cast<std::size_t>((encoded.info.numPoints + 7) / 8), 0);
+
+        for (std::size_t position = 0; position < count; position++)
+            encoded.bytes[static_cast<std::size_t>(indices[position] / 8)] |= static_cast<char>(1u << (indices[position] % 8));
+
+        return encoded;
+    }
+
+    if (statistics.maxIndex > maxUInt32)
+        encodeWords<std::uint64_t>(indices, count, statistics, encoded);
+    else
+        encodeWords<std::uint32_t>(indices, count, statistics, encoded);
+
+    return encoded;
+}
+
+template IndexEncoding chooseIndexEncoding<std::uint32_t>(const std::uint32_t*, std::size_t, std::uint64_t);
+template IndexEncoding chooseIndexEncoding<std::uint64_t>(const std::uint64_t*, std::size_t, std::uint64_t);
+template EncodedIndices encodeIndices<std::uint32_t>(const std::uint32_t*, std::size_t, std::uint64_t, std::optional<IndexEncoding>);
+template EncodedIndices encodeIndices<std::uint64_t>(const std::uint64_t*, std::size_t, std::uint64_t, std::optional<IndexEncoding>);
+
+void decodeIndices(const FileHeader& header, const IndexInfo& indexInfo, const char* bytes, std::size_t size, std::uint32_t* destination)
+{
+    IndexSink sink(destination, header.numRows, indexInfo.numPoints);
+
+    if (indexInfo.encoding == IndexEncoding::Bitmap)
+    {
+        if (header.elementType != ElementType::UInt8)
+            throw std::runtime_error("Bitmap indices must be stored as uint8.");
+
+        if (size != (indexInfo.numPoints + 7) / 8)
+            throw std::runtime_error("The size of the bitmap does not match " + std::to_string(indexInfo.numPoints) + " points.");
+
+        for (std::size_t byteIndex = 0; byteIndex < size; byteIndex++)
+        {
+            for (unsigned int bits = static_cast<std::uint8_t>(bytes[byteIndex]); bits != 0; bits &= bits - 1)
+                sink.addRun(8 * static_cast<std::uint64_t>(byteIndex) + static_cast<unsigned int>(std::countr_zero(bits)), 1);
+        }
+    }
+    else if (header.elementType == ElementType::UInt32)
+    {
+        decodeWords<std::uint32_t>(header, indexInfo.encoding, bytes, size, sink);
+    }
+    else if (header.elementType == ElementType::UInt64)
+    {
+        decodeWords<std::uint64_t>(header, indexInfo.encoding, bytes, size, sink);
+    }
+    else
+    {
+        throw std::runtime_error("Indices must be stored as uint32 or uint64.");
+    }
+
+    sink.finish();
+}
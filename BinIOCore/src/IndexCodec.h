@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FileFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * Exact and compact encodings of point indices
+ *
+ * Indices, e.g. of a selection, are written to index files as exact uint32
+ * words, or uint64 words when an index does not fit 32 bits. Dense
+ * selections take far fewer bytes as runs of consecutive indices or as a
+ * bitmap over all points; chooseIndexEncoding picks the smallest of the
+ * encodings that keep the order of the indices. See FileFormat.h for the
+ * layout of index files.
+ */
+
+/** Indices encoded as the data of an index file */
+struct EncodedIndices
+{
+    IndexInfo           info;
+    ElementType         elementType = ElementType::UInt32;  /** Type of the stored words: uint32 or uint64, uint8 for bitmaps */
+    std::uint64_t       numIndices  = 0;
+    std::vector<char>   bytes;                              /** Encoded indices, words in the native byte order */
+};
+
+/*! Get the encoding that stores the indices in the fewest bytes
+ *
+ * Runs keep any order of the indices, bitmaps only apply to strictly
+ * increasing indices. Plain indices win ties, then runs.
+ *
+ * \param indices Indices in the order they are stored
+ * \param count Number of indices
+ * \param numPoints Number of points of the data set the indices refer to, 0 if unknown
+*/
+template <typename Index>
+IndexEncoding chooseIndexEncoding(const Index* indices, std::size_t count, std::uint64_t numPoints);
+
+/*! Encode indices for an index file
+ *
+ * Words are uint32 unless an index does not fit 32 bits. A bitmap covers
+ * numPoints points, or all points up to the largest index when numPoints is
+ * not larger. Throws std::invalid_argument when a bitmap is requested for
+ * indices that are not strictly increasing.
+ *
+ * \param indices Indices in the order they are stored
+ * \param count Number of indices
+ * \param numPoints Number of points of the data set the indices refer to, 0 if unknown
+ * \param encoding Encoding to use, by default the one of chooseIndexEncoding
+*/
+template <typename Index>
+EncodedIndices encodeIndices(const Index* indices, std::size_t count, std::uint64_t numPoints, std::optional<IndexEncoding> encoding = std::nullopt);
+
+/*! Decode the indices of an index file
+ *
+ * Throws std::runtime_error when the data does not hold header.numRows
+ * indices in the element type and encoding of the file, an index is not
+ * below indexInfo.numPoints (when known) or does not fit 32 bits.
+ *
+ * \param header Header of the index file
+ * \param indexInfo Contents of its SectionType::IndexInfo section
+ * \param bytes Encoded indices, the data of the file
+ * \param size Size of the data in bytes
+ * \param destination Receives header.numRows indices in their stored order
+*/
+void decodeIndices(const FileHeader& header, const IndexInfo& indexInfo, const char* bytes, std::size_t size, std::uint32_t* destination);
@@ -0,0 +1,167 @@
+#include "Instrumentation.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+std::string toJson(const std::string& text)
+{
+    std::string json = "\"";
+
+    for (const char c : text)
+    {
+        switch (c)
+        {
+            case '"':   json += "\\\""; break;
+            case '\\':  json += "\\\\"; break;
+            case '\n':  json += "\\n";  break;
+            case '\r':  json += "\\r";  break;
+            case '\t':  json += "\\t";  break;
+
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                    json += escaped;
+                }
+                else
+                {
+                    json += c;
+                }
+        }
+    }
+
+    return json + "\"";
+}
+
+// Independent of the locale, which may use a decimal comma
+std::string toJson(double value, int precision)
+{
+    char buffer[64];
+
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+
+    return result.ec == std::errc() ? std::string(buffer, result.ptr) : std::string("0");
+}
+
+}
+
+OperationRecord::OperationRecord(std::string operation) :
+    _operation(std::move(operation)),
+    _time(std::chrono::system_clock::now()),
+    _seconds(0)
+{
+}
+
+void OperationRecord::setField(const std::string& key, const std::string& value)
+{
+    setRawField(key, toJson(value));
+}
+
+void OperationRecord::setField(const std::string& key, std::uint64_t value)
+{
+    setRawField(key, std::to_string(value));
+}
+
+void OperationRecord::setRawField(const std::string& key, std::string json)
+{
+    for (auto& field : _fields)
+    {
+        if (field.first == key)
+        {
+            field.second = std::move(json);
+            return;
+        }
+    }
+
+    _fields.emplace_back(key, std::move(json));
+}
+
+void OperationRecord::addPhase(const PhaseMeasurement& phase)
+{
+    _phases.push_back(phase);
+}
+
+std::string OperationRecord::toJsonLine() const
+{
+    const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(_time.time_since_epoch()).count();
+
+    std::string json = "{\"operation\":" + toJson(_operation) + ",\"time\":" + std::to_string(milliseconds);
+
+    for (const auto& [key, value] : _fields)
+        json += "," + toJson(key) + ":" + value;
+
+    std::string phases;
+
+    for (const auto& phase : _phases)
+    {
+        if (!phases.empty())
+            phases += ",";
+
+        phases += "{\"name\":" + toJson(phase.name)
+            + ",\"seconds\":" + toJson(phase.seconds, 6)
+            + ",\"bytes\":" + std::to_string(phase.bytes)
+            + ",\"mb_per_s\":" + toJson(phase.getMegabytesPerSecond(), 1)
+            + ",\"threads\":" + std::to_string(phase.numberOfThreads)
+            + ",\"peak_transient_bytes\":" + std::to_string(phase.peakTransientBytes) + "}";
+    }
+
+    json += ",\"seconds\":" + toJson(_seconds, 6);
+    json += ",\"phases\":[" + phases + "]}";
+
+    return json;
+}
+
+const char* TimedFileReader::view(std::uint64_t offset, std::size_t size) const
+{
+    const char* bytes = _reader.view(offset, size);
+
+    if (bytes != nullptr)
+        _bytes += size;
+
+    return bytes;
+}
+
+void TimedFileReader::read(std::uint64_t offset, std::size_t size, char* destination) const
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    _reader.read(offset, size, destination);
+
+    _readNanoseconds    += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    _bytes              += size;
+}
+
+std::filesystem::path getMetricsFilePath(const std::filesystem::path& defaultPath)
+{
+    if (const char* metricsFile = std::getenv("BINIO_METRICS_FILE"))
+        return std::filesystem::path(metricsFile);
+
+    return defaultPath;
+}
+
+void appendLine(const std::filesystem::path& filePath, const std::string& line)
+{
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::error_code error;
+
+    if (filePath.has_parent_path())
+        std::filesystem::create_directories(filePath.parent_path(), error);
+
+    std::ofstream out(filePath, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+
+    out << line << '\n';
+    out.close();
+
+    if (!out)
+        throw std::runtime_error("Could not write to " + filePath.string() + ".");
+}
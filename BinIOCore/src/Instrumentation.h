@@ -0,0 +1,163 @@
+#pragma once
+
+#include "FileReader.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Timing and throughput instrumentation of imports and exports
+ *
+ * Every import or export fills one OperationRecord with its settings and the
+ * measurements of its phases (e.g. open, read, convert, hand-off to the core)
+ * and appends it as one JSON object per line to a metrics file, so that the
+ * records of many sessions can be collected and compared.
+ */
+
+/** Measures the wall-clock time since it was started */
+class Stopwatch
+{
+public:
+    Stopwatch() : _start(std::chrono::steady_clock::now()) { }
+
+    /** Start measuring again */
+    void restart() {
+        _start = std::chrono::steady_clock::now();
+    }
+
+    /** Get the seconds since the stopwatch was started */
+    double getSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point _start;
+};
+
+/** Measurement of one phase of an import or export */
+struct PhaseMeasurement
+{
+    std::string     name;                       /** Name of the phase, e.g. "read" */
+    double          seconds             = 0;    /** Wall-clock time in seconds */
+    std::uint64_t   bytes               = 0;    /** Bytes the phase processed */
+    std::size_t     numberOfThreads     = 1;    /** Threads that worked on the phase */
+    std::uint64_t   peakTransientBytes  = 0;    /** Largest amount of temporary memory the phase held at once */
+
+    /** Get the throughput in MB/s, 0 when the phase took no measurable time */
+    double getMegabytesPerSecond() const {
+        return seconds > 0 ? static_cast<double>(bytes) / 1.0e6 / seconds : 0;
+    }
+};
+
+/** Record of one import or export, serialized as one line of JSON */
+class OperationRecord
+{
+public:
+    /*! Start the record of an operation
+     *
+     * \param operation Kind of operation, e.g. "load" or "export"
+    */
+    explicit OperationRecord(std::string operation);
+
+    /** Set a string field, later values replace earlier ones */
+    void setField(const std::string& key, const std::string& value);
+
+    /** Set an integer field, later values replace earlier ones */
+    void setField(const std::string& key, std::uint64_t value);
+
+    /** Set the wall-clock time of the whole operation, phases may overlap */
+    void setSeconds(double seconds) {
+        _seconds = seconds;
+    }
+
+    /** Add the measurement of a phase, phases are kept in the order they are added */
+    void addPhase(const PhaseMeasurement& phase);
+
+    /** Get the measured phases */
+    const std::vector<PhaseMeasurement>& getPhases() const {
+        return _phases;
+    }
+
+    /*! Serialize the record as a single line of JSON, without the line break
+     *
+     * The object holds the operation, the time it was recorded (milliseconds
+     * since the Unix epoch), all fields, the seconds of the whole operation
+     * and the phases with their throughput.
+    */
+    std::string toJsonLine() const;
+
+private:
+    void setRawField(const std::string& key, std::string json);
+
+    std::string                                         _operation;
+    std::chrono::system_clock::time_point               _time;
+    std::vector<std::pair<std::string, std::string>>    _fields;    /** Keys and their serialized JSON values */
+    double                                              _seconds;   /** Wall-clock time of the whole operation */
+    std::vector<PhaseMeasurement>                       _phases;
+};
+
+/**
+ * Reader that measures the positional reads of another reader
+ *
+ * The time is summed over all threads that read concurrently. Bytes of
+ * views are counted, but not timed: reading them happens on the page faults
+ * of whoever accesses them.
+ */
+class TimedFileReader : public FileReader
+{
+public:
+    explicit TimedFileReader(const FileReader& reader) : _reader(reader) { }
+
+    std::uint64_t size() const override {
+        return _reader.size();
+    }
+
+    const char* view(std::uint64_t offset, std::size_t size) const override;
+
+    void release(std::uint64_t offset, std::size_t size) const override {
+        _reader.release(offset, size);
+    }
+
+    void read(std::uint64_t offset, std::size_t size, char* destination) const override;
+
+    /** Get the seconds spent in read, summed over all threads */
+    double getReadSeconds() const {
+        return static_cast<double>(_readNanoseconds.load()) / 1.0e9;
+    }
+
+    /** Get the number of bytes that were read or viewed */
+    std::uint64_t getBytes() const {
+        return _bytes;
+    }
+
+private:
+    const FileReader&                       _reader;
+    mutable std::atomic<std::uint64_t>      _readNanoseconds    = 0;
+    mutable std::atomic<std::uint64_t>      _bytes              = 0;
+};
+
+/*! Get the path of the metrics file
+ *
+ * The environment variable BINIO_METRICS_FILE overrides the default path,
+ * setting it to an empty value disables the metrics file.
+ *
+ * \param defaultPath Path used when BINIO_METRICS_FILE is not set
+ * \return Path of the metrics file, empty when it is disabled
+*/
+std::filesystem::path getMetricsFilePath(const std::filesystem::path& defaultPath);
+
+/*! Append a line to a file, creating the file and its directories as needed
+ *
+ * Appends of concurrent operations in one process do not interleave.
+ * Throws std::runtime_error when the file cannot be written.
+ *
+ * \param filePath Path of the file
+ * \param line Line to append, without the line break
+*/
+void appendLine(const std::filesystem::path& filePath, const std::string& line);
@@ -0,0 +1,172 @@
+#include "MemoryMappedFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& filePath)
+{
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("File was not found at location.");
+
+    _fileHandle = fileHandle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        close();
+        throw std::runtime_error("Could not determine the file size.");
+    }
+
+    _size = static_cast<std::size_t>(fileSize.QuadPart);
+
+    if (_size == 0)
+        return;
+
+    _mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mappingHandle == nullptr)
+    {
+        close();
+        throw std::runtime_error("Could not create a file mapping.");
+    }
+
+    _data = static_cast<const char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr)
+    {
+        close();
+        throw std::runtime_error("Could not map the file into memory.");
+    }
+#else
+    _fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+    if (_fileDescriptor < 0)
+        throw std::runtime_error("File was not found at location.");
+
+    struct stat fileStatus;
+    if (::fstat(_fileDescriptor, &fileStatus) != 0)
+    {
+        close();
+        throw std::runtime_error("Could not determine the file size.");
+    }
+
+    _size = static_cast<std::size_t>(fileStatus.st_size);
+
+    if (_size == 0)
+        return;
+
+    void* mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close();
+        throw std::runtime_error("Could not map the file into memory.");
+    }
+
+    _data = static_cast<const char*>(mapping);
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    close();
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+{
+    swap(other);
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        swap(other);
+    }
+
+    return *this;
+}
+
+void MemoryMappedFile::close()
+{
+#ifdef _WIN32
+    if (_data != nullptr)
+        UnmapViewOfFile(_data);
+
+    if (_mappingHandle != nullptr)
+        CloseHandle(_mappingHandle);
+
+    if (_fileHandle != nullptr)
+        CloseHandle(_fileHandle);
+
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+#else
+    if (_data != nullptr)
+        ::munmap(const_cast<char*>(_data), _size);
+
+    if (_fileDescriptor >= 0)
+        ::close(_fileDescriptor);
+
+    _fileDescriptor = -1;
+#endif
+
+    _data = nullptr;
+    _size = 0;
+}
+
+void MemoryMappedFile::release(std::size_t offset, std::size_t size) const
+{
+    if (_data == nullptr || offset >= _size)
+        return;
+
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const std::size_t pageSize = systemInfo.dwPageSize;
+#else
+    const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+
+    const std::size_t end   = std::min(offset + size, _size);
+    const std::size_t first = (offset + pageSize - 1) / pageSize * pageSize;
+    const std::size_t last  = end == _size ? end : end / pageSize * pageSize;
+
+    if (first >= last)
+        return;
+
+#ifdef _WIN32
+    // Unlocking pages that are not locked removes them from the working set
+    VirtualUnlock(const_cast<char*>(_data + first), last - first);
+#else
+    ::madvise(const_cast<char*>(_data + first), last - first, MADV_DONTNEED);
+#endif
+}
+
+void MemoryMappedFile::swap(MemoryMappedFile& other) noexcept
+{
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+#ifdef _WIN32
+    std::swap(_fileHandle, other._fileHandle);
+    std::swap(_mappingHandle, other._mappingHandle);
+#else
+    std::swap(_fileDescriptor, other._fileDescriptor);
+#endif
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+/**
+ * Read-only memory mapping of a whole file
+ *
+ * The file contents are accessible through data() for as long as the object
+ * lives, without copying them to the heap. The mapping (and file handle) is
+ * released on destruction. An empty file yields an empty span.
+ */
+class MemoryMappedFile
+{
+public:
+    MemoryMappedFile() = default;
+
+    /*! Map the file at filePath into memory
+     *
+     * Throws std::runtime_error when the file cannot be opened or mapped.
+     *
+     * \param filePath Path of the file to map
+    */
+    explicit MemoryMappedFile(const std::filesystem::path& filePath);
+
+    ~MemoryMappedFile();
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+    MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+    /** Unmap the file and close its handle */
+    void close();
+
+    /** Get a pointer to the first byte of the mapping (page aligned) */
+    const char* data() const {
+        return _data;
+    }
+
+    /** Get the number of mapped bytes */
+    std::size_t size() const {
+        return _size;
+    }
+
+    /** Get the mapped bytes as a span */
+    std::span<const char> bytes() const {
+        return { _data, _size };
+    }
+
+    /*! Drop the pages of a range that is no longer needed from the resident set
+     *
+     * The bytes stay accessible, they are paged in again when touched. Only
+     * pages that lie completely inside the range are released.
+     *
+     * \param offset Offset in bytes of the range
+     * \param size Size in bytes of the range
+    */
+    void release(std::size_t offset, std::size_t size) const;
+
+private:
+    void swap(MemoryMappedFile& other) noexcept;
+
+private:
+    const char*     _data = nullptr;            /** Start of the mapping */
+    std::size_t     _size = 0;                  /** Size of the mapping in bytes */
+#ifdef _WIN32
+    void*           _fileHandle = nullptr;      /** Win32 file handle */
+    void*           _mappingHandle = nullptr;   /** Win32 file mapping handle */
+#else
+    int             _fileDescriptor = -1;       /** POSIX file descriptor */
+#endif
+};
@@ -0,0 +1,230 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+double getSecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Accumulate the statistics of one run into stats
+void addStats(PipelineStats* stats, std::size_t numberOfThreads, std::uint64_t bufferBytes, double produceSeconds, double consumeSeconds)
+{
+    if (stats == nullptr)
+        return;
+
+    stats->numberOfThreads  = std::max(stats->numberOfThreads, numberOfThreads);
+    stats->bufferBytes      = std::max(stats->bufferBytes, bufferBytes);
+    stats->produceSeconds   += produceSeconds;
+    stats->consumeSeconds   += consumeSeconds;
+}
+
+}
+
+std::size_t resolveNumberOfThreads(std::size_t requestedNumberOfThreads)
+{
+    if (requestedNumberOfThreads > 0)
+        return requestedNumberOfThreads;
+
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+void forEachChunkInParallel(std::size_t numberOfChunks, std::size_t numberOfThreads, const std::function<void(std::size_t, std::vector<char>&)>& task, PipelineStats* stats)
+{
+    numberOfThreads = std::min(std::max<std::size_t>(1, numberOfThreads), numberOfChunks);
+
+    std::atomic<std::size_t>    nextChunk(0);
+    std::atomic<bool>           failed(false);
+    std::exception_ptr          firstException;
+    std::mutex                  exceptionMutex;
+    std::uint64_t               bufferBytes = 0;    // guarded by exceptionMutex
+    double                      taskSeconds = 0;    // guarded by exceptionMutex
+
+    const auto worker = [&]() -> void {
+        std::vector<char>   buffer;
+        double              workerSeconds = 0;
+
+        while (!failed.load(std::memory_order_relaxed))
+        {
+            const std::size_t chunkIndex = nextChunk.fetch_add(1, std::memory_order_relaxed);
+
+            if (chunkIndex >= numberOfChunks)
+                break;
+
+            try
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                task(chunkIndex, buffer);
+
+                if (stats != nullptr)
+                    workerSeconds += getSecondsSince(start);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+
+                if (!firstException)
+                    firstException = std::current_exception();
+
+                failed = true;
+            }
+        }
+
+        if (stats != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(exceptionMutex);
+
+            bufferBytes += buffer.capacity();
+            taskSeconds += workerSeconds;
+        }
+    };
+
+    // The calling thread does its share of the work as well
+    std::vector<std::thread> threads;
+    threads.reserve(numberOfThreads > 0 ? numberOfThreads - 1 : 0);
+
+    for (std::size_t threadIndex = 1; threadIndex < numberOfThreads; threadIndex++)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    addStats(stats, std::max<std::size_t>(1, numberOfThreads), bufferBytes, taskSeconds, 0);
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+}
+
+void runOrderedPipeline(std::size_t numberOfBlocks, std::size_t numberOfThreads, std::size_t numberOfBuffers, const std::function<void(std::size_t, std::vector<char>&)>& produce, const std::function<void(std::size_t, const std::vector<char>&)>& consume, PipelineStats* stats)
+{
+    if (numberOfBlocks == 0)
+        return;
+
+    numberOfBuffers = std::min(std::max<std::size_t>(1, numberOfBuffers), numberOfBlocks);
+    numberOfThreads = std::min(std::max<std::size_t>(1, numberOfThreads), numberOfBuffers);
+
+    std::vector<std::vector<char>>  buffers(numberOfBuffers);
+    std::vector<bool>               ready(numberOfBuffers, false);  // block in the buffer is produced, but not yet consumed
+    std::size_t                     nextBlock = 0;                  // next block to produce
+    std::size_t                     numberOfConsumedBlocks = 0;
+    std::exception_ptr              firstException;
+    std::mutex                      mutex;
+    std::condition_variable         changed;
+    double                          produceSeconds = 0;             // summed over the workers, guarded by mutex
+    double                          consumeSeconds = 0;
+
+    const auto fail = [&]() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!firstException)
+            firstException = std::current_exception();
+
+        changed.notify_all();
+    };
+
+    const auto worker = [&]() -> void {
+        while (true)
+        {
+            std::size_t blockIndex;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // Wait until the buffer of the next block has been consumed
+                changed.wait(lock, [&]() { return firstException || nextBlock >= numberOfBlocks || nextBlock < numberOfConsumedBlocks + numberOfBuffers; });
+
+                if (firstException || nextBlock >= numberOfBlocks)
+                    return;
+
+                blockIndex = nextBlock++;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+
+            try
+            {
+                produce(blockIndex, buffers[blockIndex % numberOfBuffers]);
+            }
+            catch (...)
+            {
+                fail();
+                return;
+            }
+
+            const double seconds = stats != nullptr ? getSecondsSince(start) : 0;
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            produceSeconds += seconds;
+            ready[blockIndex % numberOfBuffers] = true;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numberOfThreads);
+
+    for (std::size_t threadIndex = 0; threadIndex < numberOfThreads; threadIndex++)
+        threads.emplace_back(worker);
+
+    // The calling thread consumes the blocks in order
+    for (std::size_t blockIndex = 0; blockIndex < numberOfBlocks; blockIndex++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            changed.wait(lock, [&]() { return firstException || ready[blockIndex % numberOfBuffers]; });
+
+            if (firstException)
+                break;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        try
+        {
+            consume(blockIndex, buffers[blockIndex % numberOfBuffers]);
+        }
+        catch (...)
+        {
+            fail();
+            break;
+        }
+
+        if (stats != nullptr)
+            consumeSeconds += getSecondsSince(start);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        ready[blockIndex % numberOfBuffers] = false;
+        numberOfConsumedBlocks++;
+        changed.notify_all();
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    if (stats != nullptr)
+    {
+        std::uint64_t bufferBytes = 0;
+
+        for (const auto& buffer : buffers)
+            bufferBytes += buffer.capacity();
+
+        addStats(stats, numberOfThreads, bufferBytes, produceSeconds, consumeSeconds);
+    }
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+}
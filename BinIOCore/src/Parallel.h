@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Statistics of forEachChunkInParallel and runOrderedPipeline
+ *
+ * Passing the same statistics to several calls accumulates them: the
+ * largest thread count and buffer memory, the total task times.
+ */
+struct PipelineStats
+{
+    std::size_t     numberOfThreads = 0;    /** Number of threads that ran tasks */
+    std::uint64_t   bufferBytes     = 0;    /** Capacity of all task buffers together */
+    double          produceSeconds  = 0;    /** Time spent in the tasks (produce), summed over all threads */
+    double          consumeSeconds  = 0;    /** Time spent in consume on the calling thread */
+};
+
+/** Get the number of worker threads to use for the requested number (0 means all hardware threads) */
+std::size_t resolveNumberOfThreads(std::size_t requestedNumberOfThreads);
+
+/*! Run task for all chunks in [0, numberOfChunks) on up to numberOfThreads threads
+ *
+ * Chunks are handed out dynamically, so slow chunks do not stall the others.
+ * Every thread owns one scratch buffer that is passed to all of its tasks.
+ * The first exception thrown by a task stops the remaining chunks and is
+ * rethrown on the calling thread once all workers have finished.
+ *
+ * \param numberOfChunks Number of chunks
+ * \param numberOfThreads Maximum number of worker threads
+ * \param task Called as task(chunkIndex, scratchBuffer)
+ * \param stats Receives the statistics of the run, optional
+*/
+void forEachChunkInParallel(std::size_t numberOfChunks, std::size_t numberOfThreads, const std::function<void(std::size_t, std::vector<char>&)>& task, PipelineStats* stats = nullptr);
+
+/*! Produce blocks on worker threads and consume them in order on the calling thread
+ *
+ * Workers fill blocks concurrently, each into one of numberOfBuffers reusable
+ * buffers, while the calling thread consumes the finished blocks strictly in
+ * block order. A worker only starts block b once block b - numberOfBuffers
+ * has been consumed, so at most numberOfBuffers buffers exist at any time and
+ * producing overlaps with consuming. The first exception thrown by produce or
+ * consume stops the pipeline and is rethrown on the calling thread.
+ *
+ * \param numberOfBlocks Number of blocks
+ * \param numberOfThreads Number of producing worker threads
+ * \param numberOfBuffers Number of block buffers, at least one
+ * \param produce Called on a worker as produce(blockIndex, buffer)
+ * \param consume Called on the calling thread as consume(blockIndex, buffer), in block order
+ * \param stats Receives the statistics of the run, optional
+*/
+void runOrderedPipeline(std::size_t numberOfBlocks, std::size_t numberOfThreads, std::size_t numberOfBuffers, const std::function<void(std::size_t, std::vector<char>&)>& produce, const std::function<void(std::size_t, const std::vector<char>&)>& consume, PipelineStats* stats = nullptr);
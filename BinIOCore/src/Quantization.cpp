@@ -0,0 +1,28 @@
+#include "Quantization.h"
+
+#include <stdexcept>
+
+QuantizationTable makeQuantizationTable(const std::vector<ColumnRange>& ranges, unsigned int codeBits)
+{
+    if (codeBits != 8 && codeBits != 16)
+        throw std::invalid_argument("Codes must have 8 or 16 bits.");
+
+    const double maxCode = static_cast<double>((1u << codeBits) - 1);
+
+    QuantizationTable quantizationTable;
+
+    quantizationTable.scales.resize(ranges.size(), 0.0f);
+    quantizationTable.offsets.resize(ranges.size(), 0.0f);
+
+    for (std::size_t column = 0; column < ranges.size(); column++)
+    {
+        if (ranges[column].min > ranges[column].max)
+            continue;
+
+        // The range is computed in double, it may exceed the largest float
+        quantizationTable.scales[column]    = static_cast<float>((static_cast<double>(ranges[column].max) - ranges[column].min) / maxCode);
+        quantizationTable.offsets[column]   = ranges[column].min;
+    }
+
+    return quantizationTable;
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "ChunkedWriter.h"
+#include "ConversionKernels.h"
+#include "FileFormat.h"
+#include "Parallel.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+/**
+ * Linear quantization of point values
+ *
+ * Quantized files store every value as a uint8 or uint16 code of its
+ * dimension: the smallest finite value of a dimension becomes code 0, the
+ * largest the highest code, and value = offset + scale * code in between.
+ * Codes round to nearest, so a finite value is off by at most half a scale.
+ * Infinities saturate to the lowest or highest code, NaN becomes code 0.
+ *
+ * Values are quantized while they are gathered for writing; the loader
+ * dequantizes the codes while it converts them, see dequantizeElements.
+ */
+
+/** Smallest and largest finite value of a column, min > max when it has none */
+struct ColumnRange
+{
+    float   min = std::numeric_limits<float>::infinity();
+    float   max = -std::numeric_limits<float>::infinity();
+};
+
+/*! Get the range of the finite values of every column of the rows at rowIndices
+ *
+ * Worker threads each scan a share of the rows, their ranges are merged
+ * afterwards.
+ *
+ * \param data Rows of numColumns Source elements
+ * \param numColumns Number of elements per row
+ * \param rowIndices Indices of the rows to scan, nullptr scans all rows
+ * \param numRows Number of rows to scan
+ * \param numberOfThreads Number of worker threads, 0 uses all hardware threads
+*/
+template <typename Source>
+std::vector<ColumnRange> getColumnRanges(const Source* data, std::size_t numColumns, const std::uint32_t* rowIndices, std::size_t numRows, std::size_t numberOfThreads)
+{
+    std::vector<ColumnRange> ranges(numColumns);
+
+    if (numRows == 0 || numColumns == 0)
+        return ranges;
+
+    const std::size_t threads           = resolveNumberOfThreads(numberOfThreads);
+    const std::size_t numberOfChunks    = std::min(numRows, 4 * threads);
+    const std::size_t rowsPerChunk      = (numRows + numberOfChunks - 1) / numberOfChunks;
+
+    std::vector<std::vector<ColumnRange>> chunkRanges((numRows + rowsPerChunk - 1) / rowsPerChunk);
+
+    forEachChunkInParallel(chunkRanges.size(), threads, [&](std::size_t chunkIndex, std::vector<char>&) {
+        constexpr std::size_t blockSize = 256;
+
+        std::vector<ColumnRange>& columnRanges = chunkRanges[chunkIndex];
+
+        columnRanges.resize(numColumns);
+
+        float values[blockSize];
+
+        const std::size_t firstRow = chunkIndex * rowsPerChunk;
+
+        for (std::size_t row = firstRow; row < std::min(numRows, firstRow + rowsPerChunk); row++)
+        {
+            const Source* const input = data + static_cast<std::size_t>(rowIndices == nullptr ? row : rowIndices[row]) * numColumns;
+
+            for (std::size_t firstColumn = 0; firstColumn < numColumns; firstColumn += blockSize)
+            {
+                const std::size_t numValues = std::min(blockSize, numColumns - firstColumn);
+
+                convertElements<Source>(reinterpret_cast<const char*>(input + firstColumn), values, numValues);
+
+                for (std::size_t column = 0; column < numValues; column++)
+                {
+                    if (!std::isfinite(values[column]))
+                        continue;
+
+                    ColumnRange& range = columnRanges[firstColumn + column];
+
+                    range.min = std::min(range.min, values[column]);
+                    range.max = std::max(range.max, values[column]);
+                }
+            }
+        }
+    });
+
+    for (const auto& columnRanges : chunkRanges)
+    {
+        for (std::size_t column = 0; column < numColumns; column++)
+        {
+            ranges[column].min = std::min(ranges[column].min, columnRanges[column].min);
+            ranges[column].max = std::max(ranges[column].max, columnRanges[column].max);
+        }
+    }
+
+    return ranges;
+}
+
+/*! Make the quantization table that maps every column range onto codes of codeBits bits
+ *
+ * Columns with a single value get scale 0, columns without finite values
+ * offset 0 as well.
+ *
+ * \param ranges Range of every column, see getColumnRanges
+ * \param codeBits Number of bits of a code, 8 or 16
+*/
+QuantizationTable makeQuantizationTable(const std::vector<ColumnRange>& ranges, unsigned int codeBits);
+
+/*! Gather the rows at rowIndices from data, quantize them to Code and write them to out
+ *
+ * Like writeRowsInParallel, but every value is converted to float and
+ * quantized with the scale and offset of its column on the gathering
+ * workers.
+ *
+ * \param out Stream to write to, positioned where the first row goes
+ * \param data Rows of numColumns Source elements
+ * \param numColumns Number of elements per row
+ * \param rowIndices Indices of the rows to write in output order, nullptr writes all rows in order
+ * \param numRows Number of rows to write
+ * \param quantizationTable Scale and offset of every column, see makeQuantizationTable
+ * \param settings Thread count, buffer size, compression and progress
+ * \return Block index of the written blocks when settings.codec is not None, otherwise an empty block index
+*/
+template <typename Source, typename Code>
+BlockIndex writeQuantizedRowsInParallel(std::ostream& out, const Source* data, std::size_t numColumns, const std::uint32_t* rowIndices, std::size_t numRows, const QuantizationTable& quantizationTable, const ChunkedWriteSettings& settings)
+{
+    // Multiplying by the inverse scale is cheaper than dividing by the scale
+    std::vector<float> inverseScales(numColumns);
+
+    for (std::size_t column = 0; column < numColumns; column++)
+        inverseScales[column] = quantizationTable.scales[column] > 0 ? 1.0f / quantizationTable.scales[column] : 0.0f;
+
+    const float* const offsets = quantizationTable.offsets.data();
+
+    StatisticsCollector* const statistics = settings.statistics;
+
+    const auto gather = [data, numColumns, rowIndices, offsets, &inverseScales, statistics](std::size_t firstRow, std::size_t numBlockRows, char* buffer) -> void {
+        constexpr std::size_t blockSize = 256;
+
+        Code* output = reinterpret_cast<Code*>(buffer);
+
+        float values[blockSize];
+
+        std::optional<StatisticsAccumulator> accumulator;
+
+        if (statistics != nullptr)
+            accumulator.emplace(numColumns);
+
+        for (std::size_t row = firstRow; row < firstRow + numBlockRows; row++)
+        {
+            const Source* const input = data + static_cast<std::size_t>(rowIndices == nullptr ? row : rowIndices[row]) * numColumns;
+
+            for (std::size_t firstColumn = 0; firstColumn < numColumns; firstColumn += blockSize)
+            {
+                const std::size_t numValues = std::min(blockSize, numColumns - firstColumn);
+
+                convertElements<Source>(reinterpret_cast<const char*>(input + firstColumn), values, numValues);
+
+                // The statistics are of the exported values, not of their codes
+                if (accumulator)
+                    accumulator->addValues(values, numValues, firstColumn);
+
+                // Values are at least the offset, so adding a half before truncating rounds to nearest
+                for (std::size_t column = 0; column < numValues; column++)
+                    output[firstColumn + column] = saturateFloat<Code>((values[column] - offsets[firstColumn + column]) * inverseScales[firstColumn + column] + 0.5f);
+            }
+
+            output += numColumns;
+        }
+
+        if (accumulator)
+            statistics->merge(*accumulator);
+    };
+
+    return writeBlocksInParallel(out, numColumns == 0 ? 0 : numRows, numColumns * sizeof(Code), sizeof(Code), gather, settings);
+}
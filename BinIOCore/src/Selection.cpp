@@ -0,0 +1,222 @@
+#include "Selection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+// Parses the unsigned number at position, which is advanced past it
+std::uint64_t parseNumber(const std::string& text, std::size_t& position)
+{
+    if (position >= text.size() || !std::isdigit(static_cast<unsigned char>(text[position])))
+        throw std::runtime_error("Expected a number at position " + std::to_string(position + 1) + " of \"" + text + "\".");
+
+    std::uint64_t number = 0;
+
+    for (; position < text.size() && std::isdigit(static_cast<unsigned char>(text[position])); position++)
+    {
+        if (number > (UINT64_MAX - 9) / 10)
+            throw std::runtime_error("The number at position " + std::to_string(position + 1) + " of \"" + text + "\" is too large.");
+
+        number = 10 * number + static_cast<std::uint64_t>(text[position] - '0');
+    }
+
+    return number;
+}
+
+// Draws a uniform number below bound; unlike std::uniform_int_distribution the result is the same with every standard library
+std::uint64_t uniformBelow(std::mt19937_64& generator, std::uint64_t bound)
+{
+    const std::uint64_t threshold = (0 - bound) % bound;
+
+    while (true)
+    {
+        const std::uint64_t value = generator();
+
+        if (value >= threshold)
+            return value % bound;
+    }
+}
+
+bool isSeparator(char character)
+{
+    return character == ',' || character == ';' || std::isspace(static_cast<unsigned char>(character));
+}
+
+}
+
+std::vector<std::uint32_t> parseIndexList(const std::string& text, std::size_t count)
+{
+    std::vector<std::uint32_t> indices;
+
+    std::size_t position = 0;
+
+    while (true)
+    {
+        while (position < text.size() && isSeparator(text[position]))
+            position++;
+
+        if (position >= text.size())
+            break;
+
+        const std::uint64_t first = parseNumber(text, position);
+        std::uint64_t last = first;
+
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+            position++;
+
+        if (position < text.size() && text[position] == '-')
+        {
+            position++;
+
+            while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+                position++;
+
+            last = parseNumber(text, position);
+
+            if (last < first)
+                throw std::runtime_error("The range " + std::to_string(first) + "-" + std::to_string(last) + " is empty.");
+        }
+
+        if (last >= count)
+            throw std::runtime_error("Index " + std::to_string(last) + " is out of range, there are " + std::to_string(count) + ".");
+
+        for (std::uint64_t index = first; index <= last; index++)
+            indices.push_back(static_cast<std::uint32_t>(index));
+
+        if (position < text.size() && !isSeparator(text[position]))
+            throw std::runtime_error("Unexpected character at position " + std::to_string(position + 1) + " of \"" + text + "\".");
+    }
+
+    return indices;
+}
+
+std::vector<ColumnRun> getColumnRuns(const std::vector<std::uint32_t>& columns)
+{
+    std::vector<ColumnRun> runs;
+
+    for (std::size_t outputColumn = 0; outputColumn < columns.size(); outputColumn++)
+    {
+        if (!runs.empty() && runs.back().firstColumn + runs.back().numColumns == columns[outputColumn])
+            runs.back().numColumns++;
+        else
+            runs.push_back({ columns[outputColumn], 1, outputColumn });
+    }
+
+    return runs;
+}
+
+std::vector<ByteRange> getRowByteRanges(const std::vector<ColumnRun>& runs, std::size_t elementSize, std::size_t mergeGap)
+{
+    std::vector<ByteRange> ranges;
+
+    for (const auto& run : runs)
+        ranges.push_back({ run.firstColumn * elementSize, (run.firstColumn + run.numColumns) * elementSize });
+
+    std::sort(ranges.begin(), ranges.end(), [](const ByteRange& lhs, const ByteRange& rhs) { return lhs.begin < rhs.begin; });
+
+    std::vector<ByteRange> mergedRanges;
+
+    for (const auto& range : ranges)
+    {
+        if (!mergedRanges.empty() && range.begin <= mergedRanges.back().end + mergeGap)
+            mergedRanges.back().end = std::max(mergedRanges.back().end, range.end);
+        else
+            mergedRanges.push_back(range);
+    }
+
+    return mergedRanges;
+}
+
+std::uint64_t RowSelection::lowerBound(std::uint64_t row) const
+{
+    if (!rows.empty())
+        return static_cast<std::uint64_t>(std::lower_bound(rows.begin(), rows.end(), row) - rows.begin());
+
+    if (row <= first)
+        return 0;
+
+    return std::min(count, (row - first + step - 1) / step);
+}
+
+RowSelection selectRows(const RowSelectionSettings& settings, std::uint64_t numRows)
+{
+    RowSelection selection;
+
+    const std::uint64_t first = std::min(settings.first, numRows);
+
+    switch (settings.mode)
+    {
+        case RowSelectionSettings::Mode::All:
+            selection.count = numRows;
+            break;
+
+        case RowSelectionSettings::Mode::Range:
+            selection.first = first;
+            selection.count = std::min(settings.count, numRows - first);
+            break;
+
+        case RowSelectionSettings::Mode::Stride:
+            selection.first = first;
+            selection.step  = std::max<std::uint64_t>(settings.step, 1);
+            selection.count = (numRows - first + selection.step - 1) / selection.step;
+            break;
+
+        case RowSelectionSettings::Mode::Random:
+        {
+            const std::uint64_t count = std::min(settings.count, numRows);
+
+            // A sample of all rows is all rows, which is read contiguously
+            if (count == numRows)
+            {
+                selection.count = numRows;
+                break;
+            }
+
+            // Floyd's algorithm draws count distinct rows in count steps, however large the file
+            std::mt19937_64 generator(settings.seed);
+            std::unordered_set<std::uint64_t> sample;
+            sample.reserve(static_cast<std::size_t>(count));
+
+            for (std::uint64_t candidate = numRows - count; candidate < numRows; candidate++)
+            {
+                const std::uint64_t row = uniformBelow(generator, candidate + 1);
+
+                sample.insert(sample.count(row) ? candidate : row);
+            }
+
+            selection.rows.assign(sample.begin(), sample.end());
+            std::sort(selection.rows.begin(), selection.rows.end());
+            break;
+        }
+    }
+
+    return selection;
+}
+
+RowSelection sliceRows(const RowSelection& rows, std::uint64_t begin, std::uint64_t end)
+{
+    const std::uint64_t firstIndex  = rows.lowerBound(begin);
+    const std::uint64_t endIndex    = std::max(firstIndex, rows.lowerBound(end));
+
+    RowSelection slice;
+
+    if (!rows.rows.empty())
+    {
+        slice.rows.reserve(static_cast<std::size_t>(endIndex - firstIndex));
+
+        for (std::uint64_t index = firstIndex; index < endIndex; index++)
+            slice.rows.push_back(rows.rows[static_cast<std::size_t>(index)] - begin);
+
+        return slice;
+    }
+
+    slice.step  = rows.step;
+    slice.count = endIndex - firstIndex;
+    slice.first = slice.count > 0 ? rows.getRow(firstIndex) - begin : 0;
+
+    return slice;
+}
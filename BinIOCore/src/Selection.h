@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! Parse a list of indices and inclusive index ranges, e.g. "0-49, 100, 200-210"
+ *
+ * Items are separated by commas, semicolons or white space and kept in the
+ * given order. Throws std::runtime_error when the text cannot be parsed or
+ * an index is not below count.
+ *
+ * \param text List of indices and ranges
+ * \param count Number of valid indices
+ * \return Indices in the given order, empty for empty text
+*/
+std::vector<std::uint32_t> parseIndexList(const std::string& text, std::size_t count);
+
+/** Rows of a file that are loaded, in increasing order */
+struct RowSelection
+{
+    std::uint64_t               first   = 0;    /** First row */
+    std::uint64_t               step    = 1;    /** Distance between consecutive rows */
+    std::uint64_t               count   = 0;    /** Number of rows */
+    std::vector<std::uint64_t>  rows;           /** Explicit sorted rows, used instead of first, step and count when not empty */
+
+    /** Get the number of selected rows */
+    std::uint64_t size() const {
+        return rows.empty() ? count : rows.size();
+    }
+
+    /** Get the file row of the selected row at index */
+    std::uint64_t getRow(std::uint64_t index) const {
+        return rows.empty() ? first + index * step : rows[static_cast<std::size_t>(index)];
+    }
+
+    /** Get the index of the first selected row that is not below row */
+    std::uint64_t lowerBound(std::uint64_t row) const;
+
+    /** Whether the selected rows follow each other without gaps */
+    bool isContiguous() const {
+        return rows.empty() && step == 1;
+    }
+};
+
+/** How the loaded rows are picked from a file */
+struct RowSelectionSettings
+{
+    enum class Mode
+    {
+        All,        /** All rows */
+        Range,      /** count rows from first on */
+        Stride,     /** Every step-th row from first on */
+        Random      /** A uniform random sample of count rows, reproducible by seed */
+    };
+
+    Mode            mode    = Mode::All;
+    std::uint64_t   first   = 0;
+    std::uint64_t   count   = 0;
+    std::uint64_t   step    = 1;
+    std::uint64_t   seed    = 0;
+};
+
+/*! Select rows of a file with numRows rows
+ *
+ * Ranges are clipped to the file. The random sample is drawn without
+ * replacement with a fixed generator, so a seed selects the same rows on
+ * every platform.
+ *
+ * \param settings How rows are picked
+ * \param numRows Number of rows in the file
+*/
+RowSelection selectRows(const RowSelectionSettings& settings, std::uint64_t numRows);
+
+/*! Get the selected rows that lie in [begin, end), relative to begin
+ *
+ * Used to split a selection over concatenated files into the selections of
+ * the files. The first row of the slice is row rows.lowerBound(begin) of
+ * the whole selection.
+ *
+ * \param rows Selected rows
+ * \param begin First row of the slice
+ * \param end Row after the last row of the slice
+*/
+RowSelection sliceRows(const RowSelection& rows, std::uint64_t begin, std::uint64_t end);
+
+/** Run of consecutive file columns that lands on consecutive output columns */
+struct ColumnRun
+{
+    std::size_t firstColumn     = 0;    /** First column in the file */
+    std::size_t numColumns      = 0;    /** Number of columns */
+    std::size_t outputColumn    = 0;    /** First column in the output */
+};
+
+/** Split selected columns (in output order) into runs of consecutive file columns */
+std::vector<ColumnRun> getColumnRuns(const std::vector<std::uint32_t>& columns);
+
+/** Range [begin, end) of bytes */
+struct ByteRange
+{
+    std::size_t begin   = 0;
+    std::size_t end     = 0;
+};
+
+/*! Get the byte ranges of a row that hold the given column runs
+ *
+ * The ranges are sorted by position; ranges closer together than mergeGap
+ * bytes are merged, since reading the gap is cheaper than another request.
+ *
+ * \param runs Column runs, see getColumnRuns
+ * \param elementSize Size in bytes of one element
+ * \param mergeGap Largest gap in bytes that is read rather than skipped
+*/
+std::vector<ByteRange> getRowByteRanges(const std::vector<ColumnRun>& runs, std::size_t elementSize, std::size_t mergeGap);
@@ -0,0 +1,67 @@
+#include "Statistics.h"
+
+#include <algorithm>
+
+ColumnStatistics mergeColumnStatistics(const ColumnStatistics& first, const ColumnStatistics& second)
+{
+    if (second.count == 0)
+        return first;
+
+    if (first.count == 0)
+        return second;
+
+    // Combines the sums of squared deviations of both sets (Chan et al.)
+    const double count          = static_cast<double>(first.count) + static_cast<double>(second.count);
+    const double delta          = second.mean - first.mean;
+    const double sumOfSquares   = first.variance * static_cast<double>(first.count) + second.variance * static_cast<double>(second.count) + delta * delta * static_cast<double>(first.count) * static_cast<double>(second.count) / count;
+
+    ColumnStatistics merged;
+
+    merged.count    = first.count + second.count;
+    merged.min      = std::min(first.min, second.min);
+    merged.max      = std::max(first.max, second.max);
+    merged.mean     = first.mean + delta * static_cast<double>(second.count) / count;
+    merged.variance = sumOfSquares / count;
+
+    return merged;
+}
+
+std::vector<ColumnStatistics> StatisticsAccumulator::getStatistics() const
+{
+    std::vector<ColumnStatistics> statistics(_sums.size());
+
+    for (std::size_t column = 0; column < _sums.size(); column++)
+    {
+        const Sums& sums = _sums[column];
+
+        if (sums.count == 0)
+            continue;
+
+        const double count = static_cast<double>(sums.count);
+
+        statistics[column].count    = sums.count;
+        statistics[column].min      = sums.min;
+        statistics[column].max      = sums.max;
+        statistics[column].mean     = sums.shift + sums.sum / count;
+        statistics[column].variance = std::max(0.0, (sums.sumOfSquares - sums.sum * sums.sum / count) / count);
+    }
+
+    return statistics;
+}
+
+void StatisticsCollector::merge(const StatisticsAccumulator& accumulator)
+{
+    const auto statistics = accumulator.getStatistics();
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    for (std::size_t column = 0; column < std::min(statistics.size(), _statistics.size()); column++)
+        _statistics[column] = mergeColumnStatistics(_statistics[column], statistics[column]);
+}
+
+std::vector<ColumnStatistics> StatisticsCollector::getStatistics() const
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    return _statistics;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ConversionKernels.h"
+#include "FileFormat.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Per-dimension statistics, gathered while values are converted
+ *
+ * Loads and exports already touch every value once, when they convert it,
+ * so they accumulate the minimum, maximum, mean and variance of every
+ * column in the same pass: every worker thread accumulates the values of
+ * its chunk while they are still in the cache, and merges its sums into a
+ * shared collector once the chunk is done. NaN and infinities are skipped.
+ *
+ * Sums are taken relative to the first value of every column in a chunk,
+ * which keeps the variance accurate for values far from zero.
+ */
+
+/*! Merge the statistics of two disjoint sets of values of a column */
+ColumnStatistics mergeColumnStatistics(const ColumnStatistics& first, const ColumnStatistics& second);
+
+/** Running sums of the values of every column, owned by a single thread */
+class StatisticsAccumulator
+{
+public:
+    explicit StatisticsAccumulator(std::size_t numColumns) : _sums(numColumns) { }
+
+    /** Add count values of consecutive columns of one row, from firstColumn on */
+    template <typename T>
+    void addValues(const T* values, std::size_t count, std::size_t firstColumn) {
+        for (std::size_t index = 0; index < count; index++)
+            add(_sums[firstColumn + index], elementToFloat(values[index]));
+    }
+
+    /** Add numRows whole rows */
+    template <typename T>
+    void addRows(const T* rows, std::size_t numRows) {
+        for (std::size_t row = 0; row < numRows; row++)
+            addValues(rows + row * _sums.size(), _sums.size(), 0);
+    }
+
+    /** Add count values of a single column */
+    template <typename T>
+    void addColumn(const T* values, std::size_t count, std::size_t column) {
+        for (std::size_t index = 0; index < count; index++)
+            add(_sums[column], elementToFloat(values[index]));
+    }
+
+    /** Get the statistics of the values added so far */
+    std::vector<ColumnStatistics> getStatistics() const;
+
+private:
+    struct Sums
+    {
+        std::uint64_t   count           = 0;
+        double          shift           = 0;    // First value, the sums are relative to it
+        double          sum             = 0;
+        double          sumOfSquares    = 0;
+        float           min             = 0;
+        float           max             = 0;
+    };
+
+    static void add(Sums& sums, float value) {
+        if (!std::isfinite(value))
+            return;
+
+        if (sums.count == 0)
+        {
+            sums.shift  = value;
+            sums.min    = value;
+            sums.max    = value;
+        }
+
+        const double deviation = static_cast<double>(value) - sums.shift;
+
+        sums.count++;
+        sums.sum            += deviation;
+        sums.sumOfSquares   += deviation * deviation;
+        sums.min            = value < sums.min ? value : sums.min;
+        sums.max            = value > sums.max ? value : sums.max;
+    }
+
+    std::vector<Sums> _sums;
+};
+
+/** Statistics of every column that several threads merge their accumulators into */
+class StatisticsCollector
+{
+public:
+    explicit StatisticsCollector(std::size_t numColumns) : _statistics(numColumns) { }
+
+    /** Merge the values of an accumulator of the same number of columns, thread-safe */
+    void merge(const StatisticsAccumulator& accumulator);
+
+    /** Get the statistics of all merged values */
+    std::vector<ColumnStatistics> getStatistics() const;
+
+private:
+    mutable std::mutex              _mutex;
+    std::vector<ColumnStatistics>   _statistics;
+};
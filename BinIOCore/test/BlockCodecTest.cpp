@@ -0,0 +1,258 @@
+// binio_codec_test: round trips and corrupt input of the block codec
+//
+// Encodes and decodes blocks of all element sizes of the file format, with
+// and without the byte shuffle, and checks that truncated or bit-flipped
+// compressed blocks either fail with std::runtime_error or decode without
+// writing outside their output. Run through ctest, exits with 1 on failure.
+
+#include "BlockCodec.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Bytes behind every output buffer, which a decoder must leave alone
+constexpr std::size_t guardSize = 64;
+constexpr char guardByte = static_cast<char>(0xA5);
+
+int numberOfFailures = 0;
+
+void check(bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::fprintf(stderr, "FAILED: %s\n", description.c_str());
+    numberOfFailures++;
+}
+
+bool isGuardIntact(const std::vector<char>& buffer, std::size_t size)
+{
+    for (std::size_t index = size; index < buffer.size(); index++)
+        if (buffer[index] != guardByte)
+            return false;
+
+    return true;
+}
+
+// Blocks of count elements of elementSize bytes
+std::vector<char> makeSmoothBlock(std::size_t count, std::size_t elementSize)
+{
+    std::vector<char> block(count * elementSize);
+
+    for (std::size_t index = 0; index < count; index++)
+    {
+        const std::uint64_t value = 1000 + index / 3;
+        std::memcpy(block.data() + index * elementSize, &value, elementSize);
+    }
+
+    return block;
+}
+
+std::vector<char> makeRandomBlock(std::size_t size, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::vector<char> block(size);
+
+    for (auto& byte : block)
+        byte = static_cast<char>(random());
+
+    return block;
+}
+
+std::vector<char> makeConstantBlock(std::size_t size)
+{
+    return std::vector<char>(size, 42);
+}
+
+// Decodes encoded into a guarded buffer, returns whether it decoded and whether it wrote outside its output
+bool decodeGuarded(const std::vector<char>& encoded, std::size_t rawSize, std::size_t elementSize, BlockFilter filter, std::vector<char>& raw, bool& guardIntact)
+{
+    raw.assign(rawSize + guardSize, guardByte);
+
+    std::vector<char> scratch(rawSize + guardSize, guardByte);
+
+    // The encoded bytes have no slack, reads past them are caught by the sanitizers
+    const std::vector<char> input(encoded);
+
+    bool decoded = true;
+
+    try
+    {
+        decodeBlock(input.data(), input.size(), raw.data(), rawSize, elementSize, BlockCodec::LZ, filter, scratch.data());
+    }
+    catch (const std::runtime_error&)
+    {
+        decoded = false;
+    }
+
+    guardIntact = isGuardIntact(raw, rawSize) && isGuardIntact(scratch, rawSize);
+
+    return decoded;
+}
+
+std::vector<char> encode(const std::vector<char>& raw, std::size_t elementSize, BlockFilter filter)
+{
+    std::vector<char> encoded(getEncodedBlockBound(raw.size()));
+    std::vector<char> scratch(raw.size());
+
+    encoded.resize(encodeBlock(raw.data(), raw.size(), elementSize, BlockCodec::LZ, filter, encoded.data(), scratch.data()));
+
+    return encoded;
+}
+
+void testRoundTrip(const std::string& name, const std::vector<char>& raw, std::size_t elementSize, BlockFilter filter, bool compressible)
+{
+    const std::string description = name + ", element size " + std::to_string(elementSize) + (filter == BlockFilter::ByteShuffle ? ", shuffled" : "");
+
+    const auto encoded = encode(raw, elementSize, filter);
+
+    check(encoded.size() <= raw.size(), description + ": encoded block is not larger than the raw block");
+
+    if (compressible)
+        check(encoded.size() < raw.size(), description + ": block compresses");
+
+    std::vector<char> decoded;
+    bool guardIntact = false;
+
+    check(decodeGuarded(encoded, raw.size(), elementSize, filter, decoded, guardIntact), description + ": block decodes");
+    check(guardIntact, description + ": decoding stays within the output");
+    check(raw.empty() || std::memcmp(decoded.data(), raw.data(), raw.size()) == 0, description + ": decoded block matches");
+}
+
+void testLZRoundTrip(const std::string& name, const std::vector<char>& raw)
+{
+    std::vector<char> compressed(getEncodedBlockBound(raw.size()));
+
+    compressed.resize(compressLZ(raw.data(), raw.size(), compressed.data(), compressed.size()));
+
+    check(!compressed.empty(), name + ": LZ output fits its bound");
+
+    std::vector<char> decompressed(raw.size() + guardSize, guardByte);
+
+    try
+    {
+        decompressLZ(compressed.data(), compressed.size(), decompressed.data(), raw.size());
+
+        check(raw.empty() || std::memcmp(decompressed.data(), raw.data(), raw.size()) == 0, name + ": LZ output decompresses");
+    }
+    catch (const std::runtime_error& e)
+    {
+        check(false, name + ": LZ output decompresses (" + e.what() + ")");
+    }
+
+    check(isGuardIntact(decompressed, raw.size()), name + ": LZ decompression stays within the output");
+
+    // Output that does not fit is reported as 0 instead of being written past the capacity
+    if (compressed.size() > 1)
+    {
+        std::vector<char> small(compressed.size() - 1 + guardSize, guardByte);
+
+        check(compressLZ(raw.data(), raw.size(), small.data(), compressed.size() - 1) == 0, name + ": LZ reports output that does not fit");
+        check(isGuardIntact(small, compressed.size() - 1), name + ": LZ compression stays within its capacity");
+    }
+}
+
+// Every truncation of a compressed block fails, bit flips fail or decode within the output
+void testCorruptInput(const std::string& name, const std::vector<char>& raw, std::size_t elementSize, BlockFilter filter)
+{
+    const auto encoded = encode(raw, elementSize, filter);
+
+    if (encoded.size() >= raw.size())
+    {
+        check(false, name + ": block compresses, so that it can be corrupted");
+        return;
+    }
+
+    std::vector<char> decoded;
+    bool guardIntact = false;
+
+    for (std::size_t size = 1; size < encoded.size(); size++)
+    {
+        const std::vector<char> truncated(encoded.begin(), encoded.begin() + size);
+
+        check(!decodeGuarded(truncated, raw.size(), elementSize, filter, decoded, guardIntact), name + ": truncation to " + std::to_string(size) + " bytes fails");
+        check(guardIntact, name + ": truncation to " + std::to_string(size) + " bytes stays within the output");
+    }
+
+    std::mt19937 random(7);
+
+    for (std::size_t flip = 0; flip < 2000; flip++)
+    {
+        std::vector<char> corrupted(encoded);
+
+        const std::size_t bit = random() % (8 * corrupted.size());
+        corrupted[bit / 8] = static_cast<char>(corrupted[bit / 8] ^ (1 << (bit % 8)));
+
+        decodeGuarded(corrupted, raw.size(), elementSize, filter, decoded, guardIntact);
+
+        check(guardIntact, name + ": flip of bit " + std::to_string(bit) + " stays within the output");
+    }
+}
+
+}
+
+int main()
+{
+    try
+    {
+        for (const std::size_t elementSize : { 1, 2, 4, 8 })
+        {
+            const std::size_t count = (std::size_t(1) << 20) / elementSize;
+
+            for (const auto filter : { BlockFilter::None, BlockFilter::ByteShuffle })
+            {
+                testRoundTrip("smooth", makeSmoothBlock(count, elementSize), elementSize, filter, true);
+                testRoundTrip("incompressible", makeRandomBlock(count * elementSize, 1), elementSize, filter, false);
+                testRoundTrip("constant", makeConstantBlock(count * elementSize), elementSize, filter, true);
+
+                // Blocks around the minimum input of the codec, of one element up to a few
+                for (const std::size_t shortCount : { 1, 2, 3, 7, 13, 16, 17, 100 })
+                {
+                    testRoundTrip("short smooth", makeSmoothBlock(shortCount, elementSize), elementSize, filter, false);
+                    testRoundTrip("short constant", makeConstantBlock(shortCount * elementSize), elementSize, filter, false);
+                }
+            }
+        }
+
+        testRoundTrip("empty", {}, 4, BlockFilter::ByteShuffle, false);
+
+        for (const std::size_t size : { std::size_t(0), std::size_t(1), std::size_t(12), std::size_t(13), std::size_t(100), std::size_t(70000), std::size_t(1) << 20 })
+        {
+            testLZRoundTrip("random " + std::to_string(size), makeRandomBlock(size, 2));
+            testLZRoundTrip("constant " + std::to_string(size), makeConstantBlock(size));
+            testLZRoundTrip("smooth " + std::to_string(size), makeSmoothBlock(size / 4, 4));
+        }
+
+        testCorruptInput("smooth", makeSmoothBlock(4096, 4), 4, BlockFilter::ByteShuffle);
+        testCorruptInput("constant", makeConstantBlock(20000), 1, BlockFilter::None);
+        testCorruptInput("mixed", [] {
+            auto block = makeSmoothBlock(2048, 8);
+            const auto noise = makeRandomBlock(4096, 3);
+            std::memcpy(block.data() + 4096, noise.data(), noise.size());
+            return block;
+        }(), 8, BlockFilter::ByteShuffle);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "binio_codec_test: %s\n", e.what());
+        return 1;
+    }
+
+    if (numberOfFailures > 0)
+    {
+        std::fprintf(stderr, "binio_codec_test: %d checks failed\n", numberOfFailures);
+        return 1;
+    }
+
+    std::printf("binio_codec_test: all checks passed\n");
+
+    return 0;
+}
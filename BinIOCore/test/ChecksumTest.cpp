@@ -0,0 +1,197 @@
+// binio_checksum_test: corrupt data is caught by the block checksums
+//
+// Writes small raw and compressed files with checksums through
+// writeRowsInParallel, flips one byte of their data and checks that loading
+// them throws std::runtime_error with every read method, while the intact
+// files, and the corrupt files without verification, load.
+// Run through ctest, exits with 1 on failure.
+
+#include "ChunkedLoader.h"
+#include "ChunkedWriter.h"
+#include "FileReader.h"
+#include "Selection.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t numRows       = 5000;
+constexpr std::size_t numColumns    = 7;
+constexpr std::size_t dataOffset    = FileHeader::headerSize;
+
+int numberOfFailures = 0;
+
+void check(bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::fprintf(stderr, "FAILED: %s\n", description.c_str());
+    numberOfFailures++;
+}
+
+std::vector<float> makeData()
+{
+    std::vector<float> data(numRows * numColumns);
+
+    for (std::size_t index = 0; index < data.size(); index++)
+        data[index] = static_cast<float>(index % 1000) * 0.5f;
+
+    return data;
+}
+
+// Writes the rows behind a zeroed header, in blocks of a few kilobytes so that the file has many checksums
+BlockIndex writeFile(const std::filesystem::path& filePath, const std::vector<float>& data, BlockCodec codec, BlockChecksums& checksums)
+{
+    std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+
+    const std::vector<char> header(dataOffset, 0);
+    out.write(header.data(), header.size());
+
+    ChunkedWriteSettings settings;
+    settings.numberOfThreads    = 4;
+    settings.codec              = codec;
+    settings.blockSize          = 4096;
+    settings.checksums          = &checksums;
+
+    BlockIndex blockIndex = writeRowsInParallel<float, float>(out, data.data(), numColumns, nullptr, numRows, settings);
+    blockIndex.numRows = numRows;
+
+    out.close();
+
+    if (!out)
+        throw std::runtime_error("Unable to write " + filePath.string());
+
+    return blockIndex;
+}
+
+void flipByte(const std::filesystem::path& filePath, std::uint64_t offset)
+{
+    std::fstream file(filePath, std::ios::binary | std::ios::in | std::ios::out);
+
+    char byte = 0;
+
+    file.seekg(offset);
+    file.read(&byte, 1);
+
+    byte = static_cast<char>(byte ^ 0x10);
+
+    file.seekp(offset);
+    file.write(&byte, 1);
+
+    if (!file)
+        throw std::runtime_error("Unable to modify " + filePath.string());
+}
+
+// Loads the whole file, returns whether it loaded and whether the loaded rows match data
+bool load(const std::filesystem::path& filePath, ReadMethod readMethod, const BlockIndex& blockIndex, const BlockChecksums* checksums, const std::vector<float>& data, bool& matches)
+{
+    const auto reader = openFileReader(filePath, readMethod);
+
+    ChunkedLoadSettings settings;
+    settings.numberOfThreads    = 4;
+    settings.checksums          = checksums;
+    settings.checksumOffset     = dataOffset;
+
+    std::vector<float> loaded(numRows * numColumns);
+
+    try
+    {
+        if (blockIndex.getNumberOfBlocks() > 0)
+            loadBlocksInParallel<float>(*reader, dataOffset, blockIndex, numColumns, selectRows(RowSelectionSettings(), numRows), {}, loaded.data(), settings);
+        else
+            loadRowsInParallel<float>(*reader, dataOffset, numRows, numColumns, loaded.data(), settings);
+    }
+    catch (const std::runtime_error&)
+    {
+        matches = false;
+        return false;
+    }
+
+    matches = loaded == data;
+
+    return true;
+}
+
+void testCorruption(const std::string& name, BlockCodec codec)
+{
+    const auto filePath = std::filesystem::temp_directory_path() / ("binio_checksum_test_" + name + ".bin");
+    const auto data     = makeData();
+
+    BlockChecksums checksums;
+
+    const BlockIndex blockIndex = writeFile(filePath, data, codec, checksums);
+
+    check(checksums.checksums.size() > 2, name + ": the data has several checksums");
+
+    bool matches = false;
+
+    for (const auto readMethod : { ReadMethod::MemoryMap, ReadMethod::PositionalRead, ReadMethod::DirectRead })
+    {
+        const std::string description = name + ", " + getReadMethodName(readMethod);
+
+        check(load(filePath, readMethod, blockIndex, &checksums, data, matches) && matches, description + ": intact data loads");
+    }
+
+    // One byte in the middle of the data, inside a block other than the first. A flip in
+    // compressed data may break the block encoding itself, which the decoder rejects even
+    // without checksums, so the first byte from there on whose flip still decodes is used
+    const std::uint64_t middle  = dataOffset + checksums.dataSize / 2;
+    bool loadsUnverified        = false;
+
+    for (std::uint64_t offset = middle; offset < middle + 256 && !loadsUnverified; offset++)
+    {
+        flipByte(filePath, offset);
+
+        loadsUnverified = load(filePath, ReadMethod::PositionalRead, blockIndex, nullptr, data, matches) && !matches;
+
+        if (!loadsUnverified)
+            flipByte(filePath, offset);
+    }
+
+    check(loadsUnverified, name + ": a flipped byte is loaded without verification");
+
+    for (const auto readMethod : { ReadMethod::MemoryMap, ReadMethod::PositionalRead, ReadMethod::DirectRead })
+    {
+        const std::string description = name + ", " + getReadMethodName(readMethod);
+
+        check(!load(filePath, readMethod, blockIndex, &checksums, data, matches), description + ": corrupt data is rejected");
+        check(load(filePath, readMethod, blockIndex, nullptr, data, matches) && !matches, description + ": corrupt data loads without verification");
+    }
+
+    std::error_code error;
+    std::filesystem::remove(filePath, error);
+}
+
+}
+
+int main()
+{
+    try
+    {
+        testCorruption("raw", BlockCodec::None);
+        testCorruption("compressed", BlockCodec::LZ);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "binio_checksum_test: %s\n", e.what());
+        return 1;
+    }
+
+    if (numberOfFailures > 0)
+    {
+        std::fprintf(stderr, "binio_checksum_test: %d checks failed\n", numberOfFailures);
+        return 1;
+    }
+
+    std::printf("binio_checksum_test: all checks passed\n");
+
+    return 0;
+}
@@ -0,0 +1,279 @@
+// binio_index_test: round trips and invalid data of the index codec
+//
+// Encodes indices as plain words, runs and bitmaps and decodes them again,
+// including indices above 2^24 (which float32 cannot hold exactly) and
+// uint64 words, and checks that index files whose data does not match
+// their header are rejected with std::runtime_error. Run through ctest,
+// exits with 1 on failure.
+
+#include "ConversionKernels.h"
+#include "IndexCodec.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int numberOfFailures = 0;
+
+void check(bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::fprintf(stderr, "FAILED: %s\n", description.c_str());
+    numberOfFailures++;
+}
+
+template <typename Exception>
+void checkThrows(const std::function<void()>& function, const std::string& description)
+{
+    try
+    {
+        function();
+    }
+    catch (const Exception&)
+    {
+        return;
+    }
+    catch (const std::exception& e)
+    {
+        check(false, description + " (threw another exception: " + e.what() + ")");
+        return;
+    }
+
+    check(false, description + " (did not throw)");
+}
+
+// Header of an index file that holds the encoded indices
+FileHeader makeHeader(ElementType elementType, std::uint64_t numIndices)
+{
+    FileHeader header;
+    header.flags        = FileFlags::Indices;
+    header.elementType  = elementType;
+    header.byteOrder    = getNativeByteOrder();
+    header.numRows      = numIndices;
+    header.numColumns   = 1;
+
+    return header;
+}
+
+// Decodes into a buffer of exactly header.numRows indices, writes past it are caught by the sanitizers
+std::vector<std::uint32_t> decode(const FileHeader& header, const IndexInfo& indexInfo, const std::vector<char>& bytes)
+{
+    std::vector<std::uint32_t> indices(static_cast<std::size_t>(header.numRows));
+
+    decodeIndices(header, indexInfo, bytes.data(), bytes.size(), indices.data());
+
+    return indices;
+}
+
+template <typename Word>
+std::vector<char> makeWords(const std::vector<Word>& words, bool byteSwapped = false)
+{
+    std::vector<char> bytes(words.size() * sizeof(Word));
+
+    for (std::size_t index = 0; index < words.size(); index++)
+    {
+        const Word word = byteSwapped ? swapBytes(words[index]) : words[index];
+        std::memcpy(bytes.data() + index * sizeof(Word), &word, sizeof(Word));
+    }
+
+    return bytes;
+}
+
+std::vector<std::uint32_t> makeRange(std::uint32_t first, std::uint32_t count, std::uint32_t step = 1)
+{
+    std::vector<std::uint32_t> indices(count);
+
+    for (std::uint32_t index = 0; index < count; index++)
+        indices[index] = first + index * step;
+
+    return indices;
+}
+
+std::vector<std::uint32_t> concatenate(std::vector<std::uint32_t> first, const std::vector<std::uint32_t>& second)
+{
+    first.insert(first.end(), second.begin(), second.end());
+    return first;
+}
+
+const char* getName(IndexEncoding encoding)
+{
+    return getIndexEncodingName(encoding);
+}
+
+// Encodes the indices with the given encoding, or the chosen one, and checks that they decode to themselves
+void testRoundTrip(const std::string& name, const std::vector<std::uint32_t>& indices, std::uint64_t numPoints, std::optional<IndexEncoding> encoding, IndexEncoding expectedEncoding)
+{
+    const std::string description = name + (encoding ? std::string(", forced ") + getName(*encoding) : std::string(", chosen"));
+
+    const EncodedIndices encoded = encodeIndices(indices.data(), indices.size(), numPoints, encoding);
+
+    check(encoded.info.encoding == expectedEncoding, description + ": encoded as " + getName(encoded.info.encoding) + " instead of " + getName(expectedEncoding));
+    check(encoded.numIndices == indices.size(), description + ": number of indices");
+    check(encoded.elementType == (encoded.info.encoding == IndexEncoding::Bitmap ? ElementType::UInt8 : ElementType::UInt32), description + ": word type");
+
+    if (!encoding)
+        check(chooseIndexEncoding(indices.data(), indices.size(), numPoints) == expectedEncoding, description + ": chooseIndexEncoding agrees");
+
+    try
+    {
+        const auto decoded = decode(makeHeader(encoded.elementType, encoded.numIndices), encoded.info, encoded.bytes);
+
+        check(decoded == indices, description + ": decoded indices match");
+    }
+    catch (const std::exception& e)
+    {
+        check(false, description + ": decodes (" + e.what() + ")");
+    }
+}
+
+void testRoundTrips()
+{
+    // Sparse indices above 2^24, which float32 cannot hold exactly
+    const auto sparse = std::vector<std::uint32_t>{ 16777217, 16777219, 20000001, 33554433, 4000000001u };
+
+    testRoundTrip("sparse above 2^24", sparse, 0, std::nullopt, IndexEncoding::Plain);
+    testRoundTrip("sparse above 2^24", sparse, 0, IndexEncoding::Runs, IndexEncoding::Runs);
+
+    // Runs in any order, one of them across 2^24
+    const auto runs = concatenate(makeRange(30000000, 500), makeRange((1u << 24) - 5, 1000));
+
+    testRoundTrip("runs", runs, 0, std::nullopt, IndexEncoding::Runs);
+    testRoundTrip("runs", runs, 0, IndexEncoding::Plain, IndexEncoding::Plain);
+
+    // Every other point of a data set, strictly increasing
+    const auto dense = makeRange(1, 50000, 2);
+
+    testRoundTrip("every other point", dense, 100001, std::nullopt, IndexEncoding::Bitmap);
+    testRoundTrip("every other point", dense, 100001, IndexEncoding::Plain, IndexEncoding::Plain);
+    testRoundTrip("every other point", dense, 100001, IndexEncoding::Runs, IndexEncoding::Runs);
+
+    // A bitmap of a data set beyond 2^24 points
+    const auto denseAbove = makeRange(1u << 24, 50000, 2);
+
+    testRoundTrip("every other point above 2^24", denseAbove, (1u << 24) + 100000, IndexEncoding::Bitmap, IndexEncoding::Bitmap);
+
+    // A bitmap without a known number of points covers all points up to the largest index
+    testRoundTrip("bitmap without points", std::vector<std::uint32_t>{ 0, 7, 8, (1u << 24) + 3 }, 0, IndexEncoding::Bitmap, IndexEncoding::Bitmap);
+
+    testRoundTrip("empty", {}, 0, std::nullopt, IndexEncoding::Plain);
+    testRoundTrip("empty", {}, 100, IndexEncoding::Bitmap, IndexEncoding::Bitmap);
+    testRoundTrip("single", std::vector<std::uint32_t>{ 4294967295u }, 0, std::nullopt, IndexEncoding::Plain);
+}
+
+void testWords()
+{
+    // Indices that do not fit 32 bits are stored as uint64 words, which the 32 bit destination cannot take
+    const std::vector<std::uint64_t> wide = { 5, (std::uint64_t(1) << 32) + 5 };
+
+    const EncodedIndices encoded = encodeIndices(wide.data(), wide.size(), 0);
+
+    check(encoded.elementType == ElementType::UInt64, "indices above 32 bits are stored as uint64 words");
+    check(encoded.bytes == makeWords<std::uint64_t>(wide), "uint64 words hold the indices");
+
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(encoded.elementType, encoded.numIndices), encoded.info, encoded.bytes); }, "an index above 32 bits is rejected");
+
+    // uint64 words of indices that do fit, as other writers may store them
+    const std::vector<std::uint64_t> plainWords = { 5, (1u << 24) + 1, 7 };
+
+    IndexInfo plainInfo;
+    plainInfo.encoding = IndexEncoding::Plain;
+
+    check(decode(makeHeader(ElementType::UInt64, 3), plainInfo, makeWords(plainWords)) == std::vector<std::uint32_t>{ 5, (1u << 24) + 1, 7 }, "plain uint64 words decode");
+
+    IndexInfo runsInfo;
+    runsInfo.encoding = IndexEncoding::Runs;
+
+    check(decode(makeHeader(ElementType::UInt64, 5), runsInfo, makeWords<std::uint64_t>({ 100, 3, 1u << 30, 2 })) == std::vector<std::uint32_t>{ 100, 101, 102, 1u << 30, (1u << 30) + 1 }, "uint64 runs decode");
+
+    // Words in the other byte order are swapped
+    FileHeader swappedHeader = makeHeader(ElementType::UInt32, 2);
+    swappedHeader.byteOrder = getNativeByteOrder() == ByteOrder::LittleEndian ? ByteOrder::BigEndian : ByteOrder::LittleEndian;
+
+    check(decode(swappedHeader, plainInfo, makeWords<std::uint32_t>({ 1, (1u << 24) + 9 }, true)) == std::vector<std::uint32_t>{ 1, (1u << 24) + 9 }, "byte-swapped words decode");
+}
+
+void testInvalidData()
+{
+    // Bitmaps cannot keep an order, nor duplicates
+    const std::vector<std::uint32_t> decreasing = { 5, 3, 9 };
+    const std::vector<std::uint32_t> duplicates = { 3, 3 };
+
+    checkThrows<std::invalid_argument>([&] { encodeIndices(decreasing.data(), decreasing.size(), 10, IndexEncoding::Bitmap); }, "a bitmap of decreasing indices is rejected");
+    checkThrows<std::invalid_argument>([&] { encodeIndices(duplicates.data(), duplicates.size(), 10, IndexEncoding::Bitmap); }, "a bitmap of repeated indices is rejected");
+
+    const auto indices = makeRange(2, 10);
+
+    const EncodedIndices plain  = encodeIndices(indices.data(), indices.size(), 20, IndexEncoding::Plain);
+    const EncodedIndices runs   = encodeIndices(indices.data(), indices.size(), 20, IndexEncoding::Runs);
+    const EncodedIndices bitmap = encodeIndices(indices.data(), indices.size(), 20, IndexEncoding::Bitmap);
+
+    // More indices than the header specifies, fewer, and plain data of another size
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(runs.elementType, 5), runs.info, runs.bytes); }, "runs of more indices than the header are rejected");
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(bitmap.elementType, 5), bitmap.info, bitmap.bytes); }, "a bitmap of more indices than the header is rejected");
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(runs.elementType, 11), runs.info, runs.bytes); }, "runs of fewer indices than the header are rejected");
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(plain.elementType, 9), plain.info, plain.bytes); }, "plain data of more indices than the header is rejected");
+
+    // Indices that are not below the number of points
+    IndexInfo fewPoints = plain.info;
+    fewPoints.numPoints = 11;
+
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(plain.elementType, 10), fewPoints, plain.bytes); }, "a plain index beyond the points is rejected");
+
+    fewPoints.encoding = IndexEncoding::Runs;
+
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(runs.elementType, 10), fewPoints, runs.bytes); }, "a run beyond the points is rejected");
+
+    // A run without its length
+    const std::vector<char> truncatedRuns(runs.bytes.begin(), runs.bytes.end() - sizeof(std::uint32_t));
+
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(runs.elementType, 10), runs.info, truncatedRuns); }, "a truncated run pair is rejected");
+
+    // Bitmaps of another number of points
+    std::vector<char> shortBitmap(bitmap.bytes.begin(), bitmap.bytes.end() - 1);
+    std::vector<char> longBitmap(bitmap.bytes);
+    longBitmap.push_back(0);
+
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(bitmap.elementType, 10), bitmap.info, shortBitmap); }, "a bitmap that is too small is rejected");
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(bitmap.elementType, 10), bitmap.info, longBitmap); }, "a bitmap that is too large is rejected");
+
+    // Words of other element types
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(ElementType::Float32, 10), plain.info, plain.bytes); }, "indices of another element type are rejected");
+    checkThrows<std::runtime_error>([&] { decode(makeHeader(ElementType::UInt32, 10), bitmap.info, bitmap.bytes); }, "a bitmap of another element type is rejected");
+}
+
+}
+
+int main()
+{
+    try
+    {
+        testRoundTrips();
+        testWords();
+        testInvalidData();
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "binio_index_test: %s\n", e.what());
+        return 1;
+    }
+
+    if (numberOfFailures > 0)
+    {
+        std::fprintf(stderr, "binio_index_test: %d checks failed\n", numberOfFailures);
+        return 1;
+    }
+
+    std::printf("binio_index_test: all checks passed\n");
+
+    return 0;
+}
@@ -1,167 +1,1497 @@
 #include "BinLoader.h"
 
+#include "ChunkedLoader.h"
+#include "ConversionKernels.h"
+#include "ElementTypeDispatch.h"
+#include "IndexCodec.h"
+#include "Instrumentation.h"
+#include "Statistics.h"
+
 #include <PointData/PointData.h>
 
-#include <Set.h>
+#include <Set.h>
+#include <Task.h>
+
+#include <QtCore>
+#include <QtDebug>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+Q_PLUGIN_METADATA(IID "nl.tudelft.BinLoader")
+
+using namespace mv;
+using namespace mv::gui;
+
+// =============================================================================
+// View
+// =============================================================================
+
+BinLoader::~BinLoader(void)
+{
+
+}
+
+void BinLoader::init()
+{
+
+}
+
+namespace {
+
+// The conversion kernels read and write bfloat16 values through their raw bits
+template <typename S>
+using KernelElementType = std::conditional_t<std::is_same_v<S, biovault::bfloat16_t>, BFloat16, S>;
+
+static_assert(sizeof(biovault::bfloat16_t) == sizeof(BFloat16), "bfloat16 storage must match the kernel layout");
+
+// Location and storage of the data in the file
+struct DataRegion
+{
+    std::uint64_t                                   offset  = 0;    // Offset in bytes of the data
+    std::uint64_t                                   size    = 0;    // Size in bytes of the (encoded) data
+    std::uint64_t                                   numRows = 0;    // Number of points in the file
+    Layout                                          layout  = Layout::RowMajor;
+    std::optional<BlockIndex>                       blockIndex;     // Blocks of block-compressed data
+    std::optional<QuantizationTable>                quantization;   // Scale and offset of every dimension of quantized data
+    std::optional<std::vector<ColumnStatistics>>    statistics;     // Statistics of every dimension of the stored values
+    std::optional<BlockChecksums>                   checksums;      // Checksums of the blocks, dropped when they are not verified
+};
+
+// File whose points are loaded into a slice of a data set
+struct LoadPart
+{
+    QString                     fileName;
+    ElementType                 elementType     = ElementType::Float32;     // Element type in the file
+    ByteOrder                   byteOrder       = ByteOrder::LittleEndian;  // Byte order of the data in the file
+    std::unique_ptr<FileReader> reader;
+    DataRegion                  dataRegion;
+    RowSelection                rows;                                       // Points of the file to load
+    std::uint64_t               firstOutputRow  = 0;                        // Point of the data set that the first loaded point becomes
+};
+
+// Data set that the points of one or more files are loaded into, in the order of the files
+struct LoadTarget
+{
+    QString                 name;           // Shown in the task and the log
+    Dataset<Points>         pointData;      // Only used on the GUI thread
+    std::vector<LoadPart>   parts;
+    std::uint64_t           numRows = 0;    // Number of loaded points over all parts
+};
+
+// Adds the loaded points to their data set and returns the number of bytes handed over, called on the GUI thread
+using AddToCore = std::function<std::uint64_t(Dataset<Points>&)>;
+
+// Points of a data set, which the workers fill before they are added to the data set
+struct PointBuffer
+{
+    void*       data = nullptr;     // Elements of the storage type of the data set
+    AddToCore   addToCore;
+};
+
+// Allocates all points of a data set of element type S at once; the parts load straight into their slices,
+// so concatenated files are neither grown nor copied
+template <typename S>
+PointBuffer makePointBuffer(std::size_t numPoints, std::size_t numDims, const std::vector<QString>& dimensionNames)
+{
+    auto data = std::make_shared<std::vector<S>>(numPoints * numDims);
+
+    PointBuffer pointBuffer;
+
+    pointBuffer.data        = data->data();
+    pointBuffer.addToCore   = [data, numDims, dimensionNames](Dataset<Points>& points) -> std::uint64_t {
+        const std::uint64_t numBytes = data->size() * sizeof(S);
+
+        points->setData(std::move(*data), numDims);
+
+        if (!dimensionNames.empty())
+            points->setDimensionNames(dimensionNames);
+
+        return numBytes;
+    };
+
+    return pointBuffer;
+}
+
+using MakePointBuffer = PointBuffer (*)(std::size_t, std::size_t, const std::vector<QString>&);
+
+template <unsigned... StorageIndices>
+constexpr auto makePointBufferTable(std::integer_sequence<unsigned, StorageIndices...>)
+{
+    return std::array<MakePointBuffer, sizeof...(StorageIndices)>{ &makePointBuffer<PointData::ElementTypeAt<StorageIndices>>... };
+}
+
+// Point buffers of all storage types, indexed by the index of the storage type in PointData
+constexpr auto pointBufferFunctions = makePointBufferTable(std::make_integer_sequence<unsigned, PointData::getNumberOfSupportedElementTypes()>());
+
+// Whether the checksums of a file are verified while its points are loaded: compressed blocks are always read whole,
+// uncompressed data only when whole rows of a row-major file are loaded
+bool isVerified(const LoadPart& part, const std::vector<std::uint32_t>& columns)
+{
+    const DataRegion& dataRegion = part.dataRegion;
+
+    if (!dataRegion.checksums)
+        return false;
+
+    return dataRegion.blockIndex || (dataRegion.layout == Layout::RowMajor && columns.empty() && part.rows.isContiguous());
+}
+
+// Reads the points of a file with kernel element type Source into its slice of a data set of element type S
+template <typename Source, typename S>
+void readPart(const LoadPart& part, std::int32_t numDims, const std::vector<std::uint32_t>& columns, const FileReader& reader, const ChunkedLoadSettings& settings, void* data)
+{
+    const RowSelection& rows            = part.rows;
+    const DataRegion& dataRegion        = part.dataRegion;
+    const std::size_t numOutputPoints   = static_cast<std::size_t>(rows.size());
+    const std::size_t numOutputDims     = columns.empty() ? static_cast<std::size_t>(numDims) : columns.size();
+
+    // Worker threads read and convert row-aligned chunks into disjoint slices of the data set,
+    // matching types are read straight into it. At most settings.bufferSize raw bytes are held in memory at any time,
+    // unless a single row or checksum block is larger than that.
+    auto* const destination = static_cast<KernelElementType<S>*>(data) + part.firstOutputRow * numOutputDims;
+
+    // Quantized codes are dequantized while they are converted, with the scales and offsets of this file
+    ChunkedLoadSettings partSettings = settings;
+
+    if (dataRegion.quantization)
+        partSettings.quantization = &*dataRegion.quantization;
+
+    // Blocks are verified by the loads that read them whole, see isVerified
+    if (isVerified(part, columns))
+    {
+        partSettings.checksums      = &*dataRegion.checksums;
+        partSettings.checksumOffset = dataRegion.offset;
+    }
+
+    // Block-compressed data is decompressed block by block, straight into the data set.
+    // Column-major data and selected points or dimensions only read the bytes that are loaded.
+    if (dataRegion.blockIndex)
+        loadBlocksInParallel<Source>(reader, dataRegion.offset, *dataRegion.blockIndex, numDims, rows, columns, destination, partSettings);
+    else if (dataRegion.layout == Layout::ColumnMajor)
+        loadColumnMajorInParallel<Source>(reader, dataRegion.offset, dataRegion.numRows, numDims, rows, columns, destination, partSettings);
+    else if (columns.empty() && rows.isContiguous())
+        loadRowsInParallel<Source>(reader, dataRegion.offset + rows.first * numDims * sizeof(Source), numOutputPoints, numDims, destination, partSettings);
+    else
+        loadSelectionInParallel<Source>(reader, dataRegion.offset, numDims, rows, columns, destination, partSettings);
+}
+
+using ReadFunction = void (*)(const LoadPart&, std::int32_t, const std::vector<std::uint32_t>&, const FileReader&, const ChunkedLoadSettings&, void*);
+
+// Makes the read functions into the PointData element type at StorageIndex
+template <unsigned StorageIndex>
+struct ReadFunctionFactory
+{
+    template <typename Source>
+    static constexpr ReadFunction get() {
+        return &readPart<Source, PointData::ElementTypeAt<StorageIndex>>;
+    }
+};
+
+template <unsigned... StorageIndices>
+constexpr auto makeReadFunctionTable(std::integer_sequence<unsigned, StorageIndices...>)
+{
+    return std::array{ makeFileElementTypeTable<ReadFunctionFactory<StorageIndices>>()... };
+}
+
+// Read functions for all pairs of storage type and file element type (in either byte order),
+// indexed by [index of the storage type in PointData][getFileElementTypeIndex]
+constexpr auto readFunctions = makeReadFunctionTable(std::make_integer_sequence<unsigned, PointData::getNumberOfSupportedElementTypes()>());
+
+// Gets the index of the PointData element type named typeName
+std::optional<std::size_t> getStorageTypeIndex(const QString& typeName)
+{
+    const auto typeNames = PointData::getElementTypeNames();
+
+    for (std::size_t index = 0; index < typeNames.size(); index++)
+        if (typeName == QLatin1String(typeNames[index]))
+            return index;
+
+    return std::nullopt;
+}
+
+// Everything the worker threads need to read the points of the files
+struct LoadJob
+{
+    QString                     storeAs;                                    // Element type of the data sets
+    std::size_t                 storeAsIndex    = 0;                        // Index of the element type of the data sets in PointData
+    std::int32_t                numDims         = 0;                        // Number of dimensions in every file
+    std::vector<std::uint32_t>  columns;                                    // Dimensions to load in output order, empty loads all
+    ReadMethod                  readMethod      = ReadMethod::MemoryMap;
+    std::vector<LoadTarget>     targets;
+    ChunkedLoadSettings         settings;                                   // Threads and buffer of the whole load
+    bool                        verifyChecksums = true;                     // Whether the checksums of the files are verified
+    PhaseMeasurement            open;                                       // Reading the headers, opening the files and reading the block indices
+};
+
+std::filesystem::path toPath(const QString& fileName)
+{
+    return std::filesystem::path(fileName.toStdU16String());
+}
+
+// Appends the record of a load to the metrics file and the log
+void writeMetrics(const OperationRecord& record)
+{
+    const std::string line = record.toJsonLine();
+
+    qDebug().noquote() << "BinLoader:" << QString::fromStdString(line);
+
+    const auto metricsFilePath = getMetricsFilePath(toPath(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/BinIO/metrics.jsonl"));
+
+    if (metricsFilePath.empty())
+        return;
+
+    try
+    {
+        appendLine(metricsFilePath, line);
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "BinLoader: Could not write the metrics:" << e.what();
+    }
+}
+
+// Describes the statistics of every dimension as a property of a data set: lists of the count, minimum, maximum,
+// mean and variance of the dimensions, and whether they were read from the files or computed while loading
+QVariantMap getStatisticsProperty(const std::vector<ColumnStatistics>& statistics, bool isFileStatistics)
+{
+    QVariantList counts, minimums, maximums, means, variances;
+
+    for (const ColumnStatistics& columnStatistics : statistics)
+    {
+        counts.append(static_cast<qulonglong>(columnStatistics.count));
+        minimums.append(columnStatistics.min);
+        maximums.append(columnStatistics.max);
+        means.append(columnStatistics.mean);
+        variances.append(columnStatistics.variance);
+    }
+
+    QVariantMap property;
+
+    property["count"]       = counts;
+    property["min"]         = minimums;
+    property["max"]         = maximums;
+    property["mean"]        = means;
+    property["variance"]    = variances;
+    property["source"]      = isFileStatistics ? "file" : "computed";
+
+    return property;
+}
+
+/**
+ * Load that reads one or more files on worker threads
+ *
+ * Files are read concurrently, each with its share of the threads and the
+ * buffer, into the data sets of their targets. The task of every data set
+ * shows its progress and aborting it cancels the load of that data set. Once
+ * the workers are done, the points are added to the data sets on the GUI
+ * thread; the data set of a failed or cancelled target is removed. Removing
+ * a data set while it loads cancels its load. The load deletes itself when it
+ * is finished, after it wrote the record of its phases to the metrics.
+ */
+class BackgroundLoad : public QObject
+{
+public:
+    explicit BackgroundLoad(LoadJob job) :
+        _job(std::move(job)),
+        _record("load")
+    {
+        std::uint64_t numFileBytes = 0, numPoints = 0;
+
+        for (std::size_t targetIndex = 0; targetIndex < _job.targets.size(); targetIndex++)
+        {
+            _targetStates.push_back(std::make_unique<TargetState>([this, targetIndex](std::uint64_t bytesRead, std::uint64_t rowsLoaded) { reportProgress(targetIndex, bytesRead, rowsLoaded); }));
+
+            for (std::size_t partIndex = 0; partIndex < _job.targets[targetIndex].parts.size(); partIndex++)
+            {
+                const LoadPart& part = _job.targets[targetIndex].parts[partIndex];
+
+                _parts.emplace_back(targetIndex, partIndex);
+                _readers.push_back(std::make_unique<TimedFileReader>(*part.reader));
+
+                numFileBytes += part.reader->size();
+            }
+
+            numPoints += _job.targets[targetIndex].numRows;
+        }
+
+        // Files of a load may differ in element type, byte order and layout; the record describes the first
+        const LoadPart& firstPart = _job.targets.front().parts.front();
+
+        _record.setField("file", firstPart.fileName.toStdString());
+        _record.setField("files", static_cast<std::uint64_t>(_parts.size()));
+        _record.setField("datasets", static_cast<std::uint64_t>(_job.targets.size()));
+        _record.setField("file_bytes", numFileBytes);
+        _record.setField("element_type", getElementTypeName(firstPart.elementType));
+        _record.setField("byte_order", firstPart.byteOrder == ByteOrder::BigEndian ? "big-endian" : "little-endian");
+        _record.setField("store_as", _job.storeAs.toStdString());
+        _record.setField("layout", firstPart.dataRegion.layout == Layout::ColumnMajor ? "column-major" : "row-major");
+        _record.setField("compressed", firstPart.dataRegion.blockIndex ? "lz" : "none");
+        _record.setField("quantized", firstPart.dataRegion.quantization ? "yes" : "no");
+        _record.setField("statistics", getFileStatistics(_job.targets.front()) ? "file" : "computed");
+        _record.setField("checksums", getChecksumsState(firstPart));
+        _record.setField("read_method", getReadMethodName(_job.readMethod));
+        _record.setField("points", numPoints);
+        _record.setField("dimensions", static_cast<std::uint64_t>(getNumberOfOutputDimensions()));
+        _record.setField("buffer_bytes", static_cast<std::uint64_t>(_job.settings.bufferSize));
+        _record.setField("kernels", getSimdLevelName(getSimdLevel()));
+        _record.addPhase(_job.open);
+    }
+
+    // Starts the worker thread, called on the GUI thread
+    void start()
+    {
+        for (std::size_t targetIndex = 0; targetIndex < _job.targets.size(); targetIndex++)
+        {
+            auto& task = _job.targets[targetIndex].pointData->getTask();
+
+            task.setName(QString("Loading %1").arg(_job.targets[targetIndex].name));
+            task.setMayKill(true);
+            task.setRunning();
+
+            // The workers of the data set stop at their next chunk
+            connect(&task, &Task::requestAbort, this, [this, targetIndex]() -> void {
+                _targetStates[targetIndex]->progress.cancel();
+            });
+
+            // So do those of a data set that is removed while it loads, whose points are dropped
+            connect(&_job.targets[targetIndex].pointData, &Dataset<Points>::aboutToBeRemoved, this, [this, targetIndex]() -> void {
+                _targetStates[targetIndex]->progress.cancel();
+            });
+        }
+
+        QThread* const thread = QThread::create([this]() -> void { run(); });
+
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+        thread->start();
+    }
+
+private:
+    // Progress and outcome of loading one target
+    struct TargetState
+    {
+        explicit TargetState(LoadProgress::Callback callback) : progress(std::move(callback)) { }
+
+        LoadProgress                            progress;                   // Shared by the parts of the target
+        std::atomic<int>                        reportedPercentage = -1;    // Last percentage that was posted to the task
+        PointBuffer                             pointBuffer;
+        QString                                 error;                      // First error of the parts, guarded by _errorMutex
+        std::unique_ptr<StatisticsCollector>    collector;                  // Gathers the statistics while the parts convert, unless the files hold them
+        std::vector<ColumnStatistics>           statistics;                 // Statistics of every dimension of the loaded points
+        bool                                    isFileStatistics = false;   // Whether the statistics are those of the files
+    };
+
+    std::size_t getNumberOfOutputDimensions() const {
+        return _job.columns.empty() ? static_cast<std::size_t>(_job.numDims) : _job.columns.size();
+    }
+
+    // Describes whether the checksums of a file are verified, for the record
+    const char* getChecksumsState(const LoadPart& part) const {
+        if (isVerified(part, _job.columns))
+            return "verified";
+
+        if (!_job.verifyChecksums)
+            return "skipped";
+
+        return part.dataRegion.checksums ? "unverified" : "none";
+    }
+
+    // Gets the statistics of the files of a target when they describe exactly the loaded points:
+    // all points and dimensions of every file are loaded, and stored unconverted
+    std::optional<std::vector<ColumnStatistics>> getFileStatistics(const LoadTarget& target) const
+    {
+        if (!_job.columns.empty())
+            return std::nullopt;
+
+        std::vector<ColumnStatistics> statistics(getNumberOfOutputDimensions());
+
+        for (const LoadPart& part : target.parts)
+        {
+            const RowSelection& rows        = part.rows;
+            const DataRegion& dataRegion    = part.dataRegion;
+
+            if (!dataRegion.statistics || dataRegion.statistics->size() != statistics.size() || dataRegion.quantization)
+                return std::nullopt;
+
+            if (!rows.isContiguous() || rows.first != 0 || rows.size() != dataRegion.numRows)
+                return std::nullopt;
+
+            if (_job.storeAs != QLatin1String(getElementTypeName(part.elementType)))
+                return std::nullopt;
+
+            for (std::size_t column = 0; column < statistics.size(); column++)
+                statistics[column] = mergeColumnStatistics(statistics[column], (*dataRegion.statistics)[column]);
+        }
+
+        return statistics;
+    }
+
+    // Reads the files, called on the worker thread
+    void run()
+    {
+        const Stopwatch stopwatch;
+
+        // Name projected dimensions after their index in the file
+        std::vector<QString> dimensionNames;
+        for (const auto column : _job.columns)
+            dimensionNames.push_back(QString("Dim %1").arg(column));
+
+        for (std::size_t targetIndex = 0; targetIndex < _job.targets.size(); targetIndex++)
+        {
+            TargetState& state = *_targetStates[targetIndex];
+
+            try
+            {
+                state.pointBuffer = pointBufferFunctions[_job.storeAsIndex](static_cast<std::size_t>(_job.targets[targetIndex].numRows), getNumberOfOutputDimensions(), dimensionNames);
+            }
+            catch (const std::exception& e)
+            {
+                setError(targetIndex, e.what());
+            }
+
+            // Statistics that the files do not hold are gathered while the points are converted
+            if (auto fileStatistics = getFileStatistics(_job.targets[targetIndex]))
+            {
+                state.statistics        = std::move(*fileStatistics);
+                state.isFileStatistics  = true;
+            }
+            else
+            {
+                state.collector = std::make_unique<StatisticsCollector>(getNumberOfOutputDimensions());
+            }
+        }
+
+        // Small files alone cannot keep all threads busy, so files are read concurrently,
+        // each with an equal share of the threads and of the buffer
+        const std::size_t numberOfThreads   = resolveNumberOfThreads(_job.settings.numberOfThreads);
+        const std::size_t numberOfFiles     = std::clamp<std::size_t>(_parts.size(), 1, numberOfThreads);
+
+        ChunkedLoadSettings partSettings = _job.settings;
+
+        partSettings.numberOfThreads    = std::max<std::size_t>(1, numberOfThreads / numberOfFiles);
+        partSettings.bufferSize         = std::max<std::size_t>(1, _job.settings.bufferSize / numberOfFiles);
+
+        std::vector<PipelineStats> partStats(_parts.size());
+
+        forEachChunkInParallel(_parts.size(), numberOfFiles, [this, &partSettings, &partStats](std::size_t index, std::vector<char>&) -> void {
+            const auto [targetIndex, partIndex] = _parts[index];
+
+            const LoadPart& part    = _job.targets[targetIndex].parts[partIndex];
+            TargetState& state      = *_targetStates[targetIndex];
+
+            if (state.progress.isCancelled())
+                return;
+
+            ChunkedLoadSettings settings = partSettings;
+
+            settings.progress   = &state.progress;
+            settings.stats      = &partStats[index];
+            settings.statistics = state.collector.get();
+
+            try
+            {
+                const ReadFunction readFunction = readFunctions[_job.storeAsIndex][getFileElementTypeIndex(part.elementType, part.byteOrder)];
+
+                readFunction(part, _job.numDims, _job.columns, *_readers[index], settings, state.pointBuffer.data);
+            }
+            catch (const LoadCancelled&)
+            {
+            }
+            catch (const std::exception& e)
+            {
+                setError(targetIndex, QString("%1: %2").arg(QFileInfo(part.fileName).fileName(), QString(e.what())));
+            }
+        });
+
+        for (const auto& state : _targetStates)
+            if (state->collector)
+                state->statistics = state->collector->getStatistics();
+
+        addReadPhases(stopwatch.getSeconds(), partStats, numberOfFiles);
+
+        QMetaObject::invokeMethod(this, [this]() -> void { finish(); }, Qt::QueuedConnection);
+    }
+
+    // Fails a target and stops its other parts, called on the worker threads
+    void setError(std::size_t targetIndex, const QString& message)
+    {
+        TargetState& state = *_targetStates[targetIndex];
+
+        {
+            const std::lock_guard<std::mutex> lock(_errorMutex);
+
+            if (state.error.isEmpty())
+                state.error = message;
+        }
+
+        state.progress.cancel();
+    }
+
+    // Records reading and converting, which the workers do chunk by chunk, called on the worker thread.
+    // The wall-clock time is split by the share of the workers' time that was spent in positional reads;
+    // reading memory-mapped bytes happens on page faults while converting and counts as converting.
+    void addReadPhases(double seconds, const std::vector<PipelineStats>& partStats, std::size_t numberOfFiles)
+    {
+        double readSeconds = 0, produceSeconds = 0;
+        std::uint64_t numBytes = 0, bufferBytes = 0;
+        std::size_t numberOfThreads = 0;
+
+        for (std::size_t index = 0; index < _parts.size(); index++)
+        {
+            readSeconds     += _readers[index]->getReadSeconds();
+            numBytes        += _readers[index]->getBytes();
+            produceSeconds  += partStats[index].produceSeconds;
+            bufferBytes     = std::max<std::uint64_t>(bufferBytes, partStats[index].bufferBytes);
+            numberOfThreads = std::max(numberOfThreads, partStats[index].numberOfThreads);
+        }
+
+        const double readShare = produceSeconds > 0 ? std::min(1.0, readSeconds / produceSeconds) : 0.0;
+
+        // At most numberOfFiles files are read at once
+        PhaseMeasurement read;
+        read.name               = "read";
+        read.seconds            = seconds * readShare;
+        read.bytes              = numBytes;
+        read.numberOfThreads    = std::max<std::size_t>(1, numberOfThreads * numberOfFiles);
+        read.peakTransientBytes = bufferBytes * numberOfFiles;
+
+        PhaseMeasurement convert = read;
+        convert.name            = "convert";
+        convert.seconds         = seconds - read.seconds;
+
+        _record.addPhase(read);
+        _record.addPhase(convert);
+    }
+
+    // Posts the progress of a target to its task whenever another percent of its points is loaded, called on the worker threads
+    void reportProgress(std::size_t targetIndex, std::uint64_t bytesRead, std::uint64_t rowsLoaded)
+    {
+        TargetState& state          = *_targetStates[targetIndex];
+        const std::uint64_t numRows = std::max<std::uint64_t>(1, _job.targets[targetIndex].numRows);
+        const int percentage        = static_cast<int>(std::min<std::uint64_t>(100, 100 * rowsLoaded / numRows));
+
+        int reportedPercentage = state.reportedPercentage.load();
+
+        while (percentage > reportedPercentage)
+        {
+            if (state.reportedPercentage.compare_exchange_weak(reportedPercentage, percentage))
+            {
+                QMetaObject::invokeMethod(this, [this, targetIndex, percentage, bytesRead, rowsLoaded, numRows]() -> void {
+                    const Dataset<Points>& pointData = _job.targets[targetIndex].pointData;
+
+                    // The task went with the data set when it was removed
+                    if (!pointData.isValid())
+                        return;
+
+                    auto& task = pointData->getTask();
+
+                    task.setProgress(static_cast<float>(percentage) / 100.0f);
+                    task.setProgressDescription(QString("Loaded %1 of %2 points (%3 MB read)").arg(rowsLoaded).arg(numRows).arg(static_cast<double>(bytesRead) / 1.0e6, 0, 'f', 1));
+                }, Qt::QueuedConnection);
+
+                break;
+            }
+        }
+    }
+
+    // Adds the points to the data sets and removes the data sets of failed or cancelled targets, called on the GUI thread
+    void finish()
+    {
+        const Stopwatch stopwatch;
+
+        // The loaded points are held twice while the core takes them over
+        PhaseMeasurement handOff;
+        handOff.name = "hand-off";
+
+        std::size_t numberOfFailed = 0, numberOfCancelled = 0;
+
+        for (std::size_t targetIndex = 0; targetIndex < _job.targets.size(); targetIndex++)
+        {
+            LoadTarget& target  = _job.targets[targetIndex];
+            TargetState& state  = *_targetStates[targetIndex];
+
+            // Removing the data set cancelled its load, there is nothing left to add the points to
+            if (!target.pointData.isValid())
+            {
+                qDebug() << "BinLoader: Loading" << target.name << "was cancelled, its data set was removed";
+                numberOfCancelled++;
+                continue;
+            }
+
+            if (!state.error.isEmpty() || state.progress.isCancelled())
+            {
+                if (state.error.isEmpty())
+                {
+                    qDebug() << "BinLoader: Loading" << target.name << "was cancelled";
+                    numberOfCancelled++;
+                }
+                else
+                {
+                    qCritical() << "BinLoader: Could not load" << target.name << ":" << state.error;
+
+                    if (numberOfFailed++ == 0)
+                        _record.setField("error", state.error.toStdString());
+                }
+
+                target.pointData->getTask().setAborted();
+
+                mv::data().removeDataset(target.pointData);
+
+                continue;
+            }
+
+            const std::uint64_t numBytes = state.pointBuffer.addToCore(target.pointData);
+
+            handOff.bytes               += numBytes;
+            handOff.peakTransientBytes  = std::max(handOff.peakTransientBytes, numBytes);
+
+            target.pointData->setProperty("DimensionStatistics", getStatisticsProperty(state.statistics, state.isFileStatistics));
+
+            events().notifyDatasetDataChanged(target.pointData);
+
+            target.pointData->getTask().setFinished();
+
+            qDebug() << "Number of dimensions: " << target.pointData->getNumDimensions();
+            qDebug() << "BIN file loaded. Num data points: " << target.pointData->getNumPoints();
+        }
+
+        handOff.seconds = stopwatch.getSeconds();
+
+        _record.addPhase(handOff);
+        _record.setField("status", numberOfFailed > 0 ? "failed" : (numberOfCancelled > 0 ? "cancelled" : "ok"));
+        _record.setSeconds(_job.open.seconds + _stopwatch.getSeconds());
+
+        writeMetrics(_record);
+
+        deleteLater();
+    }
+
+    LoadJob                                             _job;
+    std::vector<std::unique_ptr<TargetState>>           _targetStates;  // One per target
+    std::vector<std::pair<std::size_t, std::size_t>>    _parts;         // Target and part index of all parts, in file order
+    std::vector<std::unique_ptr<TimedFileReader>>       _readers;       // Measures the reads of every part
+    std::mutex                                          _errorMutex;
+    OperationRecord                                     _record;        // Phases of the load, written to the metrics when it is done
+    Stopwatch                                           _stopwatch;     // Started with the load
+};
+
+// Whether the element type is one of the storage types of PointData, which can be loaded without conversion
+bool isPointDataElementType(ElementType elementType)
+{
+    for (const char* const typeName : PointData::getElementTypeNames())
+        if (QString::fromLatin1(typeName) == QString::fromLatin1(getElementTypeName(elementType)))
+            return true;
+
+    return false;
+}
+
+// Reads and validates the header of a v2 file, legacy raw files have none
+std::optional<FileHeader> readFileHeader(const QString& fileName)
+{
+    const auto reader = openFileReader(toPath(fileName), ReadMethod::PositionalRead);
+
+    std::vector<char> bytes(static_cast<std::size_t>(std::min<std::uint64_t>(reader->size(), FileHeader::headerSize)));
+    reader->read(0, bytes.size(), bytes.data());
+
+    if (!hasFileHeader(bytes.data(), bytes.size()))
+        return std::nullopt;
+
+    const auto fileHeader = parseFileHeader(bytes.data(), bytes.size());
+
+    validateFileSize(fileHeader, reader->size());
+
+    if (fileHeader.layout != Layout::RowMajor && (fileHeader.flags & FileFlags::BlockCompressed))
+        throw std::runtime_error("Loading block-compressed column-major data is not supported.");
+
+    return fileHeader;
+}
+
+// Whether columns selects all numColumns columns in file order
+bool isAllColumns(const std::vector<std::uint32_t>& columns, std::size_t numColumns)
+{
+    if (columns.size() != numColumns)
+        return false;
+
+    for (std::size_t column = 0; column < numColumns; column++)
+        if (columns[column] != column)
+            return false;
+
+    return true;
+}
+
+// Reads and validates the block index of a block-compressed file
+BlockIndex readBlockIndex(const FileReader& reader, const FileHeader& fileHeader)
+{
+    const FileSection* const section = findSection(fileHeader, SectionType::BlockIndex);
+
+    if (section == nullptr)
+        throw std::runtime_error("The file is compressed but has no block index.");
+
+    std::vector<char> bytes(static_cast<std::size_t>(section->size));
+    reader.read(section->offset, bytes.size(), bytes.data());
+
+    return parseBlockIndex(fileHeader, bytes.data(), bytes.size());
+}
+
+// Reads and validates the index info of an index file
+IndexInfo readIndexInfo(const FileReader& reader, const FileHeader& fileHeader)
+{
+    const FileSection* const section = findSection(fileHeader, SectionType::IndexInfo);
+
+    if (section == nullptr)
+        throw std::runtime_error("The index file has no index info.");
+
+    std::vector<char> bytes(static_cast<std::size_t>(section->size));
+    reader.read(section->offset, bytes.size(), bytes.data());
+
+    return parseIndexInfo(bytes.data(), bytes.size());
+}
+
+// Reads and validates the scales and offsets of a quantized file
+QuantizationTable readQuantizationTable(const FileReader& reader, const FileHeader& fileHeader)
+{
+    const FileSection* const section = findSection(fileHeader, SectionType::Quantization);
+
+    if (section == nullptr)
+        throw std::runtime_error("The file is quantized but has no quantization table.");
+
+    std::vector<char> bytes(static_cast<std::size_t>(section->size));
+    reader.read(section->offset, bytes.size(), bytes.data());
+
+    return parseQuantizationTable(fileHeader, bytes.data(), bytes.size());
+}
+
+// Reads and validates the statistics of a file, which are optional
+std::optional<std::vector<ColumnStatistics>> readColumnStatistics(const FileReader& reader, const FileHeader& fileHeader)
+{
+    const FileSection* const section = findSection(fileHeader, SectionType::Statistics);
+
+    if (section == nullptr)
+        return std::nullopt;
+
+    std::vector<char> bytes(static_cast<std::size_t>(section->size));
+    reader.read(section->offset, bytes.size(), bytes.data());
+
+    return parseColumnStatistics(fileHeader, bytes.data(), bytes.size());
+}
+
+// Reads and validates the checksums of a file, which are optional
+std::optional<BlockChecksums> readBlockChecksums(const FileReader& reader, const FileHeader& fileHeader, const std::optional<BlockIndex>& blockIndex)
+{
+    const FileSection* const section = findSection(fileHeader, SectionType::Checksums);
+
+    if (section == nullptr)
+        return std::nullopt;
+
+    std::vector<char> bytes(static_cast<std::size_t>(section->size));
+    reader.read(section->offset, bytes.size(), bytes.data());
+
+    auto checksums = parseBlockChecksums(fileHeader, bytes.data(), bytes.size());
+
+    if (blockIndex && checksums.checksums.size() != blockIndex->getNumberOfBlocks())
+        throw std::runtime_error("The checksums do not match the " + std::to_string(blockIndex->getNumberOfBlocks()) + " blocks of the data.");
+
+    return checksums;
+}
+
+// Opens a file for loading and locates its data; v2 files describe their own contents,
+// legacy files use the element type and byte order of the dialog and are divided into numDims dimensions
+LoadPart openPart(const QString& fileName, ElementType elementType, ByteOrder byteOrder, std::int32_t numDims, ReadMethod readMethod, AccessPattern accessPattern, bool verifyChecksums, std::uint64_t& numHeaderBytes)
+{
+    const auto fileHeader = readFileHeader(fileName);
+
+    if (fileHeader && (fileHeader->flags & FileFlags::Indices))
+        throw std::runtime_error("The file holds point indices instead of point values.");
+
+    if (fileHeader && fileHeader->numColumns != static_cast<std::uint64_t>(numDims))
+        throw std::runtime_error("The file has " + std::to_string(fileHeader->numColumns) + " dimensions instead of " + std::to_string(numDims) + ".");
+
+    LoadPart part;
+
+    part.fileName       = fileName;
+    part.elementType    = fileHeader ? fileHeader->elementType : elementType;
+    part.byteOrder      = fileHeader ? fileHeader->byteOrder : byteOrder;
+    part.reader         = openFileReader(toPath(fileName), readMethod, accessPattern);
+
+    part.dataRegion.offset  = fileHeader ? fileHeader->dataOffset : 0;
+    part.dataRegion.size    = fileHeader ? fileHeader->dataSize : part.reader->size();
+    part.dataRegion.layout  = fileHeader ? fileHeader->layout : Layout::RowMajor;
+
+    numHeaderBytes += std::min<std::uint64_t>(part.reader->size(), FileHeader::headerSize);
+
+    if (fileHeader && (fileHeader->flags & FileFlags::BlockCompressed))
+    {
+        part.dataRegion.blockIndex = readBlockIndex(*part.reader, *fileHeader);
+
+        numHeaderBytes += findSection(*fileHeader, SectionType::BlockIndex)->size;
+    }
+
+    if (fileHeader && (fileHeader->flags & FileFlags::Quantized))
+    {
+        part.dataRegion.quantization = readQuantizationTable(*part.reader, *fileHeader);
+
+        numHeaderBytes += findSection(*fileHeader, SectionType::Quantization)->size;
+    }
+
+    if (fileHeader)
+        part.dataRegion.statistics = readColumnStatistics(*part.reader, *fileHeader);
+
+    if (part.dataRegion.statistics)
+        numHeaderBytes += findSection(*fileHeader, SectionType::Statistics)->size;
+
+    // Checksums that are not verified are not read either
+    if (fileHeader && verifyChecksums)
+        part.dataRegion.checksums = readBlockChecksums(*part.reader, *fileHeader, part.dataRegion.blockIndex);
+
+    if (part.dataRegion.checksums)
+        numHeaderBytes += findSection(*fileHeader, SectionType::Checksums)->size;
+
+    if (fileHeader)
+    {
+        part.dataRegion.numRows = fileHeader->numRows;
+    }
+    else
+    {
+        const std::uint64_t elementSize = getElementSize(part.elementType);
+        const auto numElements          = part.dataRegion.size / elementSize;
+
+        if (part.dataRegion.size % elementSize != 0)
+            qWarning() << "WARNING: BinLoader.cpp::loadData:" << fileName << "File size is not a multiple of the data type size. Trailing bytes are ignored.";
+
+        if (numElements % static_cast<std::uint64_t>(numDims) != 0)
+            qWarning() << "WARNING: BinLoader.cpp::loadData:" << fileName << "Data size divided by number of dimension is not an integer. Something might have gone wrong.";
+
+        part.dataRegion.numRows = numElements / static_cast<std::uint64_t>(numDims);
+    }
+
+    return part;
+}
+
+// Element types of legacy files in the order of the data type options of the dialog,
+// float32 and uint8 come first so that the stored option of earlier versions still applies
+constexpr std::array<ElementType, 10> legacyElementTypes = {
+    ElementType::Float32, ElementType::UInt8, ElementType::Int8, ElementType::Int16, ElementType::UInt16,
+    ElementType::Int32, ElementType::UInt32, ElementType::Float16, ElementType::BFloat16, ElementType::Float64
+};
+
+// Gets the element type named typeName, "float" is the float32 of the descriptions of earlier versions
+std::optional<ElementType> findElementType(const QString& typeName)
+{
+    if (typeName == "float")
+        return ElementType::Float32;
+
+    for (const ElementType elementType : legacyElementTypes)
+        if (typeName == QLatin1String(getElementTypeName(elementType)))
+            return elementType;
+
+    return std::nullopt;
+}
+
+// Description of a raw file, written next to it by the exporter
+struct FileDescription
+{
+    std::optional<ElementType>      elementType;
+    std::optional<ByteOrder>        byteOrder;                  // Unset when the description does not name it
+    std::int32_t                    numDimensions   = 0;        // 0 when the description does not give it
+    std::optional<std::uint64_t>    numPoints;
+};
+
+// Reads the description of a file from the .json file next to it, or else from the .txt file of earlier versions;
+// a file without a description has none, a description that cannot be read throws
+std::optional<FileDescription> readFileDescription(const QString& fileName)
+{
+    const QFileInfo fileInfo(fileName);
+
+    FileDescription description;
+
+    if (QFile file(fileInfo.dir().filePath(fileInfo.completeBaseName() + ".json")); file.open(QIODevice::ReadOnly))
+    {
+        QJsonParseError parseError;
+
+        const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+        if (parseError.error != QJsonParseError::NoError || !document.isObject())
+            throw std::runtime_error("The description " + file.fileName().toStdString() + " is not a JSON object: " + parseError.errorString().toStdString());
+
+        const QJsonObject info = document.object();
+
+        if (info.contains("elementType"))
+        {
+            description.elementType = findElementType(info.value("elementType").toString());
+
+            if (!description.elementType)
+                throw std::runtime_error("The description " + file.fileName().toStdString() + " names the unknown data type " + info.value("elementType").toString().toStdString() + ".");
+        }
+
+        if (info.contains("byteOrder"))
+            description.byteOrder = info.value("byteOrder").toString() == "big-endian" ? ByteOrder::BigEndian : ByteOrder::LittleEndian;
+
+        description.numDimensions = info.value("numDimensions").toInt();
+
+        if (info.contains("numPoints"))
+            description.numPoints = static_cast<std::uint64_t>(info.value("numPoints").toInteger());
+
+        return description;
+    }
+
+    QFile file(fileInfo.dir().filePath(fileInfo.completeBaseName() + ".txt"));
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return std::nullopt;
+
+    // The text only holds data written on this machine's byte order, lines of the source data are ignored
+    description.byteOrder = getNativeByteOrder();
+
+    for (const QString& line : QString::fromUtf8(file.readAll()).split('\n'))
+    {
+        const QString value = line.section(':', 1).trimmed();
+
+        if (line.startsWith("Num dimensions:"))
+            description.numDimensions = value.toInt();
+        else if (line.startsWith("Num data points:"))
+            description.numPoints = value.toULongLong();
+        else if (line.startsWith("Data type:"))
+            description.elementType = findElementType(value);
+    }
+
+    return description;
+}
+
+// Gets the default storage type of data of the given element type: the data is stored as it is in the file so that
+// it is loaded without conversion, types that PointData cannot store and the codes of quantized files as float32
+QString getDefaultStoreAs(ElementType elementType, bool isQuantized)
+{
+    return QString::fromLatin1(getElementTypeName(isPointDataElementType(elementType) && !isQuantized ? elementType : ElementType::Float32));
+}
+
+// Number of points and dimensions in the preview of the dialog
+constexpr std::size_t previewRows      = 5;
+constexpr std::size_t previewColumns   = 8;
+
+// Makes the functions that convert values of a file to float for display
+struct ToFloatFactory
+{
+    template <typename Source>
+    static constexpr auto get() {
+        return &convertElements<Source, float>;
+    }
+};
+
+// Conversions to float of all file element types, indexed by getFileElementTypeIndex
+constexpr auto toFloatFunctions = makeFileElementTypeTable<ToFloatFactory>();
 
-#include <QtCore>
-#include <QtDebug>
+// Reads the first previewColumns values of the first previewRows points, row by row;
+// only these values are read, except for block-compressed files which decode their first block.
+// The codes of quantized files are shown as the values they stand for.
+std::vector<float> peekRows(const FileReader& reader, const std::optional<FileHeader>& fileHeader, ElementType elementType, ByteOrder byteOrder, std::uint64_t numRows, std::uint64_t numColumns)
+{
+    const bool isCompressed             = fileHeader && (fileHeader->flags & FileFlags::BlockCompressed);
+    const std::size_t elementSize       = getElementSize(elementType);
+    const std::size_t numPeekColumns    = static_cast<std::size_t>(std::min<std::uint64_t>(numColumns, previewColumns));
+    const std::uint64_t dataOffset      = fileHeader ? fileHeader->dataOffset : 0;
+    const std::uint64_t rowSize         = numColumns * elementSize;
 
-#include <cstdlib>
-#include <fstream>
-#include <type_traits>
-#include <vector>
+    const std::optional<BlockIndex> blockIndex = isCompressed ? std::optional<BlockIndex>(readBlockIndex(reader, *fileHeader)) : std::nullopt;
 
-Q_PLUGIN_METADATA(IID "nl.tudelft.BinLoader")
+    // Compressed files only show the points of their first block
+    const std::uint64_t numBlockRows    = blockIndex ? std::min(numRows, blockIndex->rowsPerBlock) : numRows;
+    const std::size_t numPeekRows       = static_cast<std::size_t>(std::min<std::uint64_t>(numBlockRows, previewRows));
 
-using namespace mv;
-using namespace mv::gui;
+    std::vector<char> bytes(numPeekRows * numPeekColumns * elementSize);
 
-// =============================================================================
-// View
-// =============================================================================
+    if (blockIndex && numPeekRows > 0)
+    {
+        const std::size_t rawSize       = static_cast<std::size_t>(numBlockRows * rowSize);
+        const std::size_t encodedSize   = static_cast<std::size_t>(blockIndex->blockOffsets[1]);
 
-BinLoader::~BinLoader(void)
-{
+        std::vector<char> encoded(encodedSize), decoded(rawSize), scratch(rawSize);
+
+        reader.read(dataOffset, encodedSize, encoded.data());
+        decodeBlock(encoded.data(), encodedSize, decoded.data(), rawSize, elementSize, blockIndex->codec, blockIndex->filter, scratch.data());
+
+        for (std::size_t row = 0; row < numPeekRows; row++)
+            std::copy_n(decoded.data() + row * rowSize, numPeekColumns * elementSize, bytes.data() + row * numPeekColumns * elementSize);
+    }
+    else if (fileHeader && fileHeader->layout == Layout::ColumnMajor)
+    {
+        for (std::size_t row = 0; row < numPeekRows; row++)
+            for (std::size_t column = 0; column < numPeekColumns; column++)
+                reader.read(dataOffset + (column * numRows + row) * elementSize, elementSize, bytes.data() + (row * numPeekColumns + column) * elementSize);
+    }
+    else
+    {
+        for (std::size_t row = 0; row < numPeekRows; row++)
+            reader.read(dataOffset + row * rowSize, numPeekColumns * elementSize, bytes.data() + row * numPeekColumns * elementSize);
+    }
+
+    std::vector<float> values(numPeekRows * numPeekColumns);
+    toFloatFunctions[getFileElementTypeIndex(elementType, byteOrder)](bytes.data(), values.data(), values.size());
+
+    if (fileHeader && (fileHeader->flags & FileFlags::Quantized))
+    {
+        const QuantizationTable quantizationTable = readQuantizationTable(reader, *fileHeader);
 
+        for (std::size_t index = 0; index < values.size(); index++)
+            values[index] = quantizationTable.offsets[index % numPeekColumns] + quantizationTable.scales[index % numPeekColumns] * values[index];
+    }
+
+    return values;
 }
 
-void BinLoader::init()
+// Restores the indices of an index file as a subset of the source data set. Only the indices are read and
+// the subset refers to the points of the source data set, so no point values are read or copied.
+Dataset<Points> loadIndices(const QString& fileName, const FileHeader& fileHeader, const Dataset<Points>& sourcePoints, const QString& datasetName, double headerSeconds)
 {
+    OperationRecord record("load");
 
-}
+    record.setField("file", fileName.toStdString());
+    record.setField("files", static_cast<std::uint64_t>(1));
+    record.setField("datasets", static_cast<std::uint64_t>(1));
+    record.setField("content", "indices");
+    record.setField("element_type", getElementTypeName(fileHeader.elementType));
+    record.setField("read_method", "mmap");
+    record.setField("points", fileHeader.numRows);
 
-namespace {
+    Stopwatch stopwatch;
 
+    PhaseMeasurement open;
+    open.name       = "open";
+    open.bytes      = FileHeader::headerSize;
 
-template <typename T, typename S>
-void readDataAndAddToCore(mv::Dataset<Points>& point_data, int32_t numDims, const std::vector<char>& contents)
-{
+    PhaseMeasurement convert;
+    convert.name    = "convert";
+    convert.bytes   = fileHeader.dataSize;
 
-    // convert binary data to float vector
-    std::vector<S> data;
-    auto add_to_data = [&data](auto val) ->void {
-        auto c = static_cast<S>(val);
-        data.push_back(c);
-    };
+    std::vector<std::uint32_t> indices;
 
-    if constexpr (std::is_same_v<T, float>) {
-        for (size_t i = 0; i < contents.size() / 4; i++)
-        {
-            float f = ((float*)contents.data())[i];
-            add_to_data(f);
-        }
-    }
-    else if constexpr (std::is_same_v<T, unsigned char>)
+    try
     {
-        for (size_t i = 0; i < contents.size(); i++)
+        const auto reader                   = openFileReader(toPath(fileName), ReadMethod::MemoryMap);
+        const IndexInfo indexInfo           = readIndexInfo(*reader, fileHeader);
+        const std::uint64_t numSourcePoints = sourcePoints->getNumRawPoints();
+
+        record.setField("encoding", getIndexEncodingName(indexInfo.encoding));
+
+        if (indexInfo.numPoints != 0 && indexInfo.numPoints != numSourcePoints)
+            throw std::runtime_error("The indices refer to a data set of " + std::to_string(indexInfo.numPoints) + " points instead of " + std::to_string(numSourcePoints) + ".");
+
+        // Indices of an unknown data set are checked against the source data set, bitmaps always know their number of points
+        IndexInfo bounds = indexInfo;
+
+        if (bounds.numPoints == 0 && bounds.encoding != IndexEncoding::Bitmap)
+            bounds.numPoints = numSourcePoints;
+
+        open.seconds = headerSeconds + stopwatch.getSeconds();
+        stopwatch.restart();
+
+        // Memory-mapped indices are decoded in place, the bytes of other readers are copied first
+        const std::size_t dataSize  = static_cast<std::size_t>(fileHeader.dataSize);
+        const char* bytes           = reader->view(fileHeader.dataOffset, dataSize);
+
+        std::vector<char> buffer;
+
+        if (bytes == nullptr)
         {
-            T c = static_cast<T>(contents[i]);
-            add_to_data(c);
+            buffer.resize(dataSize);
+            reader->read(fileHeader.dataOffset, dataSize, buffer.data());
+
+            bytes = buffer.data();
         }
+
+        indices.resize(static_cast<std::size_t>(fileHeader.numRows));
+
+        decodeIndices(fileHeader, bounds, bytes, dataSize, indices.data());
+
+        convert.seconds             = stopwatch.getSeconds();
+        convert.peakTransientBytes  = buffer.size();
     }
-    else
+    catch (const std::exception& e)
     {
-        qWarning() << "BinLoader.cpp::readDataAndAddToCore: No data loaded. Template typename not implemented.";
+        record.setField("status", "failed");
+        record.setField("error", e.what());
+        record.setSeconds(headerSeconds + stopwatch.getSeconds());
+
+        writeMetrics(record);
+
+        throw DataLoadException(fileName, e.what());
     }
 
-    if(std::lldiv(static_cast<long long>(data.size()), static_cast<long long>(numDims)).rem != 0)
-        qWarning() << "WARNING: BinLoader.cpp::readDataAndAddToCore: Data size divided by number of dimension is not an integer. Something might have gone wrong.";
+    stopwatch.restart();
+
+    // The subset is created from a selection of the source data set, whose own selection is restored right away
+    auto selection = sourcePoints->getSelection<Points>();
+
+    selection->indices.swap(indices);
+
+    const auto subset = sourcePoints->createSubsetFromSelection(datasetName, sourcePoints, true);
 
-    // add data to the core
-    point_data->setData(std::move(data), numDims);
-    events().notifyDatasetDataChanged(point_data);
+    selection->indices.swap(indices);
 
-    qDebug() << "Number of dimensions: " << point_data->getNumDimensions();
-    qDebug() << "BIN file loaded. Num data points: " << point_data->getNumPoints();
+    PhaseMeasurement handOff;
+    handOff.name    = "hand-off";
+    handOff.seconds = stopwatch.getSeconds();
+    handOff.bytes   = fileHeader.numRows * sizeof(std::uint32_t);
 
+    record.addPhase(open);
+    record.addPhase(convert);
+    record.addPhase(handOff);
+    record.setField("status", "ok");
+    record.setSeconds(open.seconds + convert.seconds + handOff.seconds);
+
+    writeMetrics(record);
+
+    qDebug() << "BIN index file loaded as subset" << subset->getGuiName() << "of" << sourcePoints->getGuiName() << ". Num data points: " << fileHeader.numRows;
+
+    return subset;
 }
 
-// Recursively searches for the data element type that is specified by the selectedDataElementType parameter. 
-template <typename T, unsigned N = 0>
-void recursiveReadDataAndAddToCore(const QString& selectedDataElementType, mv::Dataset<Points>& point_data, int32_t numDims, const std::vector<char>& contents)
+// Fills in the settings of a load that are not given: v2 files describe their own data type, byte order and number
+// of dimensions, raw files are described by the file next to the first file. Throws when a raw file is not described.
+BinLoadSettings resolveLoadSettings(const QStringList& fileNames, const std::optional<FileHeader>& fileHeader, BinLoadSettings settings)
 {
-    const QLatin1String nthDataElementTypeName(std::get<N>(PointData::getElementTypeNames()));
+    const QString& fileName = fileNames.first();
+
+    if (settings.datasetName.isEmpty())
+        settings.datasetName = fileNames.size() == 1 ? QFileInfo(fileName).baseName() : QFileInfo(fileName).dir().dirName();
 
-    if (selectedDataElementType == nthDataElementTypeName)
+    if (fileHeader)
     {
-        readDataAndAddToCore<T, PointData::ElementTypeAt<N>>(point_data, numDims, contents);
+        if (settings.numDimensions != 0 && static_cast<std::uint64_t>(settings.numDimensions) != fileHeader->numColumns)
+            throw std::runtime_error("The file has " + std::to_string(fileHeader->numColumns) + " dimensions instead of " + std::to_string(settings.numDimensions) + ".");
+
+        settings.elementType    = fileHeader->elementType;
+        settings.byteOrder      = fileHeader->byteOrder;
+        settings.numDimensions  = static_cast<std::int32_t>(fileHeader->numColumns);
     }
-    else
+    else if (!settings.elementType || !settings.byteOrder || settings.numDimensions == 0)
     {
-        recursiveReadDataAndAddToCore<T, N + 1>(selectedDataElementType, point_data, numDims, contents);
+        const auto description  = readFileDescription(fileName);
+        const bool isDescribed  = description && !settings.elementType && settings.numDimensions == 0;
+
+        if (!settings.elementType && description)
+            settings.elementType = description->elementType;
+
+        if (!settings.byteOrder)
+            settings.byteOrder = description && description->byteOrder ? *description->byteOrder : getNativeByteOrder();
+
+        if (settings.numDimensions == 0 && description)
+            settings.numDimensions = description->numDimensions;
+
+        if (!settings.elementType)
+            throw std::runtime_error("The data type of the raw file is neither given nor described next to it.");
+
+        if (settings.numDimensions == 0)
+            throw std::runtime_error("The number of dimensions of the raw file is neither given nor described next to it.");
+
+        // A description that does not fit the file would load garbage, e.g. when the file was replaced
+        if (isDescribed && description->numPoints)
+        {
+            const std::uint64_t describedSize = *description->numPoints * static_cast<std::uint64_t>(settings.numDimensions) * getElementSize(*settings.elementType);
+
+            if (static_cast<std::uint64_t>(QFileInfo(fileName).size()) != describedSize)
+                throw std::runtime_error("The file has " + std::to_string(QFileInfo(fileName).size()) + " bytes instead of the " + std::to_string(describedSize) + " bytes of its description.");
+        }
     }
-}
 
-template <>
-void recursiveReadDataAndAddToCore<float, PointData::getNumberOfSupportedElementTypes()>(const QString&, mv::Dataset<Points>&, int32_t, const std::vector<char>&)
-{
-    // This specialization does nothing, intensionally! 
+    if (settings.numDimensions < 0)
+        throw std::runtime_error("The number of dimensions must be positive.");
+
+    if (settings.storeAs.isEmpty())
+        settings.storeAs = getDefaultStoreAs(*settings.elementType, fileHeader && (fileHeader->flags & FileFlags::Quantized));
+
+    return settings;
 }
 
-template <>
-void recursiveReadDataAndAddToCore<unsigned char, PointData::getNumberOfSupportedElementTypes()>(const QString&, mv::Dataset<Points>&, int32_t, const std::vector<char>&)
+// Opens the files of a load with fully resolved settings and starts reading them in the background, see resolveLoadSettings
+std::vector<Dataset<Points>> startLoad(const QStringList& fileNames, const BinLoadSettings& settings, double headerSeconds)
 {
-    // This specialization does nothing, intensionally! 
+    const auto& sourceDataset  = settings.sourceDataset;
+    const auto numDims         = settings.numDimensions;
+    const auto& storeAs        = settings.storeAs;
+
+    const auto storeAsIndex = getStorageTypeIndex(storeAs);
+
+    if (!storeAsIndex)
+        throw DataLoadException(fileNames.first(), QString("Unknown storage type %1").arg(storeAs));
+
+    // open the binary files, they are streamed in chunks by several threads once they are all open
+    LoadJob job;
+    job.storeAs         = storeAs;
+    job.storeAsIndex    = *storeAsIndex;
+    job.numDims         = numDims;
+    job.readMethod      = settings.readMethod;
+    job.verifyChecksums = settings.verifyChecksums;
+
+    try
+    {
+        job.columns = parseIndexList(settings.dimensions.toStdString(), static_cast<std::size_t>(numDims));
+    }
+    catch (const std::exception& e)
+    {
+        throw DataLoadException(fileNames.first(), QString("Invalid dimensions: %1").arg(e.what()));
+    }
+
+    // Selecting all dimensions in order is the same as selecting none
+    if (isAllColumns(job.columns, static_cast<std::size_t>(numDims)))
+        job.columns.clear();
+
+    Stopwatch openStopwatch;
+
+    // A random sample jumps through the files, read ahead would only load rows that are skipped
+    const AccessPattern accessPattern = settings.rowSelection.mode == RowSelectionSettings::Mode::Random ? AccessPattern::Random : AccessPattern::Sequential;
+
+    // Every file must have the dimensions of the first, element type and byte order may differ between v2 files
+    std::vector<LoadPart> parts;
+
+    for (const QString& fileName : fileNames)
+    {
+        try
+        {
+            parts.push_back(openPart(fileName, *settings.elementType, *settings.byteOrder, numDims, job.readMethod, accessPattern, job.verifyChecksums, job.open.bytes));
+        }
+        catch (const std::exception& e)
+        {
+            throw DataLoadException(fileName, e.what());
+        }
+    }
+
+    // The time a dialog was open is not part of the load
+    job.open.name       = "open";
+    job.open.seconds    = headerSeconds + openStopwatch.getSeconds();
+
+    const RowSelectionSettings& rowSelection = settings.rowSelection;
+
+    const auto createDataset = [&sourceDataset](const QString& datasetName) -> Dataset<Points> {
+        if (sourceDataset.isValid())
+            return mv::data().createDerivedDataset<Points>(datasetName, sourceDataset);
+
+        return mv::data().createDataset<Points>("Points", datasetName);
+    };
+
+    if (parts.size() == 1 || settings.concatenateFiles)
+    {
+        // The points are selected from the files as if they were one, every file loads its slice of the selection
+        // into its slice of the data set, which is allocated once for all files
+        std::uint64_t numRows = 0;
+        for (const auto& part : parts)
+            numRows += part.dataRegion.numRows;
+
+        const RowSelection rows = selectRows(rowSelection, numRows);
+
+        LoadTarget target;
+        target.name     = parts.size() == 1 ? QFileInfo(parts.front().fileName).fileName() : QString("%1 files").arg(parts.size());
+        target.numRows  = rows.size();
+
+        std::uint64_t firstRow = 0;
+
+        for (auto& part : parts)
+        {
+            part.rows           = sliceRows(rows, firstRow, firstRow + part.dataRegion.numRows);
+            part.firstOutputRow = rows.lowerBound(firstRow);
+
+            firstRow += part.dataRegion.numRows;
+
+            target.parts.push_back(std::move(part));
+        }
+
+        target.pointData = createDataset(settings.datasetName);
+
+        job.targets.push_back(std::move(target));
+    }
+    else
+    {
+        // Every file becomes a data set named after the file, the points are selected from each file separately
+        for (auto& part : parts)
+        {
+            LoadTarget target;
+            target.name     = QFileInfo(part.fileName).fileName();
+
+            part.rows       = selectRows(rowSelection, part.dataRegion.numRows);
+            target.numRows  = part.rows.size();
+
+            target.pointData = createDataset(QFileInfo(part.fileName).baseName());
+            target.parts.push_back(std::move(part));
+
+            job.targets.push_back(std::move(target));
+        }
+    }
+
+    job.settings.numberOfThreads = settings.numberOfThreads;
+    job.settings.bufferSize      = settings.bufferSize;
+
+    std::vector<Dataset<Points>> datasets;
+
+    for (const auto& target : job.targets)
+        datasets.push_back(target.pointData);
+
+    // The files are read on worker threads, so the GUI stays responsive and several loads can run at once
+    auto* const backgroundLoad = new BackgroundLoad(std::move(job));
+
+    backgroundLoad->start();
+
+    return datasets;
 }
 
 }
 
 void BinLoader::loadData()
 {
-    const QString fileName = AskForFileName(tr("BIN Files (*.bin)"));
+    const QStringList selectedFileNames = AskForFileNames(tr("BIN Files (*.bin)"));
 
-    // Don't try to load a file if the dialog was cancelled or the file name is empty
-    if (fileName.isNull() || fileName.isEmpty())
+    // Don't try to load files if the dialog was cancelled
+    if (selectedFileNames.isEmpty())
         return;
 
-    qDebug() << "Loading BIN file: " << fileName;
+    qDebug() << "Loading BIN files: " << selectedFileNames;
+
+    // v2 files describe their own contents, mis-sized files are rejected before anything is read.
+    // The first file sets up the dialog, its settings apply to all files.
+    Stopwatch openStopwatch;
 
-    // read in binary data
-    std::vector<char> contents;
-    std::ifstream in(fileName.toStdString(), std::ios::in | std::ios::binary);
-    if (in)
+    std::optional<FileHeader> fileHeader;
+    try
     {
-        in.seekg(0, std::ios::end);
-        contents.resize(in.tellg());
-        in.seekg(0, std::ios::beg);
-        in.read(&contents[0], contents.size());
-        in.close();
+        fileHeader = readFileHeader(selectedFileNames.first());
     }
-    else
+    catch (const std::exception& e)
     {
-        throw DataLoadException(fileName, "File was not found at location.");
+        throw DataLoadException(selectedFileNames.first(), e.what());
     }
 
-    BinLoadingInputDialog inputDialog(nullptr, *this, QFileInfo(fileName).baseName());
+    const double headerSeconds = openStopwatch.getSeconds();
+
+    const bool isIndexFile = fileHeader && (fileHeader->flags & FileFlags::Indices);
+
+    if (isIndexFile && selectedFileNames.size() > 1)
+        throw DataLoadException(selectedFileNames.first(), "Index files are loaded one at a time");
+
+    BinLoadingInputDialog inputDialog(nullptr, *this, selectedFileNames, fileHeader);
     inputDialog.setModal(true);
 
     // open dialog and wait for user input
     int ok = inputDialog.exec();
 
     if (ok == QDialog::Accepted && !inputDialog.getDatasetName().isEmpty()) {
-    
-        auto sourceDataset = inputDialog.getSourceDataset();
-        auto numDims = inputDialog.getNumberOfDimensions();
-        auto storeAs = inputDialog.getStoreAs();
 
-        Dataset<Points> point_data;
+        // Index files become a subset of the source dataset, nothing else is loaded
+        if (isIndexFile)
+        {
+            const Dataset<Points> sourcePoints = inputDialog.getSourceDataset();
 
-        if (sourceDataset.isValid())
-            point_data = mv::data().createDerivedDataset<Points>(inputDialog.getDatasetName(), sourceDataset);
-        else
-            point_data = mv::data().createDataset<Points>("Points", inputDialog.getDatasetName());
+            if (!sourcePoints.isValid())
+                throw DataLoadException(selectedFileNames.first(), "Pick the source dataset of the indices");
 
-        if (inputDialog.getDataType() == BinaryDataType::FLOAT)
-        {
-            recursiveReadDataAndAddToCore<float>(storeAs, point_data, numDims, contents);
+            loadIndices(selectedFileNames.first(), *fileHeader, sourcePoints, inputDialog.getDatasetName(), headerSeconds);
+
+            return;
         }
-        else if (inputDialog.getDataType() == BinaryDataType::UBYTE)
+
+        // A pattern replaces the selected files, relative patterns are taken from the folder of the first selected file
+        QStringList fileNames = selectedFileNames;
+
+        if (const QString filePattern = inputDialog.getFilePattern(); !filePattern.isEmpty())
         {
-            recursiveReadDataAndAddToCore<unsigned char>(storeAs, point_data, numDims, contents);
+            const QString patternPath = QDir(QFileInfo(selectedFileNames.first()).absolutePath()).filePath(filePattern);
+
+            fileNames.clear();
+
+            try
+            {
+                for (const auto& filePath : expandFilePattern(toPath(patternPath)))
+                    fileNames.append(QString::fromStdU16String(filePath.u16string()));
+            }
+            catch (const std::exception& e)
+            {
+                throw DataLoadException(patternPath, e.what());
+            }
+
+            if (fileNames.isEmpty())
+                throw DataLoadException(patternPath, "No files match the pattern");
         }
+
+        BinLoadSettings settings;
+
+        settings.datasetName        = inputDialog.getDatasetName();
+        settings.elementType        = inputDialog.getElementType();
+        settings.byteOrder          = inputDialog.getByteOrder();
+        settings.numDimensions      = fileHeader ? static_cast<std::int32_t>(fileHeader->numColumns) : inputDialog.getNumberOfDimensions();
+        settings.storeAs            = inputDialog.getStoreAs();
+        settings.dimensions         = inputDialog.getDimensions();
+        settings.rowSelection       = inputDialog.getRowSelection();
+        settings.concatenateFiles   = inputDialog.getConcatenateFiles();
+        settings.sourceDataset      = inputDialog.getSourceDataset();
+        settings.numberOfThreads    = inputDialog.getNumberOfThreads();
+        settings.bufferSize         = inputDialog.getBufferSize();
+        settings.readMethod         = inputDialog.getReadMethod();
+        settings.verifyChecksums    = inputDialog.getVerifyChecksums();
+
+        startLoad(fileNames, settings, headerSeconds);
+    }
+
+}
+
+std::vector<Dataset<Points>> BinLoader::loadFiles(const QStringList& fileNames, const BinLoadSettings& settings)
+{
+    if (fileNames.isEmpty())
+        return {};
+
+    qDebug() << "Loading BIN files: " << fileNames;
+
+    // The settings of the first file apply to all files, like in the dialog
+    Stopwatch openStopwatch;
+
+    std::optional<FileHeader> fileHeader;
+    BinLoadSettings loadSettings;
+    try
+    {
+        fileHeader      = readFileHeader(fileNames.first());
+        loadSettings    = resolveLoadSettings(fileNames, fileHeader, settings);
+    }
+    catch (const std::exception& e)
+    {
+        throw DataLoadException(fileNames.first(), e.what());
+    }
+
+    const double headerSeconds = openStopwatch.getSeconds();
+
+    // Index files become a subset of the source dataset, nothing else is loaded
+    if (fileHeader && (fileHeader->flags & FileFlags::Indices))
+    {
+        if (fileNames.size() > 1)
+            throw DataLoadException(fileNames.first(), "Index files are loaded one at a time");
+
+        const Dataset<Points> sourcePoints = loadSettings.sourceDataset;
+
+        if (!sourcePoints.isValid())
+            throw DataLoadException(fileNames.first(), "Index files need the source dataset of the indices");
+
+        return { loadIndices(fileNames.first(), *fileHeader, sourcePoints, loadSettings.datasetName, headerSeconds) };
     }
 
+    return startLoad(fileNames, loadSettings, headerSeconds);
+}
+
+Dataset<Points> BinLoader::loadFile(const QString& fileName, std::optional<ElementType> elementType, std::int32_t numDimensions, const QString& storeAs)
+{
+    BinLoadSettings settings;
+
+    settings.elementType    = elementType;
+    settings.numDimensions  = numDimensions;
+    settings.storeAs        = storeAs;
+
+    return loadFiles({ fileName }, settings).front();
 }
 
 // =============================================================================
@@ -185,20 +1515,45 @@ DataTypes BinLoaderFactory::supportedDataTypes() const
     return supportedTypes;
 }
 
-BinLoadingInputDialog::BinLoadingInputDialog(QWidget* parent, BinLoader& binLoader, QString fileName) :
+BinLoadingInputDialog::BinLoadingInputDialog(QWidget* parent, BinLoader& binLoader, const QStringList& fileNames, const std::optional<FileHeader>& fileHeader) :
     QDialog(parent),
-    _datasetNameAction(this, "Dataset name", fileName),
-    _dataTypeAction(this, "Data type", { "Float", "Unsigned Byte" }),
+    _datasetNameAction(this, "Dataset name", fileNames.size() == 1 ? QFileInfo(fileNames.first()).baseName() : QFileInfo(fileNames.first()).dir().dirName()),
+    _filePatternAction(this, "Files"),
+    _multipleFilesAction(this, "Multiple files", { "Concatenate into one data set", "One data set per file" }),
+    _dataTypeAction(this, "Data type"),
+    _byteOrderAction(this, "Byte order", { "Little endian", "Big endian" }),
     _numberOfDimensionsAction(this, "Number of dimensions", 1, 1000000, 1),
 	_storeAsAction(this, "Store as"),
     _isDerivedAction(this, "Mark as derived", false),
     _datasetPickerAction(this, "Source dataset"),
+    _numberOfThreadsAction(this, "Number of threads", 1, 256, static_cast<int>(resolveNumberOfThreads(0))),
+    _readMethodAction(this, "Read method", { "Positional reads", "Memory map", "Direct (around the page cache)" }),
+    _bufferSizeAction(this, "Buffer size (MB)", 1, 65536, 256),
+    _verifyChecksumsAction(this, "Verify checksums", true),
+    _dimensionsAction(this, "Dimensions"),
+    _rowsAction(this, "Points", { "All", "Range", "Every k-th point", "Random sample" }),
+    _firstRowAction(this, "First point", 0, std::numeric_limits<int>::max(), 0),
+    _numberOfRowsAction(this, "Number of points", 1, std::numeric_limits<int>::max(), 10000),
+    _rowStepAction(this, "Point step", 1, std::numeric_limits<int>::max(), 10),
+    _randomSeedAction(this, "Random seed", 0, std::numeric_limits<int>::max(), 0),
+    _inspectionAction(this, "File"),
     _loadAction(this, "Load"),
-    _groupAction(this, "Settings")
+    _groupAction(this, "Settings"),
+    _previewLabel(new QLabel()),
+    _fileHeader(fileHeader),
+    _numberOfFiles(fileNames.size())
 {
     setWindowTitle(tr("Binary Loader"));
 
     _numberOfDimensionsAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
+    _numberOfThreadsAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
+    _bufferSizeAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
+    _dimensionsAction.setPlaceHolderString("All, or e.g. 0-49, 100, 200-210");
+    _filePatternAction.setPlaceHolderString(QString("%1 selected file(s), or a pattern such as part-*.bin").arg(fileNames.size()));
+    _firstRowAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
+    _numberOfRowsAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
+    _rowStepAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
+    _randomSeedAction.setDefaultWidgetFlags(IntegralAction::WidgetFlag::SpinBox);
 
     QStringList pointDataTypes;
     for (const char* const typeName : PointData::getElementTypeNames())
@@ -207,23 +1562,115 @@ BinLoadingInputDialog::BinLoadingInputDialog(QWidget* parent, BinLoader& binLoad
     }
     _storeAsAction.setOptions(pointDataTypes);
 
+    QStringList dataTypes;
+    for (const ElementType elementType : legacyElementTypes)
+    {
+        dataTypes.append(QString::fromLatin1(getElementTypeName(elementType)));
+    }
+    _dataTypeAction.setOptions(dataTypes);
+
     // Load some settings
     _dataTypeAction.setCurrentIndex(binLoader.getSetting("DataType").toInt());
+    _byteOrderAction.setCurrentIndex(binLoader.getSetting("ByteOrder", static_cast<int>(getNativeByteOrder())).toInt());
     _numberOfDimensionsAction.setValue(binLoader.getSetting("NumberOfDimensions").toInt());
     _storeAsAction.setCurrentIndex(binLoader.getSetting("StoreAs").toInt());
+    _numberOfThreadsAction.setValue(binLoader.getSetting("NumberOfThreads", static_cast<int>(resolveNumberOfThreads(0))).toInt());
+    _multipleFilesAction.setCurrentIndex(binLoader.getSetting("MultipleFiles").toInt());
+    _readMethodAction.setCurrentIndex(binLoader.getSetting("ReadMethod").toInt());
+    _bufferSizeAction.setValue(binLoader.getSetting("BufferSize", 256).toInt());
+    _verifyChecksumsAction.setChecked(binLoader.getSetting("VerifyChecksums", true).toBool());
+    _rowsAction.setCurrentIndex(binLoader.getSetting("Rows").toInt());
+    _numberOfRowsAction.setValue(binLoader.getSetting("NumberOfRows", 10000).toInt());
+    _rowStepAction.setValue(binLoader.getSetting("RowStep", 10).toInt());
+    _randomSeedAction.setValue(binLoader.getSetting("RandomSeed").toInt());
+
+    // The header of a v2 file fixes the data type, the byte order and the number of dimensions.
+    // By default the data is stored as it is in the file so that it is loaded without conversion,
+    // types that PointData cannot store and the codes of quantized files are stored as float32
+    if (_fileHeader)
+    {
+        _dataTypeAction.setOptions({ QString::fromLatin1(getElementTypeName(fileHeader->elementType)) });
+        _dataTypeAction.setCurrentIndex(0);
+        _byteOrderAction.setCurrentIndex(static_cast<int>(fileHeader->byteOrder));
+        _numberOfDimensionsAction.setValue(static_cast<int>(fileHeader->numColumns));
+        _storeAsAction.setCurrentText(getDefaultStoreAs(fileHeader->elementType, isQuantized()));
+
+        _dataTypeAction.setEnabled(false);
+        _byteOrderAction.setEnabled(false);
+        _numberOfDimensionsAction.setEnabled(false);
+
+        const auto maxRows = static_cast<int>(std::min<std::uint64_t>(fileHeader->numRows, std::numeric_limits<int>::max()));
+
+        _firstRowAction.setMaximum(std::max(maxRows - 1, 0));
+        _numberOfRowsAction.setMaximum(std::max(maxRows, 1));
+    }
+
+    // The description the exporter writes next to a raw file replaces the settings of the previous load
+    if (!_fileHeader)
+    {
+        try
+        {
+            if (const auto description = readFileDescription(fileNames.first()))
+            {
+                if (description->elementType)
+                    _dataTypeAction.setCurrentText(QString::fromLatin1(getElementTypeName(*description->elementType)));
+
+                if (description->byteOrder)
+                    _byteOrderAction.setCurrentIndex(static_cast<int>(*description->byteOrder));
+
+                if (description->numDimensions > 0)
+                    _numberOfDimensionsAction.setValue(description->numDimensions);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            qWarning() << "BinLoader: Could not read the description of" << fileNames.first() << ":" << e.what();
+        }
+    }
 
     _groupAction.addAction(&_datasetNameAction);
-    _groupAction.addAction(&_dataTypeAction);
-    _groupAction.addAction(&_numberOfDimensionsAction);
-    _groupAction.addAction(&_storeAsAction);
-    _groupAction.addAction(&_isDerivedAction);
+
+    // Index files only need the dataset the indices refer to, they become a subset of it
+    if (isIndexFile())
+    {
+        _isDerivedAction.setChecked(true);
+        _datasetPickerAction.setToolTip("Dataset whose points the indices refer to");
+    }
+    else
+    {
+        _groupAction.addAction(&_filePatternAction);
+        _groupAction.addAction(&_multipleFilesAction);
+        _groupAction.addAction(&_dataTypeAction);
+        _groupAction.addAction(&_byteOrderAction);
+        _groupAction.addAction(&_numberOfDimensionsAction);
+        _groupAction.addAction(&_dimensionsAction);
+        _groupAction.addAction(&_rowsAction);
+        _groupAction.addAction(&_firstRowAction);
+        _groupAction.addAction(&_numberOfRowsAction);
+        _groupAction.addAction(&_rowStepAction);
+        _groupAction.addAction(&_randomSeedAction);
+        _groupAction.addAction(&_storeAsAction);
+        _groupAction.addAction(&_isDerivedAction);
+    }
+
     _groupAction.addAction(&_datasetPickerAction);
+
+    if (!isIndexFile())
+    {
+        _groupAction.addAction(&_numberOfThreadsAction);
+        _groupAction.addAction(&_readMethodAction);
+        _groupAction.addAction(&_bufferSizeAction);
+        _groupAction.addAction(&_verifyChecksumsAction);
+    }
+
+    _groupAction.addAction(&_inspectionAction);
     _groupAction.addAction(&_loadAction);
 
     auto layout = new QVBoxLayout();
 
     layout->setContentsMargins(0, 0, 0, 0);
     layout->addWidget(_groupAction.createWidget(this));
+    layout->addWidget(_previewLabel);
 
     setLayout(layout);
 
@@ -253,14 +1700,155 @@ BinLoadingInputDialog::BinLoadingInputDialog(QWidget* parent, BinLoader& binLoad
     // Update dataset picker at startup
     updateDatasetPicker();
 
+    // The inspection only maps the first file, the few bytes it shows are all that is read before loading
+    try
+    {
+        _fileReader = openFileReader(toPath(fileNames.first()), ReadMethod::MemoryMap);
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "BinLoader: Could not inspect" << fileNames.first() << ":" << e.what();
+    }
+
+    // A pattern may match several files even when a single file is selected
+    const auto updateMultipleFiles = [this]() -> void {
+        _multipleFilesAction.setEnabled(_numberOfFiles > 1 || !_filePatternAction.getString().isEmpty());
+    };
+
+    connect(&_filePatternAction, &StringAction::stringChanged, this, updateMultipleFiles);
+
+    updateMultipleFiles();
+
+    connect(&_dataTypeAction, &OptionAction::currentIndexChanged, this, [this]() -> void { updateInspection(); });
+    connect(&_byteOrderAction, &OptionAction::currentIndexChanged, this, [this]() -> void { updateInspection(); });
+    connect(&_numberOfDimensionsAction, &IntegralAction::valueChanged, this, [this]() -> void { updateInspection(); });
+
+    updateInspection();
+
+    // Only show the settings of the selected way of picking points
+    const auto updateRowActions = [this]() -> void {
+        const auto mode = static_cast<RowSelectionSettings::Mode>(_rowsAction.getCurrentIndex());
+
+        _firstRowAction.setEnabled(mode == RowSelectionSettings::Mode::Range || mode == RowSelectionSettings::Mode::Stride);
+        _numberOfRowsAction.setEnabled(mode == RowSelectionSettings::Mode::Range || mode == RowSelectionSettings::Mode::Random);
+        _rowStepAction.setEnabled(mode == RowSelectionSettings::Mode::Stride);
+        _randomSeedAction.setEnabled(mode == RowSelectionSettings::Mode::Random);
+    };
+
+    connect(&_rowsAction, &OptionAction::currentIndexChanged, this, updateRowActions);
+
+    updateRowActions();
+
     // Accept when the load action is triggered
     connect(&_loadAction, &TriggerAction::triggered, this, [this, &binLoader]() {
 
-        // Save some settings
-        binLoader.setSetting("DataType", _dataTypeAction.getCurrentIndex());
-        binLoader.setSetting("NumberOfDimensions", _numberOfDimensionsAction.getValue());
-        binLoader.setSetting("StoreAs", _storeAsAction.getCurrentIndex());
+        // Save some settings, values from a file header only apply to that file
+        if (!_fileHeader)
+        {
+            binLoader.setSetting("DataType", _dataTypeAction.getCurrentIndex());
+            binLoader.setSetting("ByteOrder", _byteOrderAction.getCurrentIndex());
+            binLoader.setSetting("NumberOfDimensions", _numberOfDimensionsAction.getValue());
+            binLoader.setSetting("StoreAs", _storeAsAction.getCurrentIndex());
+        }
+
+        binLoader.setSetting("MultipleFiles", _multipleFilesAction.getCurrentIndex());
+        binLoader.setSetting("NumberOfThreads", _numberOfThreadsAction.getValue());
+        binLoader.setSetting("ReadMethod", _readMethodAction.getCurrentIndex());
+        binLoader.setSetting("BufferSize", _bufferSizeAction.getValue());
+        binLoader.setSetting("VerifyChecksums", _verifyChecksumsAction.isChecked());
+        binLoader.setSetting("Rows", _rowsAction.getCurrentIndex());
+        binLoader.setSetting("NumberOfRows", _numberOfRowsAction.getValue());
+        binLoader.setSetting("RowStep", _rowStepAction.getValue());
+        binLoader.setSetting("RandomSeed", _randomSeedAction.getValue());
 
         accept();
     });
 }
+
+ElementType BinLoadingInputDialog::getElementType() const
+{
+    if (_fileHeader)
+        return _fileHeader->elementType;
+
+    const int index = _dataTypeAction.getCurrentIndex();
+
+    return legacyElementTypes[static_cast<std::size_t>(std::clamp(index, 0, static_cast<int>(legacyElementTypes.size()) - 1))];
+}
+
+void BinLoadingInputDialog::updateInspection()
+{
+    if (!_fileReader)
+        return;
+
+    const std::uint64_t fileSize    = _fileReader->size();
+
+    // Index files hold no values to preview
+    if (isIndexFile())
+    {
+        try
+        {
+            const IndexInfo indexInfo = readIndexInfo(*_fileReader, *_fileHeader);
+
+            _inspectionAction.setStatus(StatusAction::Status::Info);
+            _inspectionAction.setMessage(QString("%1 indices (%2) of a dataset of %3 points, %4 MB").arg(_fileHeader->numRows).arg(getIndexEncodingName(indexInfo.encoding)).arg(indexInfo.numPoints > 0 ? QString::number(indexInfo.numPoints) : QString("unknown")).arg(static_cast<double>(fileSize) / 1.0e6, 0, 'f', 1));
+        }
+        catch (const std::exception& e)
+        {
+            _inspectionAction.setStatus(StatusAction::Status::Error);
+            _inspectionAction.setMessage(QString(e.what()));
+        }
+
+        _previewLabel->setText("Loaded as a subset of the source dataset, without copying point values");
+
+        return;
+    }
+
+    const ElementType elementType   = getElementType();
+    const std::uint64_t elementSize = getElementSize(elementType);
+    const std::uint64_t numColumns  = _fileHeader ? _fileHeader->numColumns : static_cast<std::uint64_t>(std::max(getNumberOfDimensions(), 1));
+    const std::uint64_t numRows     = _fileHeader ? _fileHeader->numRows : fileSize / elementSize / numColumns;
+
+    // The settings apply to all files, the inspection shows the first
+    QString message = QString("%1%2 points of %3 %4%5 dimensions, %6 MB").arg(_numberOfFiles > 1 ? QString("First of %1 files: ").arg(_numberOfFiles) : QString()).arg(numRows).arg(numColumns).arg(QString::fromLatin1(getElementTypeName(elementType)) + (isQuantized() ? " quantized" : "")).arg(getByteOrder() == ByteOrder::BigEndian ? " big-endian" : "").arg(static_cast<double>(fileSize) / 1.0e6, 0, 'f', 1);
+    StatusAction::Status status = StatusAction::Status::Info;
+
+    // Legacy files only fit the data type and number of dimensions when their size is divisible by them
+    if (!_fileHeader)
+    {
+        if (fileSize % elementSize != 0)
+        {
+            message += QString(": the last %1 bytes do not form a whole %2 value").arg(fileSize % elementSize).arg(getElementTypeName(elementType));
+            status = StatusAction::Status::Warning;
+        }
+        else if ((fileSize / elementSize) % numColumns != 0)
+        {
+            message += QString(": %1 values do not divide into %2 dimensions").arg(fileSize / elementSize).arg(numColumns);
+            status = StatusAction::Status::Warning;
+        }
+    }
+
+    _inspectionAction.setStatus(status);
+    _inspectionAction.setMessage(message);
+
+    QStringList lines;
+    try
+    {
+        const std::size_t numPreviewColumns = static_cast<std::size_t>(std::min<std::uint64_t>(numColumns, previewColumns));
+        const auto values                   = peekRows(*_fileReader, _fileHeader, elementType, getByteOrder(), numRows, numColumns);
+
+        for (std::size_t row = 0; row < values.size() / std::max<std::size_t>(numPreviewColumns, 1); row++)
+        {
+            QStringList line;
+            for (std::size_t column = 0; column < numPreviewColumns; column++)
+                line.append(QString::number(values[row * numPreviewColumns + column], 'g', 6));
+
+            lines.append(QString("%1: %2%3").arg(row).arg(line.join("  ")).arg(numColumns > numPreviewColumns ? "  ..." : ""));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        lines.append(QString("No preview: %1").arg(e.what()));
+    }
+
+    _previewLabel->setText(lines.join("\n"));
+}
@@ -1,15 +1,27 @@
 #pragma once
 
+#include "FileFormat.h"
+#include "FileReader.h"
+#include "Selection.h"
+
 #include <actions/DatasetPickerAction.h>
 #include <actions/GroupAction.h>
 #include <actions/IntegralAction.h>
 #include <actions/OptionAction.h>
+#include <actions/StatusAction.h>
 #include <actions/StringAction.h>
 #include <actions/TriggerAction.h>
 
 #include <LoaderPlugin.h>
 
+#include <PointData/PointData.h>
+
 #include <QDialog>
+#include <QLabel>
+
+#include <memory>
+#include <optional>
+#include <vector>
 
 using namespace mv::plugin;
 
@@ -19,17 +31,19 @@ using namespace mv::plugin;
 
 class BinLoader;
 
-enum BinaryDataType
-{
-    FLOAT, UBYTE
-};
-
 class BinLoadingInputDialog : public QDialog
 {
     Q_OBJECT
 
 public:
-    BinLoadingInputDialog(QWidget* parent, BinLoader& binLoader, QString fileName);
+    /*! Construct the dialog
+     *
+     * \param parent Parent widget
+     * \param binLoader Loader whose settings are used and stored
+     * \param fileNames Selected files, the base name of a single file or the folder of several is the default dataset name
+     * \param fileHeader Header of the first file when it is a v2 file, which fixes the data type, byte order and number of dimensions
+    */
+    BinLoadingInputDialog(QWidget* parent, BinLoader& binLoader, const QStringList& fileNames, const std::optional<FileHeader>& fileHeader = std::nullopt);
 
     /** Get preferred size */
     QSize sizeHint() const override {
@@ -46,12 +60,25 @@ public:
         return _datasetNameAction.getString();
     }
 
-    /** Get the binary data type */
-    BinaryDataType getDataType() const {
-        if (_dataTypeAction.getCurrentIndex() == 0) // Float32
-            return BinaryDataType::FLOAT;
-        // else if (_dataTypeAction.getCurrentIndex() == 1) // Unsigned Byte (Uint8)
-        return BinaryDataType::UBYTE;
+    /** Get the pattern of the files to load, e.g. "part-*.bin", empty loads the selected files */
+    QString getFilePattern() const {
+        return _filePatternAction.getString();
+    }
+
+    /** Get whether several files are concatenated into one dataset, otherwise every file becomes a dataset */
+    bool getConcatenateFiles() const {
+        return _multipleFilesAction.getCurrentIndex() == 0;
+    }
+
+    /** Get the element type of the data in the file */
+    ElementType getElementType() const;
+
+    /** Get the byte order of the data in the file */
+    ByteOrder getByteOrder() const {
+        if (_byteOrderAction.getCurrentIndex() == 1) // Big endian
+            return ByteOrder::BigEndian;
+        // else if (_byteOrderAction.getCurrentIndex() == 0) // Little endian
+        return ByteOrder::LittleEndian;
     }
 
     /** Get the number of dimensions */
@@ -59,6 +86,11 @@ public:
         return _numberOfDimensionsAction.getValue();
     }
 
+    /** Get the dimensions to load as indices and inclusive ranges, e.g. "0-49, 100", empty loads all */
+    QString getDimensions() const {
+        return _dimensionsAction.getString();
+    }
+
     /** Get the desired storage type */
     QString getStoreAs() const {
         return _storeAsAction.getCurrentText();
@@ -69,20 +101,120 @@ public:
         return _isDerivedAction.isChecked();
     }
 
+    /** Get the number of threads that read and convert the file */
+    std::size_t getNumberOfThreads() const {
+        return static_cast<std::size_t>(_numberOfThreadsAction.getValue());
+    }
+
+    /** Get which points are loaded */
+    RowSelectionSettings getRowSelection() const {
+        RowSelectionSettings rowSelection;
+
+        rowSelection.mode   = static_cast<RowSelectionSettings::Mode>(_rowsAction.getCurrentIndex());
+        rowSelection.first  = static_cast<std::uint64_t>(_firstRowAction.getValue());
+        rowSelection.count  = static_cast<std::uint64_t>(_numberOfRowsAction.getValue());
+        rowSelection.step   = static_cast<std::uint64_t>(_rowStepAction.getValue());
+        rowSelection.seed   = static_cast<std::uint64_t>(_randomSeedAction.getValue());
+
+        return rowSelection;
+    }
+
+    /** Get the maximum number of raw bytes that is buffered while streaming through the file */
+    std::size_t getBufferSize() const {
+        return static_cast<std::size_t>(_bufferSizeAction.getValue()) << 20;
+    }
+
+    /** Get how the file is read */
+    ReadMethod getReadMethod() const {
+        if (_readMethodAction.getCurrentIndex() == 1) // Memory map
+            return ReadMethod::MemoryMap;
+        else if (_readMethodAction.getCurrentIndex() == 2) // Direct
+            return ReadMethod::DirectRead;
+        // else if (_readMethodAction.getCurrentIndex() == 0) // Positional reads
+        return ReadMethod::PositionalRead;
+    }
+
+    /** Get whether the checksums of the files are verified while they are loaded */
+    bool getVerifyChecksums() const {
+        return _verifyChecksumsAction.isChecked();
+    }
+
+    /** Get whether the file holds point indices, which are loaded as a subset of the source dataset */
+    bool isIndexFile() const {
+        return _fileHeader && (_fileHeader->flags & FileFlags::Indices);
+    }
+
+    /** Get whether the file holds quantized codes, which are stored as float32 by default */
+    bool isQuantized() const {
+        return _fileHeader && (_fileHeader->flags & FileFlags::Quantized);
+    }
+
     /** Get smart pointer to dataset (if any) */
     mv::Dataset<mv::DatasetImpl> getSourceDataset() {
         return _datasetPickerAction.getCurrentDataset();
     }
 
+private:
+    /** Update the implied number of points, the size check and the preview for the current data type, byte order and number of dimensions */
+    void updateInspection();
+
 protected:
     mv::gui::StringAction            _datasetNameAction;             /** Dataset name action */
+    mv::gui::StringAction            _filePatternAction;             /** Pattern of the files to load action */
+    mv::gui::OptionAction            _multipleFilesAction;           /** Concatenate files or load one dataset per file action */
     mv::gui::OptionAction            _dataTypeAction;                /** Data type action */
+    mv::gui::OptionAction            _byteOrderAction;               /** Byte order action */
     mv::gui::IntegralAction          _numberOfDimensionsAction;      /** Number of dimensions action */
     mv::gui::OptionAction            _storeAsAction;                 /** Store as action */
     mv::gui::ToggleAction            _isDerivedAction;               /** Mark dataset as derived action */
     mv::gui::DatasetPickerAction     _datasetPickerAction;           /** Dataset picker action for picking source datasets */
+    mv::gui::IntegralAction          _numberOfThreadsAction;         /** Number of threads action */
+    mv::gui::OptionAction            _readMethodAction;              /** Read method action */
+    mv::gui::IntegralAction          _bufferSizeAction;              /** Raw buffer size (in MB) action */
+    mv::gui::ToggleAction            _verifyChecksumsAction;         /** Verify the checksums of the files action */
+    mv::gui::StringAction            _dimensionsAction;              /** Dimensions to load action */
+    mv::gui::OptionAction            _rowsAction;                    /** Points to load action, see RowSelectionSettings::Mode */
+    mv::gui::IntegralAction          _firstRowAction;                /** First point to load action */
+    mv::gui::IntegralAction          _numberOfRowsAction;            /** Number of points to load action */
+    mv::gui::IntegralAction          _rowStepAction;                 /** Distance between loaded points action */
+    mv::gui::IntegralAction          _randomSeedAction;              /** Seed of the random sample action */
+    mv::gui::StatusAction            _inspectionAction;              /** Implied number of points and size check action */
     mv::gui::TriggerAction           _loadAction;                    /** Load action */
     mv::gui::GroupAction             _groupAction;                   /** Group action */
+    QLabel*                          _previewLabel;                  /** First values of the first points in the file */
+    std::optional<FileHeader>        _fileHeader;                    /** Header of a v2 file, which fixes the data type, byte order and number of dimensions */
+    std::unique_ptr<FileReader>      _fileReader;                    /** Memory map of the first file for the inspection, only the inspected bytes are read */
+    qsizetype                        _numberOfFiles;                 /** Number of selected files */
+};
+
+// =============================================================================
+// Load settings
+// =============================================================================
+
+/**
+ * Settings of a load without the dialog, see BinLoader::loadFiles
+ *
+ * v2 files describe their own data type, byte order and number of
+ * dimensions. For raw files, settings that are not given are read from the
+ * description the exporter writes next to every file: the .json file, or the
+ * .txt file of earlier versions, which implies the byte order of this
+ * machine. Like in the dialog, the settings of the first file apply to all.
+ */
+struct BinLoadSettings
+{
+    QString                         datasetName;                                         /** GUI name of the data set, empty uses the base name of a single file or the folder of several */
+    std::optional<ElementType>      elementType;                                         /** Element type of raw files, unset reads it from the description */
+    std::optional<ByteOrder>        byteOrder;                                           /** Byte order of raw files, unset reads it from the description */
+    std::int32_t                    numDimensions       = 0;                             /** Number of dimensions of raw files, 0 reads it from the description */
+    QString                         storeAs;                                             /** PointData element type of the data sets, empty stores the data as it is in the file (quantized codes and other types as float32) */
+    QString                         dimensions;                                          /** Dimensions to load as indices and inclusive ranges, e.g. "0-49, 100", empty loads all */
+    RowSelectionSettings            rowSelection;                                        /** Which points are loaded */
+    bool                            concatenateFiles    = true;                          /** Whether several files are concatenated into one data set, otherwise every file becomes a data set */
+    mv::Dataset<mv::DatasetImpl>    sourceDataset;                                       /** Data set the loaded data sets are derived from, or the source data set of an index file */
+    std::size_t                     numberOfThreads     = 0;                             /** Number of threads that read and convert the files, 0 uses all hardware threads */
+    std::size_t                     bufferSize          = 256u << 20;                    /** Maximum number of raw bytes that is buffered while streaming through the files */
+    ReadMethod                      readMethod          = ReadMethod::PositionalRead;    /** How the files are read */
+    bool                            verifyChecksums     = true;                          /** Whether the checksums of the files are verified while they are loaded */
 };
 
 // =============================================================================
@@ -99,6 +231,31 @@ public:
     void init() override;
 
     void loadData() Q_DECL_OVERRIDE;
+
+    /*! Load files without the dialog
+     *
+     * The files are checked and opened right away and throw a DataLoadException
+     * when they cannot be loaded with the settings. Their points are read in
+     * the background, like loads from the dialog, and added to the returned
+     * data sets once they are read; the task of every data set shows its
+     * progress. An index file becomes a subset of settings.sourceDataset,
+     * which is complete when this returns.
+     *
+     * \param fileNames Files to load, index files are loaded one at a time
+     * \param settings Settings of the load, see BinLoadSettings
+     * \return The data set of the concatenated files, or one data set per file
+    */
+    std::vector<mv::Dataset<Points>> loadFiles(const QStringList& fileNames, const BinLoadSettings& settings = BinLoadSettings());
+
+    /*! Load a file without the dialog, see loadFiles
+     *
+     * \param fileName File to load
+     * \param elementType Element type of a raw file, unset reads it from the description next to the file
+     * \param numDimensions Number of dimensions of a raw file, 0 reads it from the description next to the file
+     * \param storeAs PointData element type of the data set, empty stores the data as it is in the file
+     * \return The data set of the file
+    */
+    mv::Dataset<Points> loadFile(const QString& fileName, std::optional<ElementType> elementType = std::nullopt, std::int32_t numDimensions = 0, const QString& storeAs = QString());
 };
 
 